@@ -0,0 +1,181 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Arena allocator for the memory of a game. A game's board, player table, name
+ * table, ranking and other growable arrays are bump-allocated from blocks its
+ * arena owns, so setting a game up costs a few pointer bumps instead of a
+ * malloc per array, and tearing it down is a single reset however much it
+ * allocated. Arrays that grow are extended in place when they are the latest
+ * allocation and copied otherwise; the space they leave behind is reclaimed
+ * with everything else at the reset.
+ *
+ * A reset keeps the blocks, so a game started over, or a pooled game handed to
+ * a new player (see game_pool in jeopardy.c), allocates nothing from the heap
+ * once its arena has grown to the size of a game. arena_trim caps what an idle
+ * pooled arena holds on to, so one unusually large game does not pin its memory.
+ *
+ * The allocation functions take a NULL arena to mean the heap, so code shared
+ * with callers that own no arena (the benchmarks, for one) works either way.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "arena.h" // Include the arena layout and prototypes.
+#include "util.h"  // Allocation helpers.
+
+// Bytes of a block header, rounded up so the memory after it is aligned
+#define HEADER_SIZE ((sizeof(arena_block) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// Rounds a size up to the alignment of every allocation.
+static size_t align_size(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Returns the memory of a block.
+static char *block_memory(arena_block *b) {
+    return (char *)b + HEADER_SIZE;
+}
+
+// Initializes an arena that holds no memory yet.
+void arena_init(arena *a) {
+    a->first = a->current = NULL;
+    a->next = a->end = NULL;
+}
+
+// Makes a block the one allocations are taken from.
+static void use_block(arena *a, arena_block *b) {
+    a->current = b;
+    a->next = block_memory(b);
+    a->end = a->next + b->size;
+}
+
+/**
+ * Moves on to a block with at least size bytes free: the next of the blocks
+ * kept from before the last reset that is large enough, or a new one twice the
+ * size of the last, inserted after the current block.
+ */
+static void next_block(arena *a, size_t size) {
+    arena_block *b = a->current != NULL ? a->current->next : a->first;
+    while (b != NULL && b->size < size) {
+        b = b->next;
+    }
+
+    if (b == NULL) {
+        size_t block_size = a->current != NULL ? a->current->size * 2 : ARENA_BLOCK;
+        while (block_size < size) {
+            block_size *= 2;
+        }
+        b = xmalloc(HEADER_SIZE + block_size);
+        b->size = block_size;
+        if (a->current != NULL) {
+            b->next = a->current->next;
+            a->current->next = b;
+        } else {
+            b->next = a->first;
+            a->first = b;
+        }
+    }
+    use_block(a, b);
+}
+
+/**
+ * Allocates memory from an arena. The memory lives until the arena is reset.
+ *
+ * @param a The arena, or NULL to allocate from the heap.
+ * @param size Bytes to allocate.
+ * @return The memory, aligned to ARENA_ALIGN.
+ */
+void *arena_alloc(arena *a, size_t size) {
+    if (a == NULL) return xmalloc(size);
+
+    size = align_size(size ? size : 1);
+    if ((size_t)(a->end - a->next) < size) next_block(a, size);
+
+    void *p = a->next;
+    a->next += size;
+    return p;
+}
+
+// Allocates zeroed memory from an arena, or from the heap if a is NULL.
+void *arena_calloc(arena *a, size_t count, size_t size) {
+    if (a == NULL) return xcalloc(count, size);
+
+    void *p = arena_alloc(a, count * size);
+    memset(p, 0, count * size);
+    return p;
+}
+
+/**
+ * Resizes an allocation. The latest allocation of the arena grows in place
+ * while its block has room; any other is copied to new memory.
+ *
+ * @param a The arena, or NULL if p came from the heap.
+ * @param p The allocation, or NULL for none.
+ * @param old_size Its size in bytes.
+ * @param size The size it needs.
+ * @return The resized allocation.
+ */
+void *arena_realloc(arena *a, void *p, size_t old_size, size_t size) {
+    if (a == NULL) return xrealloc(p, size);
+    if (p == NULL) return arena_alloc(a, size);
+    if (size <= old_size) return p;
+
+    if ((char *)p + align_size(old_size) == a->next && (size_t)(a->end - (char *)p) >= align_size(size)) {
+        a->next = (char *)p + align_size(size);
+        return p;
+    }
+
+    void *q = arena_alloc(a, size);
+    memcpy(q, p, old_size);
+    return q;
+}
+
+// Frees an allocation made from the heap; arena memory waits for the reset.
+void arena_release(arena *a, void *p) {
+    if (a == NULL) free(p);
+}
+
+// Makes every block of an arena free again, in O(1): allocation starts over from the first.
+void arena_reset(arena *a) {
+    if (a->first != NULL) {
+        use_block(a, a->first);
+    }
+}
+
+/**
+ * Resets an arena, keeping its blocks up to keep bytes and freeing the rest.
+ *
+ * @param a The arena.
+ * @param keep Bytes of blocks to keep; the first block is always kept.
+ */
+void arena_trim(arena *a, size_t keep) {
+    size_t kept = 0;
+    for (arena_block **link = &a->first; *link != NULL;) {
+        arena_block *b = *link;
+        if (b == a->first || kept + b->size <= keep) {
+            kept += b->size;
+            link = &b->next;
+        } else {
+            *link = b->next;
+            free(b);
+        }
+    }
+    a->current = NULL;
+    a->next = a->end = NULL;
+    arena_reset(a);
+}
+
+// Frees every block of an arena, leaving it empty.
+void arena_free(arena *a) {
+    while (a->first != NULL) {
+        arena_block *b = a->first;
+        a->first = b->next;
+        free(b);
+    }
+    arena_init(a);
+}
@@ -0,0 +1,57 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+#define ARENA_BLOCK 16384       // Smallest block an arena allocates
+#define ARENA_ALIGN 16          // Alignment of every allocation
+#define ARENA_KEEP (1 << 20)    // Bytes of blocks a pooled arena keeps when its game is released
+
+// A block of an arena, followed by its memory
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size;           // Bytes of memory after the header
+} arena_block;
+
+// Bump allocator owning the memory of one game. Allocations are never freed
+// one by one; a reset hands every block back for reuse at once
+typedef struct {
+    arena_block *first;    // Blocks in the order they are filled
+    arena_block *current;  // Block being allocated from, NULL before the first allocation
+    char *next;            // Free memory of the current block
+    char *end;
+} arena;
+
+// Initializes an arena that holds no memory yet
+extern void arena_init(arena *a);
+
+// Allocates memory from an arena, or from the heap if a is NULL
+extern void *arena_alloc(arena *a, size_t size);
+
+// Allocates zeroed memory from an arena, or from the heap if a is NULL
+extern void *arena_calloc(arena *a, size_t count, size_t size);
+
+// Resizes an allocation of old_size bytes, in place when it is the arena's
+// latest, or on the heap if a is NULL
+extern void *arena_realloc(arena *a, void *p, size_t old_size, size_t size);
+
+// Frees an allocation made from the heap (a is NULL); arena memory is only
+// reclaimed by a reset
+extern void arena_release(arena *a, void *p);
+
+// Makes every block of an arena free again, in O(1)
+extern void arena_reset(arena *a);
+
+// Resets an arena and frees its blocks beyond the first keep bytes
+extern void arena_trim(arena *a, size_t keep);
+
+// Frees every block of an arena
+extern void arena_free(arena *a);
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,565 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Benchmark harness, run with make bench. Microbenchmarks time the functions on
+ * the command path (tokenize, trim, stringToLower, normalize_text,
+ * normalize_answer, edit_distance, valid_answer, already_answered,
+ * search_questions, draw_board, game_acquire, player_exists, update_score, show_results, events_record) on synthetic boards of 12 to 1M
+ * questions and registries of 4 to 100k players, and an
+ * end-to-end run feeds generated command scripts through game_line.
+ *
+ * Each benchmark is calibrated so a sample takes about SAMPLE_NS, then timed
+ * over SAMPLES samples. The result is one JSON object per line on stdout, with
+ * the mean and percentile nanoseconds per operation and the allocations and
+ * bytes allocated per operation, so runs of different builds can be compared
+ * line by line. Allocations are counted by wrapping malloc, calloc and realloc
+ * at link time (see the Makefile), which covers every allocation made by the
+ * game's own code.
+ *
+ * Usage: bench [-f filter] [-m max scale]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "questions.h" // The bank, board and answer functions under test.
+#include "match.h"     // Answer normalization and edit distance.
+#include "search.h"    // The search index under test.
+#include "deck.h"      // Board drawing under test.
+#include "players.h"   // The player registry under test.
+#include "jeopardy.h"  // The tokenizer and game engine under test.
+#include "events.h"    // The event export under test.
+#include "util.h"      // Allocation helpers and the monotonic clock.
+
+#define SAMPLES 101           // Timed samples per benchmark
+#define SAMPLE_NS 200000      // Target duration of a sample
+#define RANDOM_KEYS 4096      // Random operands drawn per benchmark, used in turn
+#define QUESTIONS_PER_CATEGORY 4
+
+// Allocation counters, bumped by the malloc wrappers
+static long allocations;
+static long allocated_bytes;
+
+extern void *__real_malloc(size_t size);
+extern void *__real_calloc(size_t count, size_t size);
+extern void *__real_realloc(void *p, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    allocated_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    allocated_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+    allocations++;
+    allocated_bytes += size;
+    return __real_realloc(p, size);
+}
+
+// A benchmark body: performs the operation iterations times
+typedef void (*bench_fn)(void *ctx, long iterations);
+
+// Benchmarks to run and the largest scale to run them at
+static const char *filter;
+static long max_scale = 1000000;
+static FILE *devnull;
+
+// Returns the next number of a xorshift64 generator.
+static uint64_t next_random(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Times a benchmark and prints its result as a JSON line: the number of
+ * operations timed, the mean, minimum and percentile ns/op over the samples,
+ * and the allocations and bytes allocated per operation.
+ *
+ * @param name The name of the benchmark.
+ * @param scale The size of the data it runs on (questions or players).
+ * @param fn The benchmark body.
+ * @param ctx Passed to fn.
+ */
+static void run_bench(const char *name, long scale, bench_fn fn, void *ctx) {
+    if (filter != NULL && strstr(name, filter) == NULL) return;
+
+    // Calibrate: double the batch until a sample takes long enough.
+    long batch = 1;
+    for (;;) {
+        uint64_t start = monotonic_ns();
+        fn(ctx, batch);
+        if (monotonic_ns() - start >= SAMPLE_NS || batch >= (1L << 30)) break;
+        batch *= 2;
+    }
+
+    double samples[SAMPLES];
+    uint64_t total = 0;
+    long start_allocations = allocations, start_bytes = allocated_bytes;
+    for (int i = 0; i < SAMPLES; i++) {
+        uint64_t start = monotonic_ns();
+        fn(ctx, batch);
+        uint64_t elapsed = monotonic_ns() - start;
+        total += elapsed;
+        samples[i] = (double)elapsed / batch;
+    }
+    long ops = batch * SAMPLES;
+    qsort(samples, SAMPLES, sizeof(double), compare_doubles);
+
+    printf("{\"bench\":\"%s\",\"scale\":%ld,\"ops\":%ld,\"ns_per_op\":%.2f,\"min\":%.2f,"
+           "\"p50\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"allocs_per_op\":%.4f,\"bytes_per_op\":%.1f}\n",
+           name, scale, ops, (double)total / ops, samples[0], samples[SAMPLES / 2],
+           samples[SAMPLES * 90 / 100], samples[SAMPLES * 99 / 100],
+           (double)(allocations - start_allocations) / ops, (double)(allocated_bytes - start_bytes) / ops);
+    fflush(stdout);
+}
+
+/**
+ * Generates a bank of n questions in categories of QUESTIONS_PER_CATEGORY, worth
+ * 100 to 400, written as TSV to a temporary file and loaded like any bank.
+ *
+ * @return 0 on success or -1 on error.
+ */
+static int generate_bank(long n) {
+    char path[] = "/tmp/jeopardy-bench-XXXXXX";
+    int fd = mkstemp(path);
+    FILE *fp = fd == -1 ? NULL : fdopen(fd, "w");
+    if (fp == NULL) {
+        perror("bench bank");
+        return -1;
+    }
+
+    for (long i = 0; i < n; i++) {
+        long c = i / QUESTIONS_PER_CATEGORY;
+        int value = (i % QUESTIONS_PER_CATEGORY + 1) * 100;
+        fprintf(fp, "category%ld\t%d\tQuestion %ld of category %ld\tAnswer %ld\n", c, value, i, c, i);
+    }
+    fclose(fp);
+
+    int loaded = load_questions(path);
+    unlink(path);
+    return loaded == n ? 0 : -1;
+}
+
+// Fills a registry with n players named player0, player1, ...
+static void generate_players(player_registry *r, long n) {
+    char name[32];
+    init_players(r, NULL);
+    for (long i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "player%ld", i);
+        add_player(r, name);
+    }
+}
+
+// Operands shared by the microbenchmarks
+typedef struct {
+    int keys[RANDOM_KEYS];     // Random question or player handles
+    char names[RANDOM_KEYS][32]; // Names of the players in keys
+    long next;
+    board_state board;
+    player_registry players;
+} bench_data;
+
+// tokenize on a typical pick command; the line is restored before each call.
+static void bench_tokenize(void *ctx, long iterations) {
+    static const char command[] = "pick databases 100 User1";
+    char line[sizeof(command)];
+    token tokens[MAX_TOKENS];
+    long count = 0;
+    (void)ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        memcpy(line, command, sizeof(command));
+        count += tokenize(line, tokens, MAX_TOKENS);
+    }
+    if (count == 0) fputc('\n', devnull); // Keep the calls from being optimized away
+}
+
+// trim on an answer padded with whitespace.
+static void bench_trim(void *ctx, long iterations) {
+    static const char answer[] = "   what is a linked list  \t\n";
+    char line[sizeof(answer)];
+    long count = 0;
+    (void)ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        memcpy(line, answer, sizeof(answer));
+        count += trim(line)[0];
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// stringToLower on a mixed-case answer.
+static void bench_lower(void *ctx, long iterations) {
+    static const char answer[] = "What Is The Quick Sort Algorithm";
+    char line[sizeof(answer)];
+    long count = 0;
+    (void)ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        memcpy(line, answer, sizeof(answer));
+        stringToLower(line);
+        count += line[0];
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// normalize_answer on a response with punctuation, extra spaces and an article.
+static void bench_normalize(void *ctx, long iterations) {
+    static const char answer[] = "  The Quick-Sort   Algorithm (in place!)  ";
+    char normalized[MAX_LEN];
+    long count = 0;
+    (void)ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        count += normalize_answer(answer, sizeof(answer) - 1, normalized);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// normalize_text on a typical response: words separated by single spaces.
+static void bench_normalize_plain(void *ctx, long iterations) {
+    static const char answer[] = "What is the Quick Sort algorithm invented by Tony Hoare";
+    char normalized[MAX_LEN];
+    long count = 0;
+    (void)ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        count += normalize_text(answer, sizeof(answer) - 1, normalized);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// edit_distance between a long answer and a response with three typos, the worst case of the typo fallback.
+static void bench_edit_distance(void *ctx, long iterations) {
+    static const char answer[] = "the quick brown fox jumps over the lazy dog while the five boxing wizards "
+                                 "jump quickly and a wizard quickly jinxes the gnomes before they vaporize "
+                                 "sphinx of black quartz judge my vow";
+    static const char response[] = "the quick brown fox jumps over the lazy dgo while the five boxing wizards "
+                                   "jump quickly and a wizard quickly jinxes the gnomes before they vaporise "
+                                   "sphinx of black quartz judge my vow";
+    long count = 0;
+    (void)ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        count += edit_distance(answer, sizeof(answer) - 1, response, sizeof(response) - 1, MATCH_MAX_TYPOS);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// valid_answer with the correct answer to a random question.
+static void bench_valid_answer(void *ctx, long iterations) {
+    bench_data *d = ctx;
+    char answer[MAX_LEN];
+    long count = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        int q = d->keys[d->next++ % RANDOM_KEYS];
+        strcpy(answer, question_answer(q));
+        count += valid_answer(q, answer);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// already_answered on random questions of a half-answered board.
+static void bench_already_answered(void *ctx, long iterations) {
+    bench_data *d = ctx;
+    long count = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        count += already_answered(&d->board, d->keys[d->next++ % RANDOM_KEYS]);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// search_questions for a random category number together with a word every
+// question contains, so the number's short list is intersected with one of n postings.
+static void bench_search(void *ctx, long iterations) {
+    bench_data *d = ctx;
+    char query[64];
+    int32_t results[SEARCH_RESULTS];
+    long count = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        snprintf(query, sizeof(query), "question %d", d->keys[d->next++ % RANDOM_KEYS] / QUESTIONS_PER_CATEGORY);
+        count += search_questions(query, results, SEARCH_RESULTS);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// search_questions for the questions whose numbers start with the first two
+// digits of a random one, a prefix matching up to a tenth of the bank's terms.
+static void bench_search_prefix(void *ctx, long iterations) {
+    bench_data *d = ctx;
+    char query[64];
+    int32_t results[SEARCH_RESULTS];
+    long count = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        snprintf(query, sizeof(query), "answer %d*", d->keys[d->next++ % RANDOM_KEYS] % 90 + 10);
+        count += search_questions(query, results, SEARCH_RESULTS);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// draw_board of a 6-category board (fewer on the smallest bank), dealt over and over.
+static void bench_draw_board(void *ctx, long iterations) {
+    bench_data *d = ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        draw_board(&d->board);
+    }
+}
+
+// A game taken from a pool, joined by four players and handed back.
+static void bench_game_acquire(void *ctx, long iterations) {
+    static const game_rules rules = { false, 0, 0, 0 };
+    game_pool *pool = ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        game *g = game_acquire(pool, devnull, false, &rules);
+        game_join(g, "alice");
+        game_join(g, "bob");
+        game_join(g, "carol");
+        game_join(g, "dave");
+        game_release(pool, g);
+    }
+}
+
+// player_exists on the names of random players.
+static void bench_player_exists(void *ctx, long iterations) {
+    bench_data *d = ctx;
+    long count = 0;
+
+    for (long i = 0; i < iterations; i++) {
+        count += player_exists(&d->players, d->names[d->next++ % RANDOM_KEYS]);
+    }
+    if (count == 0) fputc('\n', devnull);
+}
+
+// update_score of random players, alternately gaining and losing points.
+static void bench_update_score(void *ctx, long iterations) {
+    bench_data *d = ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        long n = d->next++;
+        update_score(&d->players, d->keys[n % RANDOM_KEYS], n & 1 ? -100 : 200);
+    }
+}
+
+// show_results of the whole registry, written to /dev/null.
+static void bench_show_results(void *ctx, long iterations) {
+    bench_data *d = ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        show_results(devnull, &d->players);
+    }
+}
+
+// A generated command script and the game it is replayed into
+typedef struct {
+    char *script;              // Lines separated by NULs, kept pristine
+    size_t *lines;             // Offset of each line in script
+    long num_lines;
+    long num_joins;            // The script starts with this many join lines
+    long next;
+    char buffer[MAX_LEN * 2];
+    game g;
+} script_run;
+
+/**
+ * Generates a script that plays a whole board: joins for the players, then a
+ * pick of every question in random order, each followed by its answer (right
+ * half of the time) and now and then a rank query.
+ */
+static void generate_script(script_run *run, int players, uint64_t *rng) {
+    long n = bank.num_questions;
+    size_t capacity = 64 * (n + players) + 1024, size = 0;
+    run->script = xmalloc(capacity);
+    run->lines = xmalloc((3 * n + players) * sizeof(size_t));
+    run->num_lines = 0;
+    run->num_joins = players;
+
+#define ADD_LINE(...)                                                                          \
+    do {                                                                                       \
+        if (capacity - size < MAX_LEN * 2) run->script = xrealloc(run->script, capacity *= 2); \
+        run->lines[run->num_lines++] = size;                                                   \
+        size += snprintf(run->script + size, MAX_LEN * 2, __VA_ARGS__) + 1;                   \
+    } while (0)
+
+    for (int p = 0; p < players; p++) {
+        ADD_LINE("join player%d", p);
+    }
+
+    int *order = xmalloc(n * sizeof(int));
+    for (long q = 0; q < n; q++) order[q] = q;
+    for (long q = n - 1; q > 0; q--) {
+        long j = next_random(rng) % (q + 1);
+        int t = order[q];
+        order[q] = order[j];
+        order[j] = t;
+    }
+
+    for (long i = 0; i < n; i++) {
+        int q = order[i];
+        int p = next_random(rng) % players;
+        ADD_LINE("pick %s %d player%d", category_name(bank.questions[q].category), bank.questions[q].value, p);
+        ADD_LINE("What is %s", next_random(rng) & 1 ? question_answer(q) : "something else");
+        if (i % 8 == 0) ADD_LINE("rank player%d", p);
+    }
+#undef ADD_LINE
+
+    free(order);
+}
+
+// Replays lines of the script through game_line, starting the game over at its end.
+static void bench_script(void *ctx, long iterations) {
+    script_run *run = ctx;
+
+    for (long i = 0; i < iterations; i++) {
+        if (run->next == run->num_lines) {
+            game_reset(&run->g);
+            run->next = 0;
+        }
+        const char *line = run->script + run->lines[run->next++];
+        strcpy(run->buffer, line);
+        game_line(&run->g, run->buffer);
+    }
+}
+
+// events_record of answers by four players across six categories, appended to /dev/null a chunk at a time.
+static void bench_events_record(void *ctx, long iterations) {
+    static const char *categories[] = { "history", "science", "sports", "music", "movies", "geography" };
+    static const char *players[] = { "alice", "bob", "carol", "dave" };
+    (void)ctx;
+
+    uint64_t start = monotonic_ns();
+    for (long i = 0; i < iterations; i++) {
+        events_record(i & 1 ? EVENT_CORRECT : EVENT_INCORRECT, i / 32, categories[i % 6], (i % 5 + 1) * 100,
+                      players[i & 3], i & 1 ? 100 : 0, start);
+    }
+}
+
+// Runs the benchmarks that depend on the size of the bank.
+static void bench_questions(long n, uint64_t *rng) {
+    if (generate_bank(n) != 0) {
+        fprintf(stderr, "Could not generate a bank of %ld questions\n", n);
+        return;
+    }
+
+    bench_data *d = xcalloc(1, sizeof(bench_data));
+    init_board(&d->board, NULL);
+    for (long q = 0; q < n; q += 2) mark_answered(&d->board, q);
+    for (int i = 0; i < RANDOM_KEYS; i++) d->keys[i] = next_random(rng) % n;
+
+    run_bench("valid_answer", n, bench_valid_answer, d);
+    run_bench("already_answered", n, bench_already_answered, d);
+    if (filter == NULL || strstr("search_prefix", filter) != NULL) {
+        build_search_index();
+        run_bench("search", n, bench_search, d);
+        run_bench("search_prefix", n, bench_search_prefix, d);
+        free_search_index();
+    }
+    long categories = n / QUESTIONS_PER_CATEGORY;
+    if (build_deck(categories < 6 ? categories : 6, QUESTIONS_PER_CATEGORY) == 0) {
+        game_pool pool;
+        game_pool_init(&pool);
+        run_bench("draw_board", n, bench_draw_board, d);
+        run_bench("game_acquire", n, bench_game_acquire, &pool);
+        game_pool_free(&pool);
+        free_deck();
+    }
+    free_board(&d->board);
+    free(d);
+
+    if (filter == NULL || strstr("game_line", filter) != NULL) {
+        script_run *run = xcalloc(1, sizeof(script_run));
+        game_rules rules = { false, 0, 0, 0 };
+        generate_script(run, 4, rng);
+        game_init(&run->g, devnull, false, &rules);
+        run_bench("game_line", n, bench_script, run);
+        game_free(&run->g);
+        free(run->script);
+        free(run->lines);
+        free(run);
+    }
+}
+
+// Runs the benchmarks that depend on the number of players.
+static void bench_players(long n, uint64_t *rng) {
+    bench_data *d = xcalloc(1, sizeof(bench_data));
+    generate_players(&d->players, n);
+    for (int i = 0; i < RANDOM_KEYS; i++) {
+        d->keys[i] = next_random(rng) % n;
+        snprintf(d->names[i], sizeof(d->names[i]), "player%d", d->keys[i]);
+    }
+
+    run_bench("player_exists", n, bench_player_exists, d);
+    run_bench("update_score", n, bench_update_score, d);
+    run_bench("show_results", n, bench_show_results, d);
+    free_players(&d->players);
+    free(d);
+}
+
+int main(int argc, char *argv[]) {
+    static const long question_scales[] = { 12, 1000, 100000, 1000000 };
+    static const long player_scales[] = { 4, 100, 10000, 100000 };
+    uint64_t rng = 0x9e3779b97f4a7c15u;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:m:")) != -1) {
+        if (opt == 'f') {
+            filter = optarg;
+        } else if (opt == 'm' && atol(optarg) > 0) {
+            max_scale = atol(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-f filter] [-m max scale]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    devnull = fopen("/dev/null", "w");
+    if (devnull == NULL) {
+        perror("/dev/null");
+        return EXIT_FAILURE;
+    }
+
+    run_bench("tokenize", 1, bench_tokenize, NULL);
+    run_bench("trim", 1, bench_trim, NULL);
+    run_bench("stringToLower", 1, bench_lower, NULL);
+    run_bench("normalize_text", 1, bench_normalize_plain, NULL);
+    run_bench("normalize_answer", 1, bench_normalize, NULL);
+    run_bench("edit_distance", 1, bench_edit_distance, NULL);
+    if (events_open("/dev/null") == 0) {
+        run_bench("events_record", 1, bench_events_record, NULL);
+        events_close();
+    }
+
+    for (size_t i = 0; i < sizeof(question_scales) / sizeof(question_scales[0]); i++) {
+        if (question_scales[i] <= max_scale) bench_questions(question_scales[i], &rng);
+    }
+    for (size_t i = 0; i < sizeof(player_scales) / sizeof(player_scales[0]); i++) {
+        if (player_scales[i] <= max_scale) bench_players(player_scales[i], &rng);
+    }
+
+    fclose(devnull);
+    return EXIT_SUCCESS;
+}
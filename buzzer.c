@@ -0,0 +1,133 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Arrival queue of a buzzer round. Players press from any number of threads at
+ * once; each press is stamped with the monotonic clock before it is queued and
+ * takes a slot of a bounded ring with a single compare-and-swap, so pressing
+ * never blocks and never waits for the game. The game thread is the only
+ * consumer: it drains what has arrived and orders it by timestamp, which keeps
+ * the order fair even when presses race for slots in a different order than
+ * they were made.
+ *
+ * Every slot carries a sequence number (the ring position it is free for, plus
+ * one once it holds a buzz), so producers and the consumer agree on ownership of
+ * a slot without locks.
+ */
+#include "buzzer.h" // Include the buzz queue structures and prototypes.
+
+/**
+ * Initializes an empty, closed queue.
+ *
+ * @param q The queue to initialize.
+ */
+void buzz_init(buzz_queue *q) {
+    for (uint32_t i = 0; i < BUZZ_CAPACITY; i++) {
+        atomic_init(&q->slots[i].sequence, i);
+    }
+    atomic_init(&q->head, 0);
+    atomic_init(&q->round, 0);
+    q->tail = 0;
+    q->last_round = 0;
+}
+
+/**
+ * Opens a new round. Buzzes still queued from earlier rounds are dropped when
+ * they are drained, since they carry an older round number.
+ *
+ * @param q The queue.
+ */
+void buzz_open(buzz_queue *q) {
+    if (++q->last_round == 0) q->last_round = 1; // 0 means closed
+    atomic_store_explicit(&q->round, q->last_round, memory_order_release);
+}
+
+// Closes the open round; presses from now on are rejected.
+void buzz_close(buzz_queue *q) {
+    atomic_store_explicit(&q->round, 0, memory_order_release);
+}
+
+/**
+ * Records a buzz in the open round. Safe to call from any thread, concurrently
+ * with other presses and with the consumer; it never blocks.
+ *
+ * @param q The queue.
+ * @param player The handle of the player who pressed.
+ * @param time When the player pressed, from monotonic_ns.
+ * @return true if the buzz was queued, false if no round is open or the queue is full.
+ */
+bool buzz_press(buzz_queue *q, int player, uint64_t time) {
+    uint32_t round = atomic_load_explicit(&q->round, memory_order_acquire);
+    if (round == 0) return false;
+
+    uint32_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    for (;;) {
+        buzz_slot *slot = &q->slots[pos & (BUZZ_CAPACITY - 1)];
+        uint32_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            // The slot is free for this position; claim it.
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->round = round;
+                slot->entry.player = player;
+                slot->entry.time = time;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                return true;
+            }
+            // pos was reloaded by the failed exchange
+        } else if (diff < 0) {
+            return false; // The consumer has not freed this slot yet: the queue is full
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+}
+
+
+/**
+ * Moves the buzzes of the open round that have arrived into out, ordered by the
+ * time they were pressed. Stops at the first slot still being written, so a
+ * press is never lost, only picked up by the next drain. Only the game thread
+ * may drain a queue.
+ *
+ * @param q The queue.
+ * @param out Receives the buzzes.
+ * @param max The capacity of out.
+ * @return The number of buzzes moved into out.
+ */
+int buzz_drain(buzz_queue *q, buzz *out, int max) {
+    uint32_t round = atomic_load_explicit(&q->round, memory_order_relaxed);
+    int count = 0;
+
+    while (count < max) {
+        buzz_slot *slot = &q->slots[q->tail & (BUZZ_CAPACITY - 1)];
+        uint32_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (seq != q->tail + 1) break; // Empty, or still being written
+
+        if (round != 0 && slot->round == round) {
+            out[count++] = slot->entry;
+        }
+
+        // Hand the slot back to producers for its next lap around the ring.
+        atomic_store_explicit(&slot->sequence, q->tail + BUZZ_CAPACITY, memory_order_release);
+        q->tail++;
+    }
+
+    // An insertion sort: batches are small and nearly in order already, and being
+    // stable it keeps buzzes with equal timestamps in the order they were queued.
+    for (int i = 1; i < count; i++) {
+        buzz b = out[i];
+        int j = i;
+        while (j > 0 && out[j - 1].time > b.time) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = b;
+    }
+
+    return count;
+}
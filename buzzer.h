@@ -0,0 +1,56 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef BUZZER_H_
+#define BUZZER_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BUZZ_CAPACITY 64 // Buzzes that can wait to be drained (a power of two)
+
+// A buzz: who pressed and when, by the monotonic clock in nanoseconds
+typedef struct {
+    int player;
+    uint64_t time;
+} buzz;
+
+// Slot of the arrival queue; sequence tells producers and the consumer whose turn it is
+typedef struct {
+    atomic_uint sequence;
+    uint32_t round;        // Round the buzz was pressed in
+    buzz entry;
+} buzz_slot;
+
+// Lock-free arrival queue of buzzes: any number of threads press concurrently
+// and the game thread drains the buzzes of the open round in time order
+typedef struct {
+    buzz_slot slots[BUZZ_CAPACITY];
+    atomic_uint head;      // Next position claimed by a producer
+    atomic_uint round;     // Number of the open round, 0 while closed
+    uint32_t tail;         // Next position read by the consumer
+    uint32_t last_round;   // Number of the most recently opened round
+} buzz_queue;
+
+// Initializes an empty, closed queue
+extern void buzz_init(buzz_queue *q);
+
+// Opens a new round, discarding the buzzes of earlier rounds (consumer only)
+extern void buzz_open(buzz_queue *q);
+
+// Closes the open round; later presses are rejected (consumer only)
+extern void buzz_close(buzz_queue *q);
+
+// Records a buzz in the open round from any thread; returns false if no round
+// is open or the queue is full
+extern bool buzz_press(buzz_queue *q, int player, uint64_t time);
+
+// Moves the buzzes of the open round into out, at most max, ordered by time;
+// returns how many were moved (consumer only)
+extern int buzz_drain(buzz_queue *q, buzz *out, int max);
+
+#endif /* BUZZER_H_ */
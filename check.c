@@ -0,0 +1,331 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Regression checks, run with make check. Most checks write a small question
+ * bank to a temporary file, load it with load_questions and look up, answer or
+ * search for what it should hold; the journal check plays a game, reopens its
+ * journal and compares the recovered game, and the buzzer check races player
+ * threads to buzz in. One line is printed per check, and the program exits with
+ * failure if any check fails.
+ *
+ * Usage: check
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "questions.h" // The bank loader under test.
+#include "search.h"    // The search index under test.
+#include "match.h"     // The answer matching under test.
+#include "jeopardy.h"  // Games recorded in and recovered from a journal.
+#include "journal.h"   // The journal under test.
+#include "deck.h"      // Drawn boards, whose resets are journaled.
+#include "util.h"      // The monotonic clock buzzes are stamped with.
+
+static int failures;
+
+// Writes a bank to a temporary file and loads it, returning what load_questions returned.
+static int load_text(const char *text) {
+    char path[] = "/tmp/jeopardy-check-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror(path);
+        return -1;
+    }
+    if (write(fd, text, strlen(text)) != (ssize_t)strlen(text)) perror(path);
+    close(fd);
+
+    int loaded = load_questions(path);
+    unlink(path);
+    return loaded;
+}
+
+// Reports a check, counting it if it failed.
+static void expect(const char *name, bool ok) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+    if (!ok) failures++;
+}
+
+// A TSV bank whose first lines are a comment and a blank line is still read as TSV.
+static void check_tsv_after_comment(void) {
+    int loaded = load_text("# my bank\n\nscience\t100\tThe red planet\tMars\nscience\t200\tThe closest star\tthe Sun\n");
+    expect("tsv after comment", loaded == 2 && find_question("science", 200) != -1);
+}
+
+// A header row after a comment is skipped, not reported as malformed.
+static void check_header_after_comment(void) {
+    int loaded = load_text("# exported bank\ncategory\tvalue\tquestion\tanswer\nhistory\t100\tFirst president\tWashington\n");
+    expect("header after comment", loaded == 1 && find_question("history", 100) != -1);
+}
+
+// A CSV bank, quoted fields included, is still read as CSV.
+static void check_csv(void) {
+    int loaded = load_text("category,value,question,answer\nmath,100,\"Two, plus two\",4\n");
+    expect("csv", loaded == 1 && find_question("math", 100) != -1);
+}
+
+// Values parse in full up to INT_MAX, and anything else is refused rather than cut short.
+static void check_values(void) {
+    expect("value", parse_value("$1000000000", 11) == 1000000000);
+    expect("value too large", parse_value("10000000000", 11) == -1 && parse_value("2147483648", 10) == -1);
+    expect("value not a number", parse_value("12x", 3) == -1 && parse_value("$", 1) == -1);
+}
+
+// Responses match an accepted answer whatever their accents, articles and
+// punctuation, or a second alias, and within a typo of a long answer, but a
+// year is only right to the digit.
+static void check_answers(void) {
+    load_text("geo\t100\tCapital of France\tPar\xc3\xads\n"
+              "geo\t200\tLargest ocean\tthe Pacific Ocean|Pacific\n"
+              "geo\t300\tSea south of Europe\tthe Mediterranean Sea\n"
+              "history\t100\tThe Berlin Wall fell\t1989\n");
+    int paris = find_question("geo", 100), pacific = find_question("geo", 200);
+    int sea = find_question("geo", 300), year = find_question("history", 100);
+
+    char normalized[MAX_LEN];
+    const char *response = "  The  PAR\xc3\x8dS!";
+    size_t len = normalize_answer(response, strlen(response), normalized);
+    expect("normalize answer", len == 5 && memcmp(normalized, "paris", 5) == 0);
+
+    expect("accented answer", valid_answer(paris, "paris") && valid_answer(paris, "Par\xc3\xads"));
+    expect("stray article", valid_answer(pacific, "Pacific Ocean") && valid_answer(pacific, "a pacific ocean"));
+    expect("punctuation", valid_answer(pacific, "pacific-ocean!!") && valid_answer(paris, "\"Paris?\""));
+    expect("second alias", valid_answer(pacific, "the Pacific") && !valid_answer(pacific, "Atlantic"));
+    expect("typo in a long answer", valid_answer(sea, "Mediteranean Sea") && !valid_answer(sea, "Caribbean Sea"));
+    expect("no typo in a year", valid_answer(year, "1989") && !valid_answer(year, "1988") &&
+                                typo_tolerance("1989", 4) == 0);
+    expect("edit distance", edit_distance("kitten", 6, "sitting", 7, 5) == 3 &&
+                            edit_distance("kitten", 6, "sitting", 7, 1) == 2);
+}
+
+// Searching finds questions by their text and category, never by their answers.
+static void check_search_hides_answers(void) {
+    int32_t results[4];
+    load_text("planets\t100\tThe red planet\tMars\n");
+    build_search_index();
+    expect("search by text", search_questions("red", results, 4) == 1);
+    expect("search by category", search_questions("planets", results, 4) == 1);
+    expect("search hides answers", search_questions("mars", results, 4) == 0);
+    free_search_index();
+}
+
+// Plays a game line, as game_line tokenizes its line in place.
+static void play(game *g, const char *text) {
+    char line[256];
+    snprintf(line, sizeof(line), "%s\n", text);
+    game_line(g, line);
+}
+
+// Picks the first unanswered question of a drawn board and answers it correctly.
+static void answer_first(game *g, const char *player) {
+    for (uint32_t i = 0; i < g->board.num_cells; i++) {
+        int q = g->board.cells[i];
+        if (already_answered(&g->board, q)) continue;
+
+        char line[256];
+        snprintf(line, sizeof(line), "pick %s %d %s", category_name(bank.questions[q].category),
+                 bank.questions[q].value, player);
+        play(g, line);
+        snprintf(line, sizeof(line), "what is %s", question_answer(q));
+        play(g, line);
+        return;
+    }
+}
+
+// Returns true if two games have the same players, scores and board.
+static bool same_game(const game *a, const game *b) {
+    if (a->players.num_players != b->players.num_players) return false;
+    for (int p = 0; p < a->players.num_players; p++) {
+        if (strcmp(player_name(&a->players, p), player_name(&b->players, p)) != 0) return false;
+        if (a->players.players[p].score != b->players.players[p].score) return false;
+    }
+
+    if (a->board.num_cells != b->board.num_cells) return false;
+    for (uint32_t i = 0; i < a->board.num_cells; i++) {
+        int q = a->board.cells[i];
+        if (b->board.cells[i] != q || already_answered(&a->board, q) != already_answered(&b->board, q)) return false;
+    }
+    return questions_remaining(&a->board) == questions_remaining(&b->board);
+}
+
+// Returns true if no question of one board is on another.
+static bool disjoint_boards(const board_state *a, const board_state *b) {
+    for (uint32_t i = 0; i < a->num_cells; i++) {
+        if (on_board(b, a->cells[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * A journaled game on drawn boards, reset part way, is recovered as it was
+ * played. The deck deals two boards of both categories before it reshuffles,
+ * so if replaying the reset leaves the deck alone, the board drawn after the
+ * recovery holds exactly the questions the recovering game was not dealt.
+ */
+static void check_journal_recovery(void) {
+    char dir[] = "/tmp/jeopardy-check-XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+        perror(dir);
+        expect("journal recovery", false);
+        return;
+    }
+    char path[64], snapshot[64];
+    snprintf(path, sizeof(path), "%s/journal", dir);
+    snprintf(snapshot, sizeof(snapshot), "%s/journal.snap", dir);
+
+    load_text("art\t100\tA\ta\nart\t200\tB\tb\nlaw\t100\tC\tc\nlaw\t200\tD\td\n");
+    build_deck(2, 1);
+    game_rules rules;
+    memset(&rules, 0, sizeof(rules));
+
+    game played, recovered;
+    journal j;
+    game_init(&played, NULL, false, &rules);
+    bool ok = journal_open(&j, path, bank_fingerprint(), game_apply, &played) == 0;
+    if (ok) {
+        game_attach(&played, &j);
+        play(&played, "join ann");
+        play(&played, "join bob");
+        answer_first(&played, "ann");
+        game_reset(&played);
+        play(&played, "join cat");
+        answer_first(&played, "cat");
+        journal_close(&j);
+        free_deck();
+        build_deck(2, 1);
+
+        board_state dealt, next;
+        memset(&dealt, 0, sizeof(dealt));
+        memset(&next, 0, sizeof(next));
+        game_init(&recovered, NULL, false, &rules);
+        set_board(&dealt, recovered.board.cells, recovered.board.num_cells);
+        ok = journal_open(&j, path, bank_fingerprint(), game_apply, &recovered) > 0;
+        if (ok) {
+            ok = same_game(&played, &recovered) && draw_board(&next) && disjoint_boards(&dealt, &next);
+            journal_close(&j);
+        }
+        free_board(&dealt);
+        free_board(&next);
+        game_free(&recovered);
+    }
+    game_free(&played);
+    expect("journal recovery", ok);
+
+    free_deck();
+    unlink(path);
+    unlink(snapshot);
+    rmdir(dir);
+}
+
+#define RACERS 12                // Player threads buzzing in at once
+#define RACE_ROUNDS 8            // Questions they race for
+#define RACE_SETTLE 20000000ULL  // Nanoseconds a buzz settles for, well past the slowest racer
+#define RACE_LAG 200000ULL       // Nanoseconds between a racer's stamp and its buzz, per place it gives way
+
+// A player thread racing to buzz in, like a connection's reader that stamps a
+// line when it arrives and buzzes once it has been parsed
+typedef struct {
+    game *g;
+    pthread_barrier_t *start;
+    int player;
+    uint64_t lag;  // How long the racer takes between stamping and buzzing
+    uint64_t time; // When the racer stamped its buzz
+} racer;
+
+// Waits for the start, stamps the buzz, and buzzes after the racer's lag.
+static void *race(void *arg) {
+    racer *r = arg;
+    pthread_barrier_wait(r->start);
+    r->time = monotonic_ns();
+    struct timespec lag = { 0, (long)r->lag };
+    nanosleep(&lag, NULL);
+    game_buzz(r->g, r->player, r->time);
+    return NULL;
+}
+
+/**
+ * Buzzes from racing threads get their answer windows in the order they were
+ * stamped, not the order they reached the queue. Each round every racer buzzes
+ * at once, the later racers reaching the queue first, while this thread runs
+ * the game: it grants windows as game_tick and game_poll open them and answers
+ * each one wrong, so the question passes through every racer in turn.
+ */
+static void check_buzz_order(void) {
+    char text[4096] = "", line[256];
+    for (int i = 1; i <= RACE_ROUNDS + 1; i++) {
+        snprintf(line, sizeof(line), "race\t%d\tQuestion %d\tanswer\n", i * 100, i);
+        strcat(text, line);
+    }
+    load_text(text);
+
+    game_rules rules = { true, 0, 0, RACE_SETTLE };
+    game g;
+    game_init(&g, NULL, false, &rules);
+    for (int p = 0; p < RACERS; p++) {
+        snprintf(line, sizeof(line), "join racer%d", p);
+        play(&g, line);
+    }
+
+    bool ok = g.players.num_players == RACERS;
+    for (int round = 1; round <= RACE_ROUNDS && ok; round++) {
+        snprintf(line, sizeof(line), "pick race %d racer0", round * 100);
+        play(&g, line);
+
+        pthread_barrier_t start;
+        pthread_barrier_init(&start, NULL, RACERS + 1);
+        racer racers[RACERS];
+        pthread_t threads[RACERS];
+        for (int p = 0; p < RACERS; p++) {
+            racers[p] = (racer){ &g, &start, p, (uint64_t)(RACERS - p) * RACE_LAG, 0 };
+            pthread_create(&threads[p], NULL, race, &racers[p]);
+        }
+        pthread_barrier_wait(&start);
+
+        // Run the game until every racer has answered, giving up after a second
+        int granted[RACERS], num_granted = 0;
+        uint64_t give_up = monotonic_ns() + 1000000000ULL;
+        while (g.pending_question != -1 && monotonic_ns() < give_up) {
+            game_tick(&g, monotonic_ns());
+            game_poll(&g);
+            if (g.pending_player != -1 && num_granted < RACERS) {
+                granted[num_granted++] = g.pending_player;
+                play(&g, "what is a wrong answer");
+            }
+            struct timespec pause = { 0, 100000 };
+            nanosleep(&pause, NULL);
+        }
+        for (int p = 0; p < RACERS; p++) pthread_join(threads[p], NULL);
+        pthread_barrier_destroy(&start);
+
+        // Every racer is granted once, each stamped no later than the next
+        ok = num_granted == RACERS && g.pending_question == -1;
+        for (int i = 1; i < num_granted && ok; i++) {
+            ok = racers[granted[i - 1]].time <= racers[granted[i]].time;
+        }
+    }
+    game_free(&g);
+    expect("buzz order", ok);
+}
+
+int main(void) {
+    check_tsv_after_comment();
+    check_header_after_comment();
+    check_csv();
+    check_values();
+    check_answers();
+    check_search_hides_answers();
+    check_journal_recovery();
+    check_buzz_order();
+
+    free_questions();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,216 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Random boards drawn from a large bank. A drawn board has a number of
+ * categories picked at random and, from each, one question picked at random
+ * from each of its value tiers: a category's questions sorted by value are
+ * split into as many tiers as the board has rows, so a column always runs from
+ * cheap to dear whatever values the category holds.
+ *
+ * Questions are not repeated across games. The deck keeps a bitset of the
+ * questions dealt since it was last shuffled, one bit per question in the
+ * bank's category order, so the questions of a tier are a contiguous run of
+ * bits. A category that has given a question from each tier to every board
+ * it can fill leaves the pool of fresh categories, which is kept at the front
+ * of the pool array so categories are picked in constant time by swapping
+ * them out (a partial Fisher-Yates shuffle). Only once fewer fresh categories
+ * are left than a board needs is the deck shuffled and every question dealt
+ * again.
+ *
+ * Within a tier a few random positions are probed first, which nearly always
+ * finds an unused question; failing that the unused questions of the tier are
+ * counted word by word and one picked uniformly among them. Drawing a board
+ * therefore takes a few microseconds however many millions of questions the
+ * bank holds. The deck is shared by every game of the bank, so drawing holds
+ * its lock, briefly.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "deck.h"      // Include the deck layout and prototypes of the drawing functions.
+#include "questions.h" // The bank boards are drawn from.
+#include "util.h"      // Allocation helpers and the monotonic clock.
+
+// The calling thread's copy of the deck of its bank.
+_Thread_local board_deck deck;
+
+// What every game dealt from a deck shares
+struct deck_state {
+    pthread_mutex_t lock;
+    uint32_t *pool;        // Categories boards can be drawn from, the fresh ones first
+    uint32_t num_pool;
+    uint32_t fresh;        // pool[0 .. fresh) still has an unused question in every tier
+    uint32_t *dealt;       // Boards each category has been dealt to since the shuffle, by category id
+    uint64_t *used;        // Questions dealt since the shuffle, by position in bank.category_order
+    uint64_t random;       // State of a xorshift64 generator
+};
+
+// Returns a random number below n.
+static uint32_t random_below(struct deck_state *s, uint32_t n) {
+    s->random ^= s->random << 13;
+    s->random ^= s->random >> 7;
+    s->random ^= s->random << 17;
+    return (uint32_t)(((s->random >> 32) * n) >> 32);
+}
+
+// Returns true if a category can be drawn: its name is a single word, so it can
+// be picked, and it has a question of positive value for every row.
+static bool drawable(uint32_t category_id) {
+    int32_t first = bank.category_start[category_id], last = bank.category_start[category_id + 1];
+    if ((uint32_t)(last - first) < deck.rows || bank.questions[bank.category_order[first]].value <= 0) return false;
+
+    const char *name = category_name(category_id);
+    for (const char *c = name; *c; c++) {
+        if (isspace((unsigned char)*c)) return false;
+    }
+    return name[0] != '\0';
+}
+
+// Starts the deck over: every question is unused and every category fresh.
+static void shuffle(struct deck_state *s) {
+    memset(s->used, 0, (bank.num_questions + 63) / 64 * sizeof(uint64_t));
+    memset(s->dealt, 0, bank.num_categories * sizeof(uint32_t));
+    s->fresh = s->num_pool;
+}
+
+// Marks the question at a position of bank.category_order used, returning the position.
+static uint32_t claim(struct deck_state *s, uint32_t p) {
+    s->used[p / 64] |= (uint64_t)1 << (p % 64);
+    return p;
+}
+
+/**
+ * Deals an unused question from a tier, marking it used.
+ *
+ * @param s The deck.
+ * @param lo The first position of the tier in bank.category_order.
+ * @param hi One past its last position.
+ * @param dealt How many questions of the tier have been dealt since the shuffle.
+ * @return The position of the question dealt.
+ */
+static uint32_t deal_tier(struct deck_state *s, uint32_t lo, uint32_t hi, uint32_t dealt) {
+    for (int i = 0; i < DECK_PROBES; i++) {
+        uint32_t p = lo + random_below(s, hi - lo);
+        if (!((s->used[p / 64] >> (p % 64)) & 1)) return claim(s, p);
+    }
+
+    // Mostly used: pick the r-th unused question, counting them a word at a time
+    uint32_t r = random_below(s, hi - lo - dealt);
+    for (uint32_t w = lo / 64; w <= (hi - 1) / 64; w++) {
+        uint64_t unused = ~s->used[w];
+        if (w == lo / 64) unused &= ~(uint64_t)0 << (lo % 64);
+        if (w == (hi - 1) / 64 && hi % 64 != 0) unused &= ((uint64_t)1 << (hi % 64)) - 1;
+
+        uint32_t count = __builtin_popcountll(unused);
+        if (r < count) {
+            while (r-- > 0) unused &= unused - 1;
+            return claim(s, w * 64 + __builtin_ctzll(unused));
+        }
+        r -= count;
+    }
+    return lo; // Not reached while dealt counts the tier's used questions
+}
+
+// Releases the deck; games then play the whole bank.
+void free_deck(void) {
+    struct deck_state *s = deck.state;
+    if (s != NULL) {
+        pthread_mutex_destroy(&s->lock);
+        free(s->pool);
+        free(s->dealt);
+        free(s->used);
+        free(s);
+    }
+    memset(&deck, 0, sizeof(deck));
+}
+
+/**
+ * Sets up drawing boards from the current bank, with every question unused.
+ *
+ * @param columns Categories on a board.
+ * @param rows Value tiers of each category; a category needs at least as many
+ *        questions to be drawn.
+ * @return 0 on success, or -1, leaving no deck, if the bank has fewer than
+ *         columns categories that can be drawn.
+ */
+int build_deck(int columns, int rows) {
+    free_deck();
+    deck.columns = columns;
+    deck.rows = rows;
+
+    struct deck_state *s = xcalloc(1, sizeof(struct deck_state));
+    pthread_mutex_init(&s->lock, NULL);
+    s->pool = xmalloc((bank.num_categories + 1) * sizeof(uint32_t));
+    s->dealt = xcalloc(bank.num_categories + 1, sizeof(uint32_t));
+    s->used = xcalloc((bank.num_questions + 63) / 64 + 1, sizeof(uint64_t));
+    s->random = monotonic_ns() | 1;
+    deck.state = s;
+
+    for (uint32_t c = 0; c < bank.num_categories; c++) {
+        if (drawable(c)) s->pool[s->num_pool++] = c;
+    }
+    s->fresh = s->num_pool;
+
+    if (s->num_pool < deck.columns) {
+        free_deck();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Replaces a board with a freshly drawn one: deck.columns fresh categories,
+ * each with one unused question from each of its deck.rows value tiers.
+ *
+ * @param b The board, released and replaced.
+ * @return true, or false, leaving the board as it was, if boards are not drawn.
+ */
+bool draw_board(board_state *b) {
+    struct deck_state *s = deck.state;
+    if (s == NULL) return false;
+
+    int32_t cells[DECK_MAX_COLUMNS * DECK_MAX_ROWS];
+    uint32_t n = 0;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->fresh < deck.columns) shuffle(s);
+
+    // Each category picked is swapped out past the fresh ones, so none is picked twice
+    uint32_t fresh = s->fresh;
+    for (uint32_t c = 0; c < deck.columns; c++) {
+        uint32_t i = random_below(s, s->fresh);
+        uint32_t category_id = s->pool[i];
+        s->pool[i] = s->pool[--s->fresh];
+        s->pool[s->fresh] = category_id;
+
+        uint32_t start = bank.category_start[category_id];
+        uint64_t size = bank.category_start[category_id + 1] - start;
+        for (uint32_t t = 0; t < deck.rows; t++) {
+            uint32_t p = deal_tier(s, start + t * size / deck.rows, start + (t + 1) * size / deck.rows,
+                                   s->dealt[category_id]);
+            cells[n++] = bank.category_order[p];
+        }
+        s->dealt[category_id]++;
+    }
+
+    // The smallest tier of a category runs out first; until it does, the category stays fresh
+    for (uint32_t i = s->fresh; i < fresh; i++) {
+        uint32_t category_id = s->pool[i];
+        uint32_t size = bank.category_start[category_id + 1] - bank.category_start[category_id];
+        if (s->dealt[category_id] < size / deck.rows) {
+            s->pool[i] = s->pool[s->fresh];
+            s->pool[s->fresh++] = category_id;
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    set_board(b, cells, n);
+    return true;
+}
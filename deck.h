@@ -0,0 +1,47 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef DECK_H_
+#define DECK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "questions.h"
+
+#define DECK_ROWS 5         // Value tiers of a drawn board unless given
+#define DECK_MAX_COLUMNS 64 // Largest drawn board: categories
+#define DECK_MAX_ROWS 64    //   and value tiers of each
+#define DECK_PROBES 8       // Random positions tried in a tier before its unused questions are counted out
+
+struct deck_state;
+
+// How boards are drawn from the bank: the shape of a board and the state
+// shared by every game dealt from it, of which questions each category has
+// given out since the deck was last shuffled
+typedef struct {
+    uint32_t columns;      // Categories on a drawn board, 0 when every game plays the whole bank
+    uint32_t rows;         // Value tiers of each category, one question from each
+    struct deck_state *state;
+} board_deck;
+
+// The deck of the current bank, shared by every game and copied per thread
+// along with the bank
+extern _Thread_local board_deck deck;
+
+// Sets up drawing boards of columns categories by rows value tiers from the
+// current bank, replacing the previous deck; returns 0 on success or -1 if the
+// bank has fewer than columns categories a board can be drawn from
+extern int build_deck(int columns, int rows);
+
+// Releases the deck; games then play the whole bank
+extern void free_deck(void);
+
+// Replaces a board with a freshly drawn one; returns false, leaving the board
+// as it was, if boards are not drawn
+extern bool draw_board(board_state *b);
+
+#endif /* DECK_H_ */
@@ -0,0 +1,618 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Event export for analysing games after the fact. Every pick, answer, pass and
+ * timeout is recorded with its question, player, score change and timing, in a
+ * compact columnar file that evstat aggregates without parsing any console
+ * output.
+ *
+ * Each thread records into its own buffer, one array per column, so recording
+ * takes no lock. Category and player names are interned into per-buffer
+ * dictionaries as they are recorded, so a row holds small integers only. Once
+ * EVENTS_CHUNK events have been buffered (or when recording stops) the buffer is
+ * encoded as a chunk and appended to the file with a single write:
+ *
+ *   header (event_chunk_header)
+ *   category dictionary, player dictionary: count, then each name's length and bytes
+ *   type, time, game, category, value, player, delta, elapsed columns
+ *
+ * Each dictionary and column is prefixed with its length in bytes, so a reader
+ * can skip the columns it does not need, and the chunk is padded with zeros to
+ * a multiple of 8 bytes for its checksum. Integers are varints; times and game
+ * numbers are stored as the zigzag difference from the previous row, which is
+ * a byte or two for events close together. A chunk carries its own
+ * dictionaries, so chunks from different threads or runs can be interleaved
+ * freely in the file, and a checksum, so a chunk torn by a crash is detected.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "events.h" // Include the event layout and prototypes.
+#include "util.h"   // Allocation and hashing helpers and the monotonic clock.
+
+#define DICT_SLOTS (2 * EVENTS_CHUNK) // Hash slots of a dictionary: it never holds more names than a chunk has rows
+#define DICT_RECENT 64                // Names a dictionary remembers by address
+#define VARINT_MAX 10                 // Longest varint: 64 bits, 7 to a byte
+#define CHECKSUM_SEED 14695981039346656037ull
+
+// A growable array of bytes
+typedef struct {
+    char *bytes;
+    size_t size;
+    size_t capacity;
+} byte_buffer;
+
+// Names interned in a buffer, numbered in the order they were first recorded
+typedef struct {
+    byte_buffer names;                 // The names, each NUL-terminated
+    uint32_t offsets[EVENTS_CHUNK];    // Where each name starts in names
+    uint32_t lengths[EVENTS_CHUNK];
+    uint32_t count;
+    uint32_t recent[DICT_RECENT];      // Index + 1 of a name recently interned from each address, 0 if none
+    uint32_t slots[DICT_SLOTS];        // Open-addressed hash table of names: index + 1, 0 if free
+} event_dict;
+
+// The events a thread has recorded since its last chunk, a column at a time
+typedef struct event_buffer {
+    uint32_t rows;
+    uint8_t type[EVENTS_CHUNK];
+    uint64_t time[EVENTS_CHUNK];
+    uint64_t game[EVENTS_CHUNK];
+    uint32_t category[EVENTS_CHUNK];
+    int32_t value[EVENTS_CHUNK];
+    uint32_t player[EVENTS_CHUNK];     // Dictionary index + 1, 0 for none
+    int32_t delta[EVENTS_CHUNK];
+    uint64_t elapsed[EVENTS_CHUNK];
+    event_dict categories;
+    event_dict players;
+    byte_buffer chunk;                 // The encoded chunk, kept for the next one
+    byte_buffer column;                // A dictionary or column being encoded
+    struct event_buffer *next;
+} event_buffer;
+
+// The file events are recorded to and every thread's buffer
+static struct {
+    int fd;                // -1 while events are not recorded
+    char *path;
+    uint64_t epoch;        // The real-time clock less the monotonic clock, in nanoseconds
+    pthread_mutex_t lock;  // Serializes appends and the list of buffers
+    event_buffer *buffers;
+} events = { -1, NULL, 0, PTHREAD_MUTEX_INITIALIZER, NULL };
+
+static _Thread_local event_buffer *local; // The calling thread's buffer
+
+// Makes room for size more bytes at the end of a buffer.
+static void reserve(byte_buffer *b, size_t size) {
+    if (b->size + size > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity : 4096;
+        while (capacity < b->size + size) capacity *= 2;
+        b->bytes = xrealloc(b->bytes, capacity);
+        b->capacity = capacity;
+    }
+}
+
+// Appends bytes to a buffer, growing it as needed.
+static void put_bytes(byte_buffer *b, const void *data, size_t size) {
+    if (size == 0) return;
+    reserve(b, size);
+    memcpy(b->bytes + b->size, data, size);
+    b->size += size;
+}
+
+// Writes an integer as a varint, seven bits a byte, low bits first, returning
+// the byte after it.
+static unsigned char *write_varint(unsigned char *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+// Appends an integer as a varint.
+static void put_varint(byte_buffer *b, uint64_t v) {
+    reserve(b, VARINT_MAX);
+    b->size = (char *)write_varint((unsigned char *)b->bytes + b->size, v) - b->bytes;
+}
+
+// Maps a signed integer to an unsigned one, small magnitudes to small numbers.
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+// Returns a slot of the recent names of a dictionary for a name's address.
+static uint32_t *recent_slot(event_dict *d, const char *name) {
+    return &d->recent[((uintptr_t)name >> 3) & (DICT_RECENT - 1)];
+}
+
+/**
+ * Returns a name's index in a dictionary, adding it if it is new. Names are
+ * recorded from the bank and the player tables, so the same few addresses come
+ * up again and again: a name interned from an address before is only compared,
+ * not hashed. The comparison catches an address reused for another name.
+ */
+static uint32_t intern(event_dict *d, const char *name) {
+    uint32_t *recent = recent_slot(d, name);
+    if (*recent != 0 && strcmp(d->names.bytes + d->offsets[*recent - 1], name) == 0) return *recent - 1;
+
+    size_t len = strlen(name);
+    uint32_t i = hash_string(name, len) & (DICT_SLOTS - 1);
+
+    for (; d->slots[i] != 0; i = (i + 1) & (DICT_SLOTS - 1)) {
+        uint32_t e = d->slots[i] - 1;
+        if (d->lengths[e] == len && memcmp(d->names.bytes + d->offsets[e], name, len) == 0) {
+            *recent = e + 1;
+            return e;
+        }
+    }
+
+    d->offsets[d->count] = d->names.size;
+    d->lengths[d->count] = len;
+    put_bytes(&d->names, name, len + 1);
+    d->slots[i] = ++d->count;
+    *recent = d->count;
+    return d->count - 1;
+}
+
+// Empties a dictionary, keeping its memory.
+static void clear_dict(event_dict *d) {
+    d->names.size = 0;
+    d->count = 0;
+    memset(d->slots, 0, sizeof(d->slots));
+    memset(d->recent, 0, sizeof(d->recent));
+}
+
+// Appends the encoded dictionary or column of a buffer to its chunk, prefixed with its length.
+static void end_column(event_buffer *b) {
+    put_varint(&b->chunk, b->column.size);
+    put_bytes(&b->chunk, b->column.bytes, b->column.size);
+    b->column.size = 0;
+}
+
+// Encodes a dictionary: the count, then each name's length and bytes.
+static void put_dict(event_buffer *b, const event_dict *d) {
+    put_varint(&b->column, d->count);
+    for (uint32_t e = 0; e < d->count; e++) {
+        put_varint(&b->column, d->lengths[e]);
+        put_bytes(&b->column, d->names.bytes + d->offsets[e], d->lengths[e]);
+    }
+    end_column(b);
+}
+
+// Returns where a column of the buffer's rows is encoded, with room for every
+// row's varint.
+static unsigned char *start_column(event_buffer *b) {
+    reserve(&b->column, (size_t)b->rows * VARINT_MAX);
+    return (unsigned char *)b->column.bytes;
+}
+
+// Ends a column encoded from start_column at p.
+static void finish_column(event_buffer *b, unsigned char *p) {
+    b->column.size = (char *)p - b->column.bytes;
+    end_column(b);
+}
+
+// Encodes a column of unsigned integers, each as the difference from the one
+// before if delta is set.
+static void put_column(event_buffer *b, const uint64_t *values, bool delta) {
+    unsigned char *p = start_column(b);
+    uint64_t previous = 0;
+    for (uint32_t i = 0; i < b->rows; i++) {
+        p = write_varint(p, delta ? zigzag((int64_t)(values[i] - previous)) : values[i]);
+        previous = values[i];
+    }
+    finish_column(b, p);
+}
+
+// Encodes a column of signed 32-bit integers.
+static void put_signed_column(event_buffer *b, const int32_t *values) {
+    unsigned char *p = start_column(b);
+    for (uint32_t i = 0; i < b->rows; i++) {
+        p = write_varint(p, zigzag(values[i]));
+    }
+    finish_column(b, p);
+}
+
+// Encodes a column of unsigned 32-bit integers.
+static void put_index_column(event_buffer *b, const uint32_t *values) {
+    unsigned char *p = start_column(b);
+    for (uint32_t i = 0; i < b->rows; i++) {
+        p = write_varint(p, values[i]);
+    }
+    finish_column(b, p);
+}
+
+/**
+ * Computes the checksum of a chunk's columns: 64-bit FNV over 8-byte words
+ * (as pack_checksum does for packs), folded to 32 bits.
+ *
+ * @param data The columns, padded with zeros to a multiple of 8 bytes.
+ * @param size Their padded size.
+ */
+static uint32_t chunk_checksum(const void *data, size_t size) {
+    const unsigned char *p = data;
+    uint64_t h = CHECKSUM_SEED;
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        h = (h ^ word) * 1099511628211ull;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+// Writes a whole buffer, retrying short writes; returns 0 or -1 on error.
+static int write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+/**
+ * Encodes the events of a buffer as a chunk and appends it to the file with
+ * one write, leaving the buffer empty.
+ *
+ * @param b The buffer; only the thread that owns it may call this while it records.
+ */
+static void append_chunk(event_buffer *b) {
+    if (b->rows == 0) return;
+
+    event_chunk_header h = { EVENTS_MAGIC, b->rows, 0, 0 };
+    b->chunk.size = 0;
+    put_bytes(&b->chunk, &h, sizeof(h));
+
+    put_dict(b, &b->categories);
+    put_dict(b, &b->players);
+    put_bytes(&b->column, b->type, b->rows);
+    end_column(b);
+    put_column(b, b->time, true);
+    put_column(b, b->game, true);
+    put_index_column(b, b->category);
+    put_signed_column(b, b->value);
+    put_index_column(b, b->player);
+    put_signed_column(b, b->delta);
+    put_column(b, b->elapsed, false);
+
+    static const char zeros[8] = { 0 };
+    put_bytes(&b->chunk, zeros, -(b->chunk.size - sizeof(h)) & 7);
+    h.size = b->chunk.size - sizeof(h);
+    h.checksum = chunk_checksum(b->chunk.bytes + sizeof(h), h.size);
+    memcpy(b->chunk.bytes, &h, sizeof(h));
+
+    pthread_mutex_lock(&events.lock);
+    if (write_all(events.fd, b->chunk.bytes, b->chunk.size) != 0) perror(events.path);
+    pthread_mutex_unlock(&events.lock);
+
+    b->rows = 0;
+    clear_dict(&b->categories);
+    clear_dict(&b->players);
+}
+
+/**
+ * Starts recording events to a file. Chunks are appended to whatever the file
+ * already holds, so several runs can share one file.
+ *
+ * @param path The event file.
+ * @return 0 on success or -1 if the file could not be opened.
+ */
+int events_open(const char *path) {
+    events.fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (events.fd == -1) {
+        perror(path);
+        return -1;
+    }
+    events.path = xmalloc(strlen(path) + 1);
+    strcpy(events.path, path);
+
+    // Events are timed with the monotonic clock alone and dated by this offset
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    events.epoch = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec - monotonic_ns();
+    return 0;
+}
+
+// Returns true while events are being recorded.
+bool events_recording(void) {
+    return events.fd != -1;
+}
+
+/**
+ * Records an event in the calling thread's buffer, appending the buffer to the
+ * file once it is full.
+ *
+ * @param type What happened.
+ * @param game The number of the game it happened in.
+ * @param category The category of the question.
+ * @param value The value of the question.
+ * @param player The name of the player, or NULL if none.
+ * @param delta The change to the player's score.
+ * @param started When the question was picked or the turn began (monotonic_ns),
+ *        or 0 to record no elapsed time.
+ */
+void events_record(event_type type, uint64_t game, const char *category, int value, const char *player,
+                   int delta, uint64_t started) {
+    if (events.fd == -1) return;
+
+    if (local == NULL) {
+        local = xcalloc(1, sizeof(event_buffer));
+        pthread_mutex_lock(&events.lock);
+        local->next = events.buffers;
+        events.buffers = local;
+        pthread_mutex_unlock(&events.lock);
+    }
+
+    uint64_t now = monotonic_ns();
+    event_buffer *b = local;
+    uint32_t i = b->rows++;
+    b->type[i] = type;
+    b->time[i] = now + events.epoch;
+    b->game[i] = game;
+    b->category[i] = intern(&b->categories, category);
+    b->value[i] = value;
+    b->player[i] = player != NULL ? intern(&b->players, player) + 1 : 0;
+    b->delta[i] = delta;
+    b->elapsed[i] = started ? now - started : 0;
+
+    if (b->rows == EVENTS_CHUNK) append_chunk(b);
+}
+
+// Appends what every thread has buffered, frees the buffers and closes the file.
+void events_close(void) {
+    if (events.fd == -1) return;
+
+    while (events.buffers != NULL) {
+        event_buffer *b = events.buffers;
+        events.buffers = b->next;
+        append_chunk(b);
+        free(b->categories.names.bytes);
+        free(b->players.names.bytes);
+        free(b->chunk.bytes);
+        free(b->column.bytes);
+        free(b);
+    }
+    local = NULL;
+
+    close(events.fd);
+    events.fd = -1;
+    free(events.path);
+    events.path = NULL;
+}
+
+// Bounds of a dictionary or column being decoded; ok is cleared by a read past the end
+typedef struct {
+    const unsigned char *next;
+    const unsigned char *end;
+    bool ok;
+} cursor;
+
+// Reads a varint.
+static uint64_t get_varint(cursor *c) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && c->next < c->end; shift += 7) {
+        unsigned char byte = *c->next++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+    c->ok = false;
+    return 0;
+}
+
+// Maps a zigzag-encoded integer back to the signed integer.
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Reads the next dictionary or column of a chunk, returning a cursor over it.
+static cursor next_column(cursor *chunk) {
+    uint64_t size = get_varint(chunk);
+    cursor c = { chunk->next, chunk->next, chunk->ok && size <= (uint64_t)(chunk->end - chunk->next) };
+    if (c.ok) {
+        c.end += size;
+        chunk->next += size;
+    } else {
+        chunk->ok = false;
+    }
+    return c;
+}
+
+// The arrays events are decoded into, grown to the largest chunk
+typedef struct {
+    event_chunk chunk;
+    uint32_t capacity;     // Rows the columns hold
+    char *names;           // The names of both dictionaries, NUL-terminated
+    size_t names_capacity;
+    uint32_t dict_capacity; // Names each dictionary holds
+} event_columns;
+
+// Makes room for a chunk of rows events whose dictionaries take up to names bytes.
+static void reserve_columns(event_columns *e, uint32_t rows, size_t names) {
+    event_chunk *c = &e->chunk;
+    if (rows > e->capacity) {
+        e->capacity = rows;
+        c->type = xrealloc(c->type, rows * sizeof(*c->type));
+        c->time = xrealloc(c->time, rows * sizeof(*c->time));
+        c->game = xrealloc(c->game, rows * sizeof(*c->game));
+        c->category = xrealloc(c->category, rows * sizeof(*c->category));
+        c->value = xrealloc(c->value, rows * sizeof(*c->value));
+        c->player = xrealloc(c->player, rows * sizeof(*c->player));
+        c->delta = xrealloc(c->delta, rows * sizeof(*c->delta));
+        c->elapsed = xrealloc(c->elapsed, rows * sizeof(*c->elapsed));
+    }
+    if (names > e->names_capacity) {
+        e->names_capacity = names;
+        e->names = xrealloc(e->names, names);
+    }
+}
+
+/**
+ * Decodes a dictionary into the names buffer at *used, NUL-terminating each name.
+ *
+ * @return The number of names, with *names pointing to them, or -1 if the
+ *         dictionary is corrupt.
+ */
+static long get_dict(event_columns *e, cursor c, size_t *used, char ***names) {
+    uint64_t count = get_varint(&c);
+    if (!c.ok || count > (uint64_t)(c.end - c.next)) return -1;
+
+    if (count > e->dict_capacity) {
+        e->dict_capacity = count;
+        e->chunk.categories = xrealloc(e->chunk.categories, count * sizeof(char *));
+        e->chunk.players = xrealloc(e->chunk.players, count * sizeof(char *));
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t len = get_varint(&c);
+        if (!c.ok || len > (uint64_t)(c.end - c.next)) return -1;
+
+        char *name = e->names + *used;
+        memcpy(name, c.next, len);
+        name[len] = '\0';
+        c.next += len;
+        *used += len + 1;
+        (*names)[i] = name;
+    }
+    return c.next == c.end ? (long)count : -1;
+}
+
+/**
+ * Decodes a chunk whose checksum has been verified.
+ *
+ * @param e Where the events are decoded to.
+ * @param rows The number of events in the chunk.
+ * @param data The dictionaries and columns.
+ * @param size Their length in bytes.
+ * @return true, or false if the chunk is corrupt.
+ */
+static bool decode_chunk(event_columns *e, uint32_t rows, const unsigned char *data, size_t size) {
+    event_chunk *c = &e->chunk;
+    cursor chunk = { data, data + size, true };
+
+    // Every name takes at least its length byte, so the names fit in the chunk's size
+    reserve_columns(e, rows, size);
+    c->rows = rows;
+
+    size_t used = 0;
+    long categories = get_dict(e, next_column(&chunk), &used, &c->categories);
+    long players = categories >= 0 ? get_dict(e, next_column(&chunk), &used, &c->players) : -1;
+    if (players < 0) return false;
+    c->num_categories = categories;
+    c->num_players = players;
+
+    cursor types = next_column(&chunk);
+    if (!types.ok || types.end - types.next != (ptrdiff_t)rows) return false;
+    for (uint32_t i = 0; i < rows; i++) {
+        c->type[i] = types.next[i];
+        if (c->type[i] >= EVENT_TYPES) return false;
+    }
+
+    cursor times = next_column(&chunk), games = next_column(&chunk), category = next_column(&chunk),
+           value = next_column(&chunk), player = next_column(&chunk), delta = next_column(&chunk),
+           elapsed = next_column(&chunk);
+    uint64_t time = 0, game = 0;
+    for (uint32_t i = 0; i < rows; i++) {
+        c->time[i] = time += unzigzag(get_varint(&times));
+        c->game[i] = game += unzigzag(get_varint(&games));
+        uint64_t category_index = get_varint(&category), player_index = get_varint(&player);
+        if (category_index >= c->num_categories || player_index > c->num_players) return false;
+        c->category[i] = category_index;
+        c->player[i] = (int32_t)player_index - 1;
+        c->value[i] = unzigzag(get_varint(&value));
+        c->delta[i] = unzigzag(get_varint(&delta));
+        c->elapsed[i] = get_varint(&elapsed);
+    }
+
+    // Every column must hold exactly one value per event
+    cursor *columns[] = { &times, &games, &category, &value, &player, &delta, &elapsed };
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]); i++) {
+        if (!columns[i]->ok || columns[i]->next != columns[i]->end) return false;
+    }
+    return chunk.ok;
+}
+
+/**
+ * Decodes the chunks of an event file in order. The file is mapped, so only
+ * the chunks being decoded are read from disk.
+ *
+ * @param path The event file.
+ * @param reader Called with each chunk; the chunk is only valid during the call.
+ * @param ctx Passed on to reader.
+ * @return The number of events read, or -1 if the file could not be read. A
+ *         torn or corrupt chunk is reported and ends the file.
+ */
+long events_read(const char *path, event_reader reader, void *ctx) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        perror(path);
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    const unsigned char *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    event_columns e;
+    memset(&e, 0, sizeof(e));
+    long total = 0;
+    size_t offset = 0, size = st.st_size;
+    while (offset < size) {
+        event_chunk_header h;
+        if (size - offset < sizeof(h)) {
+            fprintf(stderr, "%s: torn chunk at byte %zu\n", path, offset);
+            break;
+        }
+        memcpy(&h, data + offset, sizeof(h));
+        const unsigned char *columns = data + offset + sizeof(h);
+
+        if (h.magic != EVENTS_MAGIC || h.size > size - offset - sizeof(h) || h.size % 8 != 0 || h.rows > h.size ||
+            chunk_checksum(columns, h.size) != h.checksum || !decode_chunk(&e, h.rows, columns, h.size)) {
+            fprintf(stderr, "%s: corrupt chunk at byte %zu\n", path, offset);
+            break;
+        }
+        reader(ctx, &e.chunk);
+        total += h.rows;
+        offset += sizeof(h) + h.size;
+    }
+
+    munmap((void *)data, size);
+    event_chunk *c = &e.chunk;
+    free(c->type);
+    free(c->time);
+    free(c->game);
+    free(c->category);
+    free(c->value);
+    free(c->player);
+    free(c->delta);
+    free(c->elapsed);
+    free(c->categories);
+    free(c->players);
+    free(e.names);
+    return total;
+}
@@ -0,0 +1,77 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EVENTS_CHUNK 4096          // Events a thread buffers before appending them as a chunk
+#define EVENTS_MAGIC 0x4356454a    // "JEVC", the start of every chunk
+
+// What happened to a question
+typedef enum {
+    EVENT_PICK,            // The question was picked; the player is whoever picked it
+    EVENT_CORRECT,         // The player answered it correctly
+    EVENT_INCORRECT,       // The player answered it wrong
+    EVENT_PASS,            // The player gave up on it in a buzzer round
+    EVENT_TIMEOUT,         // The player's turn, or the question if nobody had a turn, ran out of time
+    EVENT_TYPES
+} event_type;
+
+// Header of a chunk of events in the file, followed by size bytes of columns
+typedef struct {
+    uint32_t magic;        // EVENTS_MAGIC
+    uint32_t rows;         // Events in the chunk
+    uint32_t size;         // Bytes of the columns, padded to a multiple of 8
+    uint32_t checksum;     // Word-at-a-time FNV checksum of the columns
+} event_chunk_header;
+
+// A chunk of events decoded by events_read, one array per column. Categories
+// and players are indexes into the chunk's dictionaries
+typedef struct {
+    uint32_t rows;
+    uint8_t *type;         // event_type of each event
+    uint64_t *time;        // When it happened, in nanoseconds of the real-time clock
+    uint64_t *game;        // Game it happened in, numbered from 1 within a run of the program
+    uint32_t *category;    // Category of the question
+    int32_t *value;        // Value of the question
+    int32_t *player;       // Player, or -1 if none
+    int32_t *delta;        // Change to the player's score
+    uint64_t *elapsed;     // Nanoseconds since the question was picked or the turn began
+    char **categories;     // Dictionary of category names
+    uint32_t num_categories;
+    char **players;        // Dictionary of player names
+    uint32_t num_players;
+} event_chunk;
+
+// Called by events_read with each chunk of a file in turn
+typedef void (*event_reader)(void *ctx, const event_chunk *c);
+
+// Starts recording the events of every game to a file, appended to if it
+// exists; returns 0 on success or -1 if it could not be opened
+extern int events_open(const char *path);
+
+// Returns true while events are being recorded
+extern bool events_recording(void);
+
+// Records an event in the calling thread's buffer; started is when the
+// question was picked or the turn began (monotonic_ns). Does nothing unless
+// events are being recorded
+extern void events_record(event_type type, uint64_t game, const char *category, int value, const char *player,
+                          int delta, uint64_t started);
+
+// Appends what every thread has buffered and closes the file; the threads
+// that recorded must have finished
+extern void events_close(void);
+
+// Decodes the chunks of an event file, handing each to reader; returns the number
+// of events read or -1 if the file could not be read. A torn or corrupt chunk
+// ends the file
+extern long events_read(const char *path, event_reader reader, void *ctx);
+
+#endif /* EVENTS_H_ */
@@ -0,0 +1,295 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Command-line tool that aggregates the events exported with jeopardy -E: how
+ * many questions were picked, answered, passed and timed out, how often they
+ * were answered correctly and how long answers took, overall and per category
+ * with the hardest categories first, or per question with -q.
+ *
+ * The event files are decoded a chunk at a time (see events.c). A chunk's
+ * category dictionary is mapped to the tool's own category numbers once, so
+ * each event costs a few array lookups and, for -q, one hash probe.
+ *
+ * Usage: evstat [-q] [-n rows] <events>...
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "events.h" // Decodes the event files.
+#include "util.h"   // Allocation and hashing helpers.
+
+#define TOP_ROWS 20 // Rows of the table printed unless given
+
+// What happened to a category or question
+typedef struct {
+    uint32_t category;     // Category number
+    int32_t value;         // Value of the question; unused for a category
+    uint64_t counts[EVENT_TYPES];
+    uint64_t answer_ns;    // Total time taken by the answers, correct or not
+    int64_t points;        // Net score change
+} tally;
+
+// Tallies of questions found by category and value through an open-addressed hash table
+typedef struct {
+    tally *tallies;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *slots;       // Index + 1 of the tally, 0 if free
+    uint32_t num_slots;    // A power of two, at least twice count
+} tally_table;
+
+// Category names numbered in the order they were first seen, each with its tally
+typedef struct {
+    char **names;
+    uint32_t *hashes;
+    tally *tallies;        // By category number
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *slots;       // Number + 1 of the category, 0 if free
+    uint32_t num_slots;    // A power of two, at least twice count
+} category_table;
+
+// Everything aggregated so far
+typedef struct {
+    category_table categories;
+    tally_table questions;
+    uint32_t *mapping;     // The category number of each name in the current chunk's dictionary
+    uint32_t mapping_capacity;
+    tally total;
+    bool by_question;      // Tally questions as well as categories
+} aggregate;
+
+// Hashes the key of a question.
+static uint32_t hash_key(uint32_t category, int32_t value) {
+    uint64_t key = ((uint64_t)category << 32 | (uint32_t)value) * 0x9e3779b97f4a7c15ull;
+    return (uint32_t)(key >> 32);
+}
+
+// Doubles the hash table of a tally table, rehashing its tallies.
+static void grow_tallies(tally_table *t) {
+    t->num_slots = t->num_slots ? t->num_slots * 2 : 1024;
+    free(t->slots);
+    t->slots = xcalloc(t->num_slots, sizeof(uint32_t));
+    for (uint32_t e = 0; e < t->count; e++) {
+        uint32_t i = hash_key(t->tallies[e].category, t->tallies[e].value) & (t->num_slots - 1);
+        while (t->slots[i] != 0) i = (i + 1) & (t->num_slots - 1);
+        t->slots[i] = e + 1;
+    }
+}
+
+// Returns the tally of a question, adding an empty one if it has none.
+static tally *find_question(tally_table *t, uint32_t category, int32_t value) {
+    if (2 * (t->count + 1) > t->num_slots) grow_tallies(t);
+
+    uint32_t i = hash_key(category, value) & (t->num_slots - 1);
+    for (; t->slots[i] != 0; i = (i + 1) & (t->num_slots - 1)) {
+        tally *e = &t->tallies[t->slots[i] - 1];
+        if (e->category == category && e->value == value) return e;
+    }
+
+    if (t->count == t->capacity) {
+        t->capacity = t->capacity ? t->capacity * 2 : 256;
+        t->tallies = xrealloc(t->tallies, t->capacity * sizeof(tally));
+    }
+    tally *e = &t->tallies[t->count++];
+    memset(e, 0, sizeof(*e));
+    e->category = category;
+    e->value = value;
+    t->slots[i] = t->count;
+    return e;
+}
+
+// Doubles the hash table of the category names, rehashing them.
+static void grow_categories(category_table *t) {
+    t->num_slots = t->num_slots ? t->num_slots * 2 : 256;
+    free(t->slots);
+    t->slots = xcalloc(t->num_slots, sizeof(uint32_t));
+    for (uint32_t c = 0; c < t->count; c++) {
+        uint32_t i = t->hashes[c] & (t->num_slots - 1);
+        while (t->slots[i] != 0) i = (i + 1) & (t->num_slots - 1);
+        t->slots[i] = c + 1;
+    }
+}
+
+// Returns the number of a category by name, numbering it if it is new.
+static uint32_t category_number(category_table *t, const char *name) {
+    if (2 * (t->count + 1) > t->num_slots) grow_categories(t);
+
+    size_t len = strlen(name);
+    uint32_t h = hash_string(name, len);
+    uint32_t i = h & (t->num_slots - 1);
+    for (; t->slots[i] != 0; i = (i + 1) & (t->num_slots - 1)) {
+        uint32_t c = t->slots[i] - 1;
+        if (t->hashes[c] == h && strcmp(t->names[c], name) == 0) return c;
+    }
+
+    if (t->count == t->capacity) {
+        t->capacity = t->capacity ? t->capacity * 2 : 64;
+        t->names = xrealloc(t->names, t->capacity * sizeof(char *));
+        t->hashes = xrealloc(t->hashes, t->capacity * sizeof(uint32_t));
+        t->tallies = xrealloc(t->tallies, t->capacity * sizeof(tally));
+    }
+    uint32_t c = t->count++;
+    t->names[c] = xmalloc(len + 1);
+    memcpy(t->names[c], name, len + 1);
+    t->hashes[c] = h;
+    memset(&t->tallies[c], 0, sizeof(tally));
+    t->tallies[c].category = c;
+    t->slots[i] = c + 1;
+    return c;
+}
+
+// Counts an event in a tally.
+static void count_event(tally *t, const event_chunk *c, uint32_t i) {
+    t->counts[c->type[i]]++;
+    t->points += c->delta[i];
+    if (c->type[i] == EVENT_CORRECT || c->type[i] == EVENT_INCORRECT) t->answer_ns += c->elapsed[i];
+}
+
+// Adds the events of a chunk to the aggregate (an event_reader).
+static void add_chunk(void *ctx, const event_chunk *c) {
+    aggregate *a = ctx;
+
+    if (c->num_categories > a->mapping_capacity) {
+        a->mapping_capacity = c->num_categories;
+        a->mapping = xrealloc(a->mapping, a->mapping_capacity * sizeof(uint32_t));
+    }
+    for (uint32_t d = 0; d < c->num_categories; d++) {
+        a->mapping[d] = category_number(&a->categories, c->categories[d]);
+    }
+
+    for (uint32_t i = 0; i < c->rows; i++) {
+        uint32_t category = a->mapping[c->category[i]];
+        count_event(&a->total, c, i);
+        count_event(&a->categories.tallies[category], c, i);
+        if (a->by_question) count_event(find_question(&a->questions, category, c->value[i]), c, i);
+    }
+}
+
+// Returns the attempts at a question or category: answers and timeouts.
+static uint64_t attempts(const tally *t) {
+    return t->counts[EVENT_CORRECT] + t->counts[EVENT_INCORRECT] + t->counts[EVENT_TIMEOUT];
+}
+
+// Returns the fraction of attempts answered correctly, 1 if there were none.
+static double accuracy(const tally *t) {
+    uint64_t n = attempts(t);
+    return n ? (double)t->counts[EVENT_CORRECT] / n : 1.0;
+}
+
+// Returns the mean time taken by an answer in milliseconds, 0 if there were none.
+static double answer_ms(const tally *t) {
+    uint64_t n = t->counts[EVENT_CORRECT] + t->counts[EVENT_INCORRECT];
+    return n ? t->answer_ns / 1e6 / n : 0.0;
+}
+
+// Orders tallies hardest first: lowest accuracy, then most attempted.
+static int by_difficulty(const void *x, const void *y) {
+    const tally *a = x, *b = y;
+    double pa = accuracy(a), pb = accuracy(b);
+    if (pa != pb) return pa < pb ? -1 : 1;
+    uint64_t na = attempts(a), nb = attempts(b);
+    return na != nb ? (na > nb ? -1 : 1) : 0;
+}
+
+/**
+ * Prints tallies hardest first.
+ *
+ * @param a The aggregate the tallies belong to, for the category names.
+ * @param tallies The tallies; they are sorted in place.
+ * @param count The number of tallies.
+ * @param rows The most to print, 0 for all.
+ * @param by_question Whether the tallies are of questions rather than categories.
+ */
+static void print_tallies(const aggregate *a, tally *tallies, uint32_t count, uint32_t rows, bool by_question) {
+    qsort(tallies, count, sizeof(tally), by_difficulty);
+    if (rows == 0 || rows > count) rows = count;
+
+    printf("%-24s %8s %8s %8s %8s %8s %10s %10s\n", by_question ? "question" : "category", "picks", "answers",
+           "correct", "passes", "timeouts", "answer ms", "points");
+    for (uint32_t i = 0; i < rows; i++) {
+        const tally *t = &tallies[i];
+        char label[64];
+        if (by_question) {
+            snprintf(label, sizeof(label), "%s $%d", a->categories.names[t->category], t->value);
+        } else {
+            snprintf(label, sizeof(label), "%s", a->categories.names[t->category]);
+        }
+        printf("%-24s %8llu %8llu %7.1f%% %8llu %8llu %10.3f %10lld\n", label,
+               (unsigned long long)t->counts[EVENT_PICK],
+               (unsigned long long)(t->counts[EVENT_CORRECT] + t->counts[EVENT_INCORRECT]), 100 * accuracy(t),
+               (unsigned long long)t->counts[EVENT_PASS], (unsigned long long)t->counts[EVENT_TIMEOUT], answer_ms(t),
+               (long long)t->points);
+    }
+    if (rows < count) printf("... %u more\n", count - rows);
+}
+
+// Frees everything aggregated.
+static void free_aggregate(aggregate *a) {
+    for (uint32_t c = 0; c < a->categories.count; c++) {
+        free(a->categories.names[c]);
+    }
+    free(a->categories.names);
+    free(a->categories.hashes);
+    free(a->categories.tallies);
+    free(a->categories.slots);
+    free(a->questions.tallies);
+    free(a->questions.slots);
+    free(a->mapping);
+}
+
+int main(int argc, char *argv[]) {
+    aggregate a;
+    memset(&a, 0, sizeof(a));
+    uint32_t rows = TOP_ROWS;
+
+    // Command-line options: -q tallies questions instead of categories, -n
+    // limits the table to that many rows, 0 for all of them
+    int opt;
+    while ((opt = getopt(argc, argv, "qn:")) != -1) {
+        if (opt == 'q') {
+            a.by_question = true;
+        } else if (opt == 'n' && atoi(optarg) >= 0) {
+            rows = atoi(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-q] [-n rows] <events>...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind == argc) {
+        fprintf(stderr, "Usage: %s [-q] [-n rows] <events>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    long events = 0;
+    for (int i = optind; i < argc; i++) {
+        long n = events_read(argv[i], add_chunk, &a);
+        if (n < 0) {
+            free_aggregate(&a);
+            return EXIT_FAILURE;
+        }
+        events += n;
+    }
+
+    const tally *t = &a.total;
+    printf("%ld events: %llu picks, %llu answers (%.1f%% of attempts correct, %.3f ms on average), %llu passes, "
+           "%llu timeouts\n\n", events, (unsigned long long)t->counts[EVENT_PICK],
+           (unsigned long long)(t->counts[EVENT_CORRECT] + t->counts[EVENT_INCORRECT]), 100 * accuracy(t),
+           answer_ms(t), (unsigned long long)t->counts[EVENT_PASS], (unsigned long long)t->counts[EVENT_TIMEOUT]);
+
+    if (a.by_question) {
+        print_tallies(&a, a.questions.tallies, a.questions.count, rows, true);
+    } else {
+        print_tallies(&a, a.categories.tallies, a.categories.count, rows, false);
+    }
+    free_aggregate(&a);
+    return EXIT_SUCCESS;
+}
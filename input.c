@@ -0,0 +1,148 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Event-driven line input. A line reader only reads a descriptor once poll (or
+ * epoll) has reported it readable, so waiting for a player never blocks the
+ * game: the wait can be cut short by a timerfd armed for the game's next
+ * deadline. The same reader splits the input of interactive play and of the
+ * server's sockets.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "input.h" // Include the line reader structures and prototypes.
+
+/**
+ * Initializes a reader of a file descriptor with an empty buffer.
+ *
+ * @param r The reader to initialize.
+ * @param fd The descriptor to read from.
+ */
+void line_reader_init(line_reader *r, int fd) {
+    r->fd = fd;
+    r->start = r->len = 0;
+    r->eof = false;
+}
+
+/**
+ * Reads the input that is available with a single read call, after moving any
+ * partial line to the front of the buffer. The descriptor should be readable (or
+ * non-blocking), otherwise the read blocks.
+ *
+ * @param r The reader.
+ * @return The number of bytes read, 0 if nothing was available or the buffer is
+ *         full, or -1 at end of file or on error.
+ */
+int line_reader_fill(line_reader *r) {
+    if (r->start > 0) {
+        r->len -= r->start;
+        memmove(r->buffer, r->buffer + r->start, r->len);
+        r->start = 0;
+    }
+    if (r->len == INPUT_BUFFER - 1) return 0; // Room for the NUL only; the caller takes the line first
+
+    for (;;) {
+        ssize_t n = read(r->fd, r->buffer + r->len, INPUT_BUFFER - 1 - r->len);
+        if (n > 0) {
+            r->len += n;
+            return n;
+        }
+        if (n == -1 && errno == EINTR) continue;
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+
+        r->eof = true;
+        return -1;
+    }
+}
+
+/**
+ * Takes the next line from the buffer. A line that fills the whole buffer is
+ * returned in pieces, like fgets would, and the last line of the input is
+ * returned at end of file even without a trailing newline.
+ *
+ * @param r The reader.
+ * @return The line, NUL-terminated in place without its newline and valid until
+ *         the next fill, or NULL if no complete line is buffered.
+ */
+char *line_reader_next(line_reader *r) {
+    char *line = r->buffer + r->start;
+    size_t available = r->len - r->start;
+    char *newline = memchr(line, '\n', available);
+
+    if (newline != NULL) {
+        *newline = '\0';
+        r->start += newline - line + 1;
+    } else if (available > 0 && (r->eof || available == INPUT_BUFFER - 1)) {
+        line[available] = '\0';
+        r->start = r->len;
+    } else {
+        return NULL;
+    }
+
+    if (r->start == r->len) r->start = r->len = 0;
+    return line;
+}
+
+// Creates a non-blocking timer on the monotonic clock; returns -1 on error.
+int deadline_timer(void) {
+    return timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+}
+
+/**
+ * Arms a timer for an absolute time of the monotonic clock, replacing any
+ * earlier setting. A deadline that has already passed expires immediately.
+ *
+ * @param timer_fd The timer, from deadline_timer.
+ * @param deadline The deadline from monotonic_ns, or 0 to disarm the timer.
+ */
+void arm_deadline(int timer_fd, uint64_t deadline) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = deadline / 1000000000u;
+    spec.it_value.tv_nsec = deadline % 1000000000u;
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+/**
+ * Waits until the reader's descriptor is readable, its timer expires or it is
+ * woken. An expired timer is acknowledged so it does not fire again until it
+ * is re-armed; a wake-up is left for its owner to acknowledge.
+ *
+ * @param r The reader.
+ * @param timer_fd The timer, or -1 to wait for input only.
+ * @param wake_fd A descriptor that wakes the wait when readable, or -1.
+ * @return WAIT_INPUT, WAIT_DEADLINE, WAIT_WAKE or WAIT_ERROR.
+ */
+wait_result wait_input(line_reader *r, int timer_fd, int wake_fd) {
+    struct pollfd fds[3] = {
+        { .fd = r->fd, .events = POLLIN },
+        { .fd = timer_fd, .events = POLLIN }, // poll skips negative descriptors
+        { .fd = wake_fd, .events = POLLIN }
+    };
+
+    for (;;) {
+        int n = poll(fds, 3, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return WAIT_ERROR;
+        }
+
+        if (fds[0].revents) return WAIT_INPUT; // Readable, hung up or failed: the read reports which
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t expirations;
+            ssize_t got = read(timer_fd, &expirations, sizeof(expirations));
+            (void)got;
+            return WAIT_DEADLINE;
+        }
+        if (fds[2].revents) return WAIT_WAKE;
+    }
+}
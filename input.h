@@ -0,0 +1,54 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define INPUT_BUFFER 4096 // Bytes of input buffered per reader; longer lines are split
+
+// Splits the input of a file descriptor into lines without blocking on it
+typedef struct {
+    int fd;
+    char buffer[INPUT_BUFFER];
+    size_t start;          // Start of the first unprocessed line in buffer
+    size_t len;            // End of the buffered input
+    bool eof;              // The descriptor has reached end of file or failed
+} line_reader;
+
+// Result of waiting for input
+typedef enum {
+    WAIT_INPUT,            // The input is readable
+    WAIT_DEADLINE,         // The deadline passed first
+    WAIT_WAKE,             // The wake descriptor became readable first
+    WAIT_ERROR
+} wait_result;
+
+// Initializes a reader of the given file descriptor
+extern void line_reader_init(line_reader *r, int fd);
+
+// Reads the input that is available with a single read; returns the number of
+// bytes read, 0 if nothing was available, or -1 at end of file or on error
+extern int line_reader_fill(line_reader *r);
+
+// Returns the next complete line, NUL-terminated in place without its newline,
+// or NULL if no complete line is buffered
+extern char *line_reader_next(line_reader *r);
+
+// Creates a non-blocking timer on the monotonic clock; returns -1 on error
+extern int deadline_timer(void);
+
+// Arms a timer to expire at an absolute monotonic_ns time, or disarms it for 0
+extern void arm_deadline(int timer_fd, uint64_t deadline);
+
+// Waits until the reader's descriptor is readable, the timer expires or the
+// wake descriptor becomes readable
+extern wait_result wait_input(line_reader *r, int timer_fd, int wake_fd);
+
+#endif /* INPUT_H_ */
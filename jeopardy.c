@@ -5,12 +5,26 @@
  * All rights reserved.
  *
  * This file contains the main logic for a command-line version of Jeopardy.
- * It includes functions for trimming strings, comparing player scores, displaying game results,
- * and processing user input to control the game flow.
+ * It includes functions for trimming strings, displaying game results, and
+ * processing input lines to control the game flow. The game is driven one line
+ * at a time through game_line, so the same logic serves the interactive prompt
+ * and batch replays (see main.c).
  *
  * Players can answer questions from selected categories to earn points. The game tracks
  * each player's score and displays the final results once all questions have been answered or
  * when the game is exited.
+ *
+ * A game can record its changes in a journal (see journal.c): joins, picks,
+ * score changes and answered questions are logged as they happen, after the
+ * game state has changed, and game_apply plays them back to recover a game.
+ * The same changes bump the game's version, which tells drivers when to
+ * publish the game to spectators with game_publish. A drawn board (see deck.c)
+ * is logged whole, as it cannot be drawn again on recovery.
+ *
+ * Command dispatch, question lookup, answer checking and output are timed for
+ * the stats command (see stats.c). Picks, answers, passes and timeouts can also
+ * be exported as events for analysis after the game (see events.c); each game
+ * started or reset gets a number of its own to tell its events apart.
  */
 
 #include <stdio.h>
@@ -18,16 +32,22 @@
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdatomic.h>
+#include <limits.h>
 
 #include "questions.h" // Includes the definitions and functions related to questions
+#include "match.h"     // Normalizes answers and recognizes their phrasing
 #include "players.h"   // Includes player struct and related functionalities
 #include "jeopardy.h"  // May include game-wide constants, structs, and prototypes
+#include "util.h"      // Allocation helpers and the monotonic clock
+#include "stats.h"     // Latency instrumentation
+#include "search.h"    // Keyword search over the bank
+#include "deck.h"      // Boards drawn at random from the bank
+#include "events.h"    // Event export for analytics
 
-#define BUFFER_LEN 256  // General purpose buffer length for input and strings
-#define NUM_PLAYERS 4   // Fixed number of players for this game
 
-#define WHAT_IS "what is"
-#define WHO_IS "who is"
+// Help command details
+static const char *help = "Available commands:\n* buzz [user]\n* display\n* exit\n* join [user]\n* pass [user]\n* pick [category] [value] [user]\n  e.g. pick databases 100 User1\n* rank [user]\n* search [words]\n  e.g. search capital fr*\n* stats\n* top [count]";
 
 /**
  * Trims leading whitespace characters from a string.
@@ -81,184 +101,1044 @@ char* trim(char *s) {
     return rtrim(ltrim(s));  
 }
 
-// Tokenizes user input into commands and parameters, facilitating command processing.
-void tokenize(char *input, char *tokens[], int maxTokens) {
+/**
+ * Tokenizes user input into commands and parameters, facilitating command processing.
+ *
+ * Tokens are separated by whitespace and returned as views into the input: each
+ * token records where it starts and how long it is, and is NUL-terminated in place
+ * so it can also be used as a C string. Nothing is copied and no state is kept
+ * between calls, so separate games can tokenize concurrently.
+ *
+ * @param input The input line; separators after tokens are overwritten with NULs.
+ * @param tokens Receives the tokens.
+ * @param maxTokens The capacity of tokens; anything after that many tokens is ignored.
+ * @return The number of tokens found.
+ */
+int tokenize(char *input, token tokens[], int maxTokens) {
     int tokenCount = 0;
+    char *p = input;
+
+    while (tokenCount < maxTokens) {
+        // Skip the whitespace, including newlines, before the next token
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') break;
 
-    // Trim leading and trailing whitespace including newlines
-    char *trimmedInput = trim(input);
-    char *token = strtok(trimmedInput, " "); // Find the first token
+        tokens[tokenCount].start = p;
+        while (*p != '\0' && !isspace((unsigned char)*p)) {
+            p++;
+        }
+        tokens[tokenCount].len = p - tokens[tokenCount].start;
+        tokenCount++;
 
-    while (token != NULL && tokenCount < maxTokens) {
-        tokens[tokenCount++] = token; // Store the token
-        token = strtok(NULL, " "); // Get the next token
+        if (*p != '\0') *p++ = '\0'; // Terminate the token in place
     }
 
-    tokens[tokenCount] = NULL; // Null-terminate the array of tokens
+    return tokenCount;
 }
 
-// Compares two players based on their scores to facilitate sorting.
-int compare_players(const void *a, const void *b) {
-    const player *playerA = (const player *)a;
-    const player *playerB = (const player *)b;
+// Parses a count token of digits only, saturating at INT_MAX; returns 0 if it is not a number.
+static int parse_count(const token *t) {
+    int count = 0;
 
-    // Directly compare the scores
-    if (playerA->score > playerB->score) return -1; // For descending order
-    else if (playerA->score < playerB->score) return 1;
-    else return 0;
+    for (size_t i = 0; i < t->len; i++) {
+        if (!isdigit((unsigned char)t->start[i])) return 0;
+        int digit = t->start[i] - '0';
+        count = count > (INT_MAX - digit) / 10 ? INT_MAX : count * 10 + digit;
+    }
+
+    return count;
 }
 
 // Displays the final game results, showing player rankings and scores.
-void show_results(player *players, int num_players) {
-    printf("All questions have been answered. The game is over.\n");
-    printf("Final Results:\n");
-
-    qsort(players, num_players, sizeof(player), compare_players);
-    for (int i = 0; i < num_players; i++) {
-        if (i == 0) {
-            printf("%i. (Winner) ", i + 1);
+void show_results(FILE *out, const player_registry *r) {
+    uint64_t start = stats_now();
+    fprintf(out, "Final Results:\n");
+
+    // The ranking is already ordered, so read it off the leaderboard instead of sorting.
+    int *ranking = xmalloc((r->num_players ? r->num_players : 1) * sizeof(int));
+    int count = leaderboard_top(&r->ranking, r->num_players, ranking);
+
+    for (int i = 0; i < count; i++) {
+        int p = ranking[i];
+        int rank = player_rank(r, p);
+
+        // Every player tied for first place is a winner.
+        if (rank == 1) {
+            fprintf(out, "%i. (Winner) ", rank);
+        } else {
+            fprintf(out, "%i. ", rank);
+        }
+        
+        fprintf(out, "Player: %s, Score: $%i\n", player_name(r, p), r->players[p].score);
+    }
+
+    free(ranking);
+    stats_record(STAT_RENDER, start);
+}
+
+/**
+ * Empties a game's arena and sets up its players and board afresh in it: a
+ * newly drawn board when boards are drawn, else the whole bank unanswered.
+ *
+ * @param draw Whether a board may be drawn; a replayed reset passes false, as
+ *        the board it drew follows in the journal.
+ * @return true if the board was drawn.
+ */
+static bool start_game(game *g, bool draw) {
+    static atomic_uint_fast64_t games_started;
+    g->id = atomic_fetch_add_explicit(&games_started, 1, memory_order_relaxed) + 1;
+
+    arena_reset(&g->arena);
+    init_players(&g->players, &g->arena);
+    g->attempted = NULL;
+    g->attempted_capacity = 0;
+
+    memset(&g->board, 0, sizeof(g->board));
+    g->board.arena = &g->arena;
+    if (draw && draw_board(&g->board)) return true;
+
+    init_board(&g->board, &g->arena);
+    return false;
+}
+
+// Sets a game up as game_init does, in an arena already initialized.
+static void setup_game(game *g, FILE *out, bool interactive, const game_rules *rules) {
+    start_game(g, true);
+    buzz_init(&g->buzzes);
+    g->out = out;
+    g->interactive = interactive;
+    g->rules = *rules;
+    g->pending_question = -1;
+    g->pending_player = -1;
+    g->status = GAME_RUNNING;
+    g->num_waiting = 0;
+    g->num_attempted = 0;
+    g->turn_start = 0;
+    g->turn_deadline = g->question_deadline = 0;
+    g->log = NULL;
+    g->version = 0;
+}
+
+/**
+ * Initializes a game with no players on its own board of the current bank:
+ * a freshly drawn one when boards are drawn, else the whole bank.
+ *
+ * @param g The game to initialize.
+ * @param out Where game output is written, or NULL to suppress it.
+ * @param interactive Whether a malformed answer is asked for again (interactive
+ *        play) rather than counted as incorrect (batch replays).
+ * @param rules The rules of the game: buzzer rounds and time limits. A turn
+ *        starts when a player is given the question (by picking it, or by
+ *        buzzing in during a buzzer round); a question is open from the pick
+ *        until it is answered or forfeited.
+ */
+void game_init(game *g, FILE *out, bool interactive, const game_rules *rules) {
+    arena_init(&g->arena);
+    setup_game(g, out, interactive, rules);
+}
+
+// Releases the players, board and buzzer state of a game, all held by its arena.
+void game_free(game *g) {
+    arena_free(&g->arena);
+}
+
+// Initializes a pool of games with no games in it.
+void game_pool_init(game_pool *pool) {
+    pool->games = NULL;
+    pool->num_games = pool->capacity = 0;
+}
+
+/**
+ * Takes a game from a pool, or allocates one if the pool is empty, and sets it
+ * up like game_init. A pooled game's arena still holds the blocks it grew to,
+ * so the new game allocates nothing until it outgrows them.
+ *
+ * @param pool The pool.
+ * @param out, interactive, rules As for game_init.
+ * @return The game, to be handed back with game_release.
+ */
+game *game_acquire(game_pool *pool, FILE *out, bool interactive, const game_rules *rules) {
+    game *g;
+    if (pool->num_games > 0) {
+        g = pool->games[--pool->num_games];
+    } else {
+        g = xmalloc(sizeof(game));
+        arena_init(&g->arena);
+    }
+    setup_game(g, out, interactive, rules);
+    return g;
+}
+
+// Hands a game back to its pool, freeing everything it held in O(1); a full
+// pool frees the game instead.
+void game_release(game_pool *pool, game *g) {
+    if (pool->num_games == GAME_POOL_SIZE) {
+        game_free(g);
+        free(g);
+        return;
+    }
+    if (pool->num_games == pool->capacity) {
+        pool->capacity = pool->capacity ? pool->capacity * 2 : 16;
+        pool->games = xrealloc(pool->games, pool->capacity * sizeof(game *));
+    }
+
+    arena_trim(&g->arena, ARENA_KEEP);
+    pool->games[pool->num_games++] = g;
+}
+
+// Frees the games of a pool.
+void game_pool_free(game_pool *pool) {
+    for (int i = 0; i < pool->num_games; i++) {
+        game_free(pool->games[i]);
+        free(pool->games[i]);
+    }
+    free(pool->games);
+    game_pool_init(pool);
+}
+
+/**
+ * Encodes the whole game as the records that rebuild its players, scores,
+ * drawn board, answered questions and open question from an empty game.
+ */
+static journal_buffer game_records(const game *g) {
+    journal_buffer records = { NULL, 0, 0 };
+
+    for (int p = 0; p < g->players.num_players; p++) {
+        const char *name = player_name(&g->players, p);
+        journal_put(&records, JOURNAL_JOIN, 0, 0, name, strlen(name));
+        if (g->players.players[p].score != 0) {
+            journal_put(&records, JOURNAL_SCORE, p, g->players.players[p].score, NULL, 0);
+        }
+    }
+    if (g->board.cells != NULL) {
+        journal_put(&records, JOURNAL_BOARD, g->board.num_cells, 0, (const char *)g->board.cells,
+                    g->board.num_cells * sizeof(int32_t));
+        for (uint32_t i = 0; i < g->board.num_cells; i++) {
+            int q = g->board.cells[i];
+            if (already_answered(&g->board, q)) journal_put(&records, JOURNAL_ANSWERED, q, 0, NULL, 0);
+        }
+    } else {
+        for (uint32_t q = 0; q < bank.num_questions; q++) {
+            if (already_answered(&g->board, q)) journal_put(&records, JOURNAL_ANSWERED, q, 0, NULL, 0);
+        }
+    }
+    if (g->pending_question != -1) {
+        journal_put(&records, JOURNAL_PICK, g->pending_question, g->rules.buzzer ? -1 : g->pending_player, NULL, 0);
+    }
+    return records;
+}
+
+// Hands the journal a snapshot of the whole game.
+static void snapshot_game(game *g) {
+    journal_buffer records = game_records(g);
+    journal_snapshot(g->log, &records);
+}
+
+// Records a change to the game in its journal, if it has one, taking a snapshot when one is due.
+static void log_change(game *g, journal_type type, int a, int b, const char *payload, size_t length) {
+    g->version++;
+    if (g->log == NULL) return;
+
+    journal_append(g->log, type, a, b, payload, length);
+    if (journal_wants_snapshot(g->log)) snapshot_game(g);
+}
+
+// Changes a player's score, recording the change.
+static void add_score(game *g, int p, int points) {
+    update_score(&g->players, p, points);
+    log_change(g, JOURNAL_SCORE, p, points, NULL, 0);
+}
+
+// Registers a player with a score of 0, recording the join.
+int game_join(game *g, const char *name) {
+    int p = add_player(&g->players, name);
+    if (p != -1) log_change(g, JOURNAL_JOIN, 0, 0, name, strlen(name));
+    return p;
+}
+
+// Starts a game over with every player removed, on a newly drawn board if draw
+// is set and boards are drawn, else on the whole bank unanswered; returns true
+// if the board was drawn.
+static bool restart_game(game *g, bool draw) {
+    bool drawn = start_game(g, draw);
+    buzz_close(&g->buzzes);
+    g->pending_question = -1;
+    g->pending_player = -1;
+    g->status = GAME_RUNNING;
+    g->num_waiting = 0;
+    g->num_attempted = 0;
+    g->turn_deadline = g->question_deadline = 0;
+    return drawn;
+}
+
+// Starts the game over on a newly drawn board, or the same board unanswered,
+// with every player removed.
+void game_reset(game *g) {
+    bool drawn = restart_game(g, true);
+    log_change(g, JOURNAL_RESET, 0, 0, NULL, 0);
+    if (drawn) {
+        log_change(g, JOURNAL_BOARD, g->board.num_cells, 0, (const char *)g->board.cells,
+                   g->board.num_cells * sizeof(int32_t));
+    }
+}
+
+// Attaches a journal to a game, recording a drawn board at once with a snapshot.
+void game_attach(game *g, journal *j) {
+    g->log = j;
+    if (g->board.cells != NULL) snapshot_game(g);
+}
+
+// Prints the help text.
+void game_help(game *g) {
+    if (g->out) fprintf(g->out, "%s\n", help);
+}
+
+// Returns true if a player has already answered or passed the open question.
+static bool has_attempted(const game *g, int p) {
+    for (int i = 0; i < g->num_attempted; i++) {
+        if (g->attempted[i] == p) return true;
+    }
+    return false;
+}
+
+// Records that a player has answered or passed the open question.
+static void add_attempt(game *g, int p) {
+    if (g->num_attempted == g->attempted_capacity) {
+        int capacity = g->attempted_capacity ? g->attempted_capacity * 2 : 8;
+        g->attempted = arena_realloc(&g->arena, g->attempted, g->attempted_capacity * sizeof(int),
+                                     capacity * sizeof(int));
+        g->attempted_capacity = capacity;
+    }
+    g->attempted[g->num_attempted++] = p;
+}
+
+// Gives a player the answer window, starting their turn's clock if turns are timed.
+static void start_turn(game *g, int p) {
+    g->version++;
+    g->pending_player = p;
+    g->turn_start = monotonic_ns();
+    g->turn_deadline = g->rules.turn_timeout ? g->turn_start + g->rules.turn_timeout : 0;
+}
+
+// Exports an event on the open question, timed from the pick or the start of
+// the turn, if events are being recorded.
+static void record_event(game *g, event_type type, int p, int delta) {
+    if (!events_recording()) return;
+
+    int q = g->pending_question;
+    events_record(type, g->id, category_name(bank.questions[q].category), bank.questions[q].value,
+                  p != -1 ? player_name(&g->players, p) : NULL, delta, type == EVENT_PICK ? 0 : g->turn_start);
+}
+
+// Clears the open question, its buzzer round and its deadlines.
+static void clear_question(game *g) {
+    buzz_close(&g->buzzes);
+    g->pending_question = -1;
+    g->pending_player = -1;
+    g->num_waiting = 0;
+    g->num_attempted = 0;
+    g->turn_deadline = g->question_deadline = 0;
+}
+
+// Marks the pending question answered, closes its buzzer round and ends the
+// game once the board is cleared.
+static void close_question(game *g) {
+    int q = g->pending_question;
+
+    mark_answered(&g->board, q);
+    clear_question(g);
+
+    // If all questions have been answered, the game is over
+    if (questions_remaining(&g->board) == 0) {
+        g->status = GAME_OVER;
+    }
+    log_change(g, JOURNAL_ANSWERED, q, 0, NULL, 0);
+}
+
+/**
+ * Moves a game onto the bank its thread has just adopted in place of old. The
+ * board is rebuilt with the questions answered so far marked again, matched by
+ * category and value, and the open question is carried over, or dropped if the
+ * new bank no longer has it. Players and scores are kept. A journaled game
+ * starts its journal over from a snapshot on the new bank.
+ *
+ * The board, players and attempts are rebuilt in fresh arena blocks and the
+ * old blocks freed, so a game reloaded many times does not grow its arena.
+ *
+ * @param g The game.
+ * @param old The bank the game was played on.
+ * @return The status of the game, GAME_OVER if the new board has nothing left to play.
+ */
+game_status game_rebase(game *g, const question_bank *old) {
+    // The tables are read from the old blocks while their copies are allocated
+    arena blocks = g->arena;
+    arena_init(&g->arena);
+    rebase_board(&g->board, old);
+    copy_players(&g->players);
+    if (g->attempted != NULL) {
+        int *attempted = arena_alloc(&g->arena, g->attempted_capacity * sizeof(int));
+        memcpy(attempted, g->attempted, g->num_attempted * sizeof(int));
+        g->attempted = attempted;
+    }
+    arena_free(&blocks);
+
+    if (g->pending_question != -1) {
+        int q = rebase_question(old, g->pending_question);
+        if (q == -1) {
+            clear_question(g);
+            if (g->out) fprintf(g->out, "The open question was removed from the bank.\n");
         } else {
-            printf("%i. ", i + 1);
+            g->pending_question = q;
         }
+    }
+
+    if (g->status == GAME_RUNNING && questions_remaining(&g->board) == 0) {
+        g->status = GAME_OVER;
+    }
+    g->version++;
+    if (g->log != NULL) {
+        journal_buffer records = game_records(g);
+        journal_rebase(g->log, bank_fingerprint(), &records);
+    }
+
+    if (g->out) {
+        fprintf(g->out, "The question bank was reloaded: %u questions in %u categories.\n", bank.num_questions,
+                bank.num_categories);
+    }
+    return g->status;
+}
+
+// Closes the open buzzer question once every player has tried it, revealing the answer.
+static bool close_if_exhausted(game *g) {
+    if (g->num_attempted < g->players.num_players) return false;
+
+    if (g->out) fprintf(g->out, "Nobody got it. The correct answer is: %s\n", question_answer(g->pending_question));
+    close_question(g);
+    return true;
+}
+
+// Ends the current player's turn at a buzzer question and moves on to the next
+// player who buzzed in, or closes the question if everyone has had a turn.
+static void next_turn(game *g) {
+    add_attempt(g, g->pending_player);
+    g->pending_player = -1;
+    g->turn_deadline = 0;
+
+    if (!close_if_exhausted(g)) {
+        game_poll(g);
+        if (g->pending_player == -1 && g->out) fprintf(g->out, "Buzz in with: buzz [user]\n");
+    }
+}
+
+/**
+ * Handles the answer to the pending question: scores it, marks the question
+ * answered and ends the game once the board is cleared. In a buzzer round a
+ * wrong answer costs the question's value and passes the question on to the
+ * next player who buzzed in.
+ */
+static void answer_line(game *g, char *line) {
+    int q = g->pending_question;
+    int p = g->pending_player;
+    int value = bank.questions[q].value;
+
+    // Fold case, punctuation and spacing in one pass; a blank line is ignored
+    char normalized[MAX_LEN];
+    size_t len = normalize_text(line, strlen(line), normalized);
+    if (len == 0) return;
+
+    // Check if the answer is phrased as a question, such as "What is" or "Who are"
+    bool phrased = true;
+    size_t phrase = question_phrase(normalized);
+    if (phrase == 0 && g->interactive) {
+        // Prompt the user to re-enter the answer
+        if (g->out) {
+            fprintf(g->out, "The correct form for your response would be 'What is...' or 'Who is...'? Please try again.\n");
+            fprintf(g->out, "Enter your answer: ");
+        }
+        return;
+    } else if (phrase == 0) {
+        phrased = false; // Replays take the answer as given and score it as wrong
+    }
+
+    // Validate the body of the answer, after the phrase and any leading article
+    const char *body = normalized + phrase;
+    len -= phrase;
+    size_t article = leading_article(body, len);
+
+    uint64_t start = stats_now();
+    bool correct = phrased && answer_matches(q, body + article, len - article);
+    stats_record(STAT_ANSWER, start);
+    stats_count(correct ? STAT_CORRECT : STAT_INCORRECT);
+    record_event(g, correct ? EVENT_CORRECT : EVENT_INCORRECT, p, correct ? value : g->rules.buzzer ? -value : 0);
+
+    if (correct) {
+        if (g->out) fprintf(g->out, "Correct answer! User %s earned %d points.\n", player_name(&g->players, p), value);
         
-        printf("Player: %s, Score: $%i\n", players[i].name, players[i].score);
+        // Update player's score
+        add_score(g, p, value);
+    } else if (g->rules.buzzer) {
+        if (g->out) fprintf(g->out, "Incorrect answer! User %s loses %d points.\n", player_name(&g->players, p), value);
+        add_score(g, p, -value);
+
+        // Give the question to the next player in line, if anyone is left to try it
+        next_turn(g);
+        return;
+    } else if (g->out) {
+        fprintf(g->out, "Incorrect answer! The correct answer is: %s\n", question_answer(q));
+    }
+
+    // Mark the question as answered
+    close_question(g);
+}
+
+/**
+ * Handles pick [category] [value] [user]: resolves the player and the question
+ * once, then shows the question and waits for the answer on the next line.
+ */
+static void cmd_pick(game *g, token *args) {
+    char *category = args[0].start;
+    char *user = args[2].start;
+
+    // Find the player handle by name
+    int playerIndex = find_player(&g->players, user);
+
+    // Print an error message if the player is not found
+    if (playerIndex == -1) {
+        if (g->out) fprintf(g->out, "Invalid player \"%s\". Please try again.\n", user);
+        return;
+    }
+
+    // Only one question can be open at a time
+    if (g->pending_question != -1) {
+        if (g->out) fprintf(g->out, "Another question is still open.\n");
+        return;
+    }
+
+    // Parse the value straight from its token, skipping the dollar sign (if any)
+    int value = parse_value(args[1].start, args[1].len);
+    if (value == -1) {
+        if (g->out) fprintf(g->out, "Invalid value \"%s\". Please try again.\n", args[1].start);
+        return;
+    }
+
+    // Resolve the question once; the handle is used for display, answered-check and validation
+    uint64_t start = stats_now();
+    int q = find_question(category, value);
+    stats_record(STAT_LOOKUP, start);
+    if (q == -1) {
+        if (g->out) fprintf(g->out, "Invalid question \"%s $%d\". Please try again.\n", category, value);
+        return;
+    }
+    if (!on_board(&g->board, q)) {
+        if (g->out) fprintf(g->out, "\"%s $%d\" is not on the board.\n", category, value);
+        return;
+    }
+
+    // Reject picks from categories with nothing left on the board
+    if (category_remaining(&g->board, bank.questions[q].category) == 0) {
+        if (g->out) fprintf(g->out, "All questions in \"%s\" have been answered.\n", category);
+        return;
+    }
+
+    // Check if the question has already been answered
+    if (already_answered(&g->board, q)) {
+        if (g->out) fprintf(g->out, "Question already answered.\n");
+        return;
     }
+
+    // Display the question and wait for the answer, or for the buzzers in a buzzer round
+    g->pending_question = q;
+    g->turn_start = monotonic_ns();
+    g->question_deadline = g->rules.question_timeout ? g->turn_start + g->rules.question_timeout : 0;
+    record_event(g, EVENT_PICK, playerIndex, 0);
+    if (g->rules.buzzer) {
+        if (g->out) {
+            start = stats_now();
+            display_question(g->out, q);
+            fprintf(g->out, "Buzz in with: buzz [user]\n");
+            stats_record(STAT_RENDER, start);
+        }
+        g->pending_player = -1;
+        buzz_open(&g->buzzes);
+        log_change(g, JOURNAL_PICK, q, -1, NULL, 0);
+        return;
+    }
+
+    if (g->out) {
+        start = stats_now();
+        display_question(g->out, q);
+        fprintf(g->out, "Enter your answer: ");
+        stats_record(STAT_RENDER, start);
+    }
+    start_turn(g, playerIndex);
+    log_change(g, JOURNAL_PICK, q, playerIndex, NULL, 0);
+}
+
+// Handles exit: ends the game without showing the results.
+static void cmd_exit(game *g, token *args) {
+    (void)args;
+    g->status = GAME_EXIT;
+}
+
+// Handles help: lists the available commands.
+static void cmd_help(game *g, token *args) {
+    (void)args;
+    game_help(g);
+}
+
+// Handles display: shows the board and the player scores.
+static void cmd_display(game *g, token *args) {
+    (void)args;
+    if (g->out) {
+        uint64_t start = stats_now();
+        display_categories(g->out, &g->board); // Show available categories and questions
+        print_players(g->out, &g->players); // Show player scores
+        stats_record(STAT_RENDER, start);
+    }
+}
+
+// Handles top [count]: shows the leaders, 10 unless a count is given.
+static void cmd_top(game *g, token *args) {
+    int k = args[0].start != NULL ? parse_count(&args[0]) : 10;
+    if (g->out == NULL) return;
+
+    if (k <= 0) {
+        fprintf(g->out, "Invalid count \"%s\". Please try again.\n", args[0].start);
+        return;
+    }
+
+    uint64_t start = stats_now();
+    print_top_players(g->out, &g->players, k);
+    stats_record(STAT_RENDER, start);
+}
+
+// Handles stats: shows the counters and command latencies of the whole process.
+static void cmd_stats(game *g, token *args) {
+    (void)args;
+    if (g->out) stats_print(g->out);
+}
+
+/**
+ * Handles search [words]: lists the questions whose text or category contain
+ * every word, a word ending in '*' standing for any word it begins,
+ * with the questions already answered on this board marked.
+ */
+static void cmd_search(game *g, token *args) {
+    char query[MAX_LEN];
+    size_t len = 0;
+    int32_t results[SEARCH_RESULTS + 1];
+
+    // The tokens are rejoined so the query is split the way the index was built
+    for (int i = 0; i < MAX_TOKENS - 1 && args[i].start != NULL; i++) {
+        if (len + args[i].len + 1 >= sizeof(query)) break;
+        if (len > 0) query[len++] = ' ';
+        memcpy(query + len, args[i].start, args[i].len);
+        len += args[i].len;
+    }
+    query[len] = '\0';
+
+    uint64_t start = stats_now();
+    int found = search_questions(query, results, SEARCH_RESULTS + 1);
+    stats_record(STAT_SEARCH, start);
+    if (g->out == NULL) return;
+
+    if (found == 0) {
+        fprintf(g->out, "No questions match \"%s\".\n", query);
+        return;
+    }
+    for (int i = 0; i < found && i < SEARCH_RESULTS; i++) {
+        int q = results[i];
+        fprintf(g->out, "%s $%d: %s%s\n", category_name(bank.questions[q].category), bank.questions[q].value,
+                bank.strings + bank.texts[q].question, already_answered(&g->board, q) ? " (answered)" : "");
+    }
+    if (found > SEARCH_RESULTS) fprintf(g->out, "Only the first %d matches are shown.\n", SEARCH_RESULTS);
+}
+
+// Handles rank [user]: shows where a player stands.
+static void cmd_rank(game *g, token *args) {
+    int p = find_player(&g->players, args[0].start);
+    if (g->out == NULL) return;
+
+    if (p == -1) {
+        fprintf(g->out, "Invalid player \"%s\". Please try again.\n", args[0].start);
+    } else {
+        fprintf(g->out, "Player %s is ranked %d of %d with $%d.\n", args[0].start, player_rank(&g->players, p),
+                g->players.num_players, g->players.players[p].score);
+    }
+}
+
+// Handles join [user]: registers another player mid-game.
+static void cmd_join(game *g, token *args) {
+    if (game_join(g, args[0].start) == -1) {
+        if (g->out) fprintf(g->out, "Player \"%s\" already exists.\n", args[0].start);
+    } else if (g->out) {
+        fprintf(g->out, "Player %s joined the game.\n", args[0].start);
+    }
+}
+
+/**
+ * Looks up the player named by a buzz or pass command and checks that they can
+ * still try the open buzzer question.
+ *
+ * @return The player handle, or -1 after reporting why the player cannot take part.
+ */
+static int buzzer_player(game *g, const char *user) {
+    int p = find_player(&g->players, user);
+
+    if (!g->rules.buzzer) {
+        if (g->out) fprintf(g->out, "Buzzer rounds are not enabled.\n");
+    } else if (p == -1) {
+        if (g->out) fprintf(g->out, "Invalid player \"%s\". Please try again.\n", user);
+    } else if (g->pending_question == -1) {
+        if (g->out) fprintf(g->out, "No question is open.\n");
+    } else if (has_attempted(g, p)) {
+        if (g->out) fprintf(g->out, "Player %s has already had a turn at this question.\n", user);
+    } else {
+        return p;
+    }
+    return -1;
+}
+
+// Handles buzz [user]: queues the player for an answer window on the open question.
+static void cmd_buzz(game *g, token *args) {
+    int p = buzzer_player(g, args[0].start);
+    if (p == -1) return;
+
+    if (!game_buzz(g, p, monotonic_ns())) {
+        if (g->out) fprintf(g->out, "The buzzer is not accepting buzzes.\n");
+        return;
+    }
+    game_poll(g);
+}
+
+// Handles pass [user]: the player gives up on the open question.
+static void cmd_pass(game *g, token *args) {
+    int p = buzzer_player(g, args[0].start);
+    if (p == -1) return;
+
+    add_attempt(g, p);
+    record_event(g, EVENT_PASS, p, 0);
+    if (g->out) fprintf(g->out, "Player %s passes.\n", args[0].start);
+    close_if_exhausted(g);
 }
 
-int main() {
-    // Flag to check if all questions have been answered    
-    bool allAnswered = false;
+// A command handler; args holds the tokens after the command word, padded with
+// empty tokens (NULL start) up to MAX_TOKENS - 1
+typedef void (*command_handler)(game *g, token *args);
 
-    // An array of 4 players, may need to be a pointer if you want it set dynamically
-    player players[NUM_PLAYERS];
-    
-    // Input buffer and and commands
-    char buffer[BUFFER_LEN]; // Buffer for reading input
-    char *tokens[BUFFER_LEN]; // Array to hold tokenized input for command processing
+// An entry of the command dispatch table
+typedef struct {
+    const char *name;
+    size_t len;
+    int min_args;
+    command_handler handler;
+} command;
 
-    // Initial setup: prompt for player names and initialize their scores
-    for (int i = 0; i < NUM_PLAYERS; i++) {
-        printf("Enter name for player %d: ", i + 1);
-        fgets(buffer, BUFFER_LEN, stdin);
+// Perfect hash of a command word from its first two characters and its length.
+// It has no collisions over the command set below; a new command that collides
+// with an existing one is reported by the compiler as an overwritten initializer.
+#define COMMAND_SLOTS 64
+#define COMMAND_SLOT(a, b, len) ((((unsigned)(a)) * 3 + (unsigned)(b) + (unsigned)(len) * 7) & (COMMAND_SLOTS - 1))
+#define COMMAND(a, b, name, min_args, handler) \
+    [COMMAND_SLOT(a, b, sizeof(name) - 1)] = { name, sizeof(name) - 1, min_args, handler }
 
-        strtok(buffer, "\n"); // Remove trailing newline
-        strcpy(players[i].name, buffer);
-        players[i].score = 0; // initialize each of the players in the array
+// Dispatch table of the commands, indexed by COMMAND_SLOT of the command word
+static const command commands[COMMAND_SLOTS] = {
+    COMMAND('b', 'u', "buzz", 1, cmd_buzz),
+    COMMAND('d', 'i', "display", 0, cmd_display),
+    COMMAND('e', 'x', "exit", 0, cmd_exit),
+    COMMAND('h', 'e', "help", 0, cmd_help),
+    COMMAND('j', 'o', "join", 1, cmd_join),
+    COMMAND('p', 'a', "pass", 1, cmd_pass),
+    COMMAND('p', 'i', "pick", 3, cmd_pick),
+    COMMAND('r', 'a', "rank", 1, cmd_rank),
+    COMMAND('s', 'e', "search", 1, cmd_search),
+    COMMAND('s', 't', "stats", 0, cmd_stats),
+    COMMAND('t', 'o', "top", 0, cmd_top),
+};
+
+// Looks up a command word in the dispatch table; returns NULL if it is not a command.
+static const command *find_command(const token *word) {
+    if (word->len < 2) return NULL;
+
+    const command *c = &commands[COMMAND_SLOT(word->start[0], word->start[1], word->len)];
+    if (c->handler == NULL || c->len != word->len || memcmp(c->name, word->start, word->len) != 0) {
+        return NULL;
     }
+    return c;
+}
 
-    // Game setup: display intro and initialize questions
-    initialize_game();
-    print_players(players, NUM_PLAYERS);
+/**
+ * Processes one line of input: the answer to a pending question, or a command.
+ *
+ * @param g The game.
+ * @param line The input line; it is modified in place.
+ * @return GAME_RUNNING while the game goes on, GAME_OVER once every question has
+ *         been answered, or GAME_EXIT if the exit command was given.
+ */
+game_status game_line(game *g, char *line) {
+    token tokens[MAX_TOKENS] = { { NULL, 0 } }; // Tokenized input for command processing
 
-    // Help command details
-    char* help = "Available commands:\n* display\n* exit\n* pick [category] [value] [user]\n  e.g. pick databases 100 User1";
-    printf("%s\n", help);
+    if (g->status != GAME_RUNNING) return g->status;
+    uint64_t start = stats_now();
 
-    // Main game loop: process user commands until all questions are answered or user exits
-    while (fgets(buffer, BUFFER_LEN, stdin) != NULL) {
-        tokenize(buffer, tokens, BUFFER_LEN); // Tokenize the user input for command processing
-        if (tokens[0] == NULL) continue; // Skip empty input
+    if (g->pending_player != -1) {
+        answer_line(g, line);
+    } else {
+        int count = tokenize(line, tokens, MAX_TOKENS - 1); // Keep the last token empty as padding
+        if (count == 0) return g->status; // Skip empty input
 
         // Command processing
-        if (strcmp(tokens[0], "exit") == 0) {
-            break; // Exit the game loop
-        } else if (strcmp(tokens[0], "help") == 0) {
-            printf("%s\n", help); // Display help information
-        } else if (strcmp(tokens[0], "display") == 0) {
-            display_categories(); // Show available categories and questions
-            print_players(players, NUM_PLAYERS); // Show player scores
-        } else if (strcmp(tokens[0], "pick") == 0 && tokens[1] != NULL && tokens[2] != NULL && tokens[3] != NULL) {
-            // If the user picks a question
-            char *category = tokens[1];
-            char *user = tokens[3];
-
-            // Find the player index by name
-            int playerIndex = -1;
-            for (int i = 0; i < NUM_PLAYERS; i++) {
-                if (strcmp(players[i].name, user) == 0) {
-                    playerIndex = i;
-                    break;
-                }
-            }
-
-            // Print an error message if the player is not found
-            if (playerIndex == -1) {
-                printf("Invalid player \"%s\". Please try again.\n", user);
-                continue;
-            }
-
-            // Remove the dollar sign from the value (if any)
-            tokens[2] = strtok(tokens[2], "$");
-            int value = atoi(tokens[2]);
-
-            // Check if the question has already been answered
-            if (!already_answered(category, value)) {
-                char answer[BUFFER_LEN] = { 0 };
-                char* trimmedAnswer;
-
-                // Display the question
-                display_question(category, value);
-                printf("Enter your answer: ");
-
-                // Get the user's answer
-                while (fgets(answer, BUFFER_LEN, stdin) != NULL) {
-                    // Trim leading and trailing whitespace
-                    stringToLower(answer);
-                    trimmedAnswer = trim(answer);
-                    if (trimmedAnswer[0] == '\0') continue;
-
-                    // Check if the answer starts with "What is" or "Who is"
-                    if (strncmp(trimmedAnswer, WHAT_IS, strlen(WHAT_IS)) == 0) {
-                        trimmedAnswer = trimmedAnswer + strlen(WHAT_IS);
-                        break;
-                    } else if (strncmp(trimmedAnswer, WHO_IS, strlen(WHO_IS)) == 0) {
-                        trimmedAnswer = trimmedAnswer + strlen(WHO_IS);
-                        break;
-                    } else {
-                        // Prompt the user to re-enter the answer
-                        printf("The correct form for your response would be 'What is...' or 'Who is...'? Please try again.\n");
-                        printf("Enter your answer: ");
-                    }
-                }
-
-                // Trim leading and trailing whitespace from the answer
-                trimmedAnswer = trim(trimmedAnswer);
-                
-                // Validate the answer
-                ValidationResult ans = valid_answer(category, value, trimmedAnswer);
-                if (ans.valid) {
-                    printf("Correct answer! User %s earned %d points.\n", user, value);
-                    
-                    // Update player's score
-                    players[playerIndex].score += value;
-                } else {
-                    printf("Incorrect answer! The correct answer is: %s\n", questions[ans.question].answer);
-                }
-
-                // Mark the question as answered
-                questions[ans.question].answered = true;
-
-                // Reset the all answered flag to true
-                allAnswered = true;
-
-                // Check if all questions have been answered
-                for (int i = 0; i < NUM_QUESTIONS; i++) {
-                    if (!questions[i].answered) {
-                        allAnswered = false;
-                    }
-                }
-
-                // If all questions have been answered, display the final results and exit
-                if (allAnswered) { break; }
-            } else {
-                printf("Question already answered.\n");
-            }
+        const command *c = find_command(&tokens[0]);
+        if (c != NULL && count - 1 >= c->min_args) {
+            c->handler(g, tokens + 1);
         } else {
-            printf("Invalid command.\n%s\n", help); // Handle unrecognized commands
+            stats_count(STAT_INVALID);
+            if (g->out) fprintf(g->out, "Invalid command.\n%s\n", help); // Handle unrecognized commands
+        }
+    }
+
+    stats_record(STAT_COMMAND, start);
+    return g->status;
+}
+
+/**
+ * Buzzes in for the open question. Only the lock-free arrival queue is touched,
+ * so player input threads may call this concurrently with each other and with
+ * the game thread; the game thread picks the buzz up in game_poll.
+ *
+ * @param g The game.
+ * @param p The handle of the player buzzing in.
+ * @param time When the player buzzed, from monotonic_ns.
+ * @return true if the buzz was queued, false if no buzzer round is open.
+ */
+bool game_buzz(game *g, int p, uint64_t time) {
+    return buzz_press(&g->buzzes, p, time);
+}
+
+/**
+ * Collects the buzzes that have arrived and, unless a player is already
+ * answering, opens an answer window for the earliest one. Buzzes are kept in
+ * the order they were pressed; repeats and players who already had their turn
+ * are dropped.
+ *
+ * When buzzes come from several input threads, a press stamped just before the
+ * earliest one may not have reached the queue yet, so with a buzz_settle rule
+ * the earliest buzz only gets its window once that long has passed since it
+ * was pressed; game_deadline reports when, and game_tick grants it.
+ *
+ * @param g The game.
+ */
+void game_poll(game *g) {
+    buzz arrived[BUZZ_CAPACITY];
+    int count = buzz_drain(&g->buzzes, arrived, BUZZ_CAPACITY - g->num_waiting);
+
+    for (int i = 0; i < count; i++) {
+        int p = arrived[i].player;
+        bool queued = p == g->pending_player || has_attempted(g, p);
+        for (int j = 0; j < g->num_waiting && !queued; j++) {
+            queued = g->waiting[j].player == p;
         }
+        if (queued) continue;
+
+        // Insert by time; a late drain may hold buzzes pressed before ones already waiting.
+        int j = g->num_waiting++;
+        while (j > 0 && g->waiting[j - 1].time > arrived[i].time) {
+            g->waiting[j] = g->waiting[j - 1];
+            j--;
+        }
+        g->waiting[j] = arrived[i];
+    }
+
+    if (g->pending_question == -1 || g->pending_player != -1 || g->num_waiting == 0) return;
+    if (g->rules.buzz_settle && monotonic_ns() < g->waiting[0].time + g->rules.buzz_settle) return;
+
+    start_turn(g, g->waiting[0].player);
+    g->num_waiting--;
+    memmove(g->waiting, g->waiting + 1, g->num_waiting * sizeof(buzz));
+
+    if (g->out) {
+        fprintf(g->out, "Player %s buzzed in.\n", player_name(&g->players, g->pending_player));
+        fprintf(g->out, "Enter your answer: ");
+    }
+}
+
+// Returns the earliest pending deadline of the game, or 0 if nothing is timed.
+uint64_t game_deadline(const game *g) {
+    uint64_t turn = g->turn_deadline, question = g->question_deadline;
+    if (g->rules.buzz_settle && g->pending_player == -1 && g->num_waiting > 0) {
+        turn = g->waiting[0].time + g->rules.buzz_settle; // The earliest buzz gets its window
+    }
+    if (turn == 0) return question;
+    if (question == 0) return turn;
+    return turn < question ? turn : question;
+}
+
+/**
+ * Applies the deadlines that have passed. When the question runs out of time it
+ * is forfeited: nobody scores, the answer is revealed and the question is marked
+ * answered. When a turn runs out, the question is forfeited as well, except in a
+ * buzzer round, where the turn passes to the next player who buzzed in. A buzz
+ * that has settled gets its answer window.
+ *
+ * @param g The game.
+ * @param now The current time, from monotonic_ns.
+ * @return The status of the game afterwards.
+ */
+game_status game_tick(game *g, uint64_t now) {
+    if (g->status != GAME_RUNNING || g->pending_question == -1) return g->status;
+
+    bool question_expired = g->question_deadline != 0 && now >= g->question_deadline;
+    bool turn_expired = g->turn_deadline != 0 && now >= g->turn_deadline;
+
+    if (question_expired || turn_expired) {
+        stats_count(STAT_TIMEOUT);
+        record_event(g, EVENT_TIMEOUT, g->pending_player, 0);
+    }
+
+    if (question_expired || (turn_expired && !g->rules.buzzer)) {
+        if (g->out) fprintf(g->out, "\nTime is up! The correct answer is: %s\n", question_answer(g->pending_question));
+        close_question(g);
+    } else if (turn_expired) {
+        if (g->out) fprintf(g->out, "\nTime is up for player %s.\n", player_name(&g->players, g->pending_player));
+        next_turn(g);
+    }
+
+    if (g->rules.buzz_settle) game_poll(g);
+    return g->status;
+}
+
+// Returns true if a recovered board holds only questions of the bank.
+static bool valid_cells(const char *payload, int n) {
+    for (int i = 0; i < n; i++) {
+        int32_t q;
+        memcpy(&q, payload + i * sizeof(int32_t), sizeof(q));
+        if (q < 0 || (uint32_t)q >= bank.num_questions) return false;
+    }
+    return true;
+}
+
+/**
+ * Applies a journal record recovered by journal_open to a game, silently and
+ * without recording it again (the game's journal is attached after recovery).
+ * A recovered pick reopens the question with fresh time limits; in a buzzer
+ * round the buzzers open again for everyone.
+ *
+ * @param ctx The game.
+ * @param r The record.
+ * @param payload The record's payload, r->length bytes.
+ */
+void game_apply(void *ctx, const journal_record *r, const char *payload) {
+    game *g = ctx;
+    FILE *out = g->out;
+    char name[MAX_LEN];
+
+    g->out = NULL;
+    switch (r->type) {
+    case JOURNAL_JOIN:
+        if (r->length < MAX_LEN) {
+            memcpy(name, payload, r->length);
+            name[r->length] = '\0';
+            add_player(&g->players, name);
+        }
+        break;
+    case JOURNAL_SCORE:
+        if (r->a >= 0 && r->a < g->players.num_players) update_score(&g->players, r->a, r->b);
+        break;
+    case JOURNAL_PICK:
+        if (r->a < 0 || (uint32_t)r->a >= bank.num_questions || !on_board(&g->board, r->a) ||
+            already_answered(&g->board, r->a)) {
+            break;
+        }
+        g->pending_question = r->a;
+        g->turn_start = monotonic_ns();
+        g->question_deadline = g->rules.question_timeout ? g->turn_start + g->rules.question_timeout : 0;
+        if (r->b >= 0 && r->b < g->players.num_players) {
+            start_turn(g, r->b);
+        } else {
+            g->pending_player = -1;
+            buzz_open(&g->buzzes);
+        }
+        break;
+    case JOURNAL_ANSWERED:
+        if (r->a < 0 || (uint32_t)r->a >= bank.num_questions) break;
+        g->pending_question = r->a;
+        close_question(g);
+        break;
+    case JOURNAL_RESET:
+        // Drawing again would use up questions of the deck; the board drawn follows as JOURNAL_BOARD
+        restart_game(g, false);
+        break;
+    case JOURNAL_BOARD:
+        if (r->a >= 0 && (size_t)r->a * sizeof(int32_t) == r->length && valid_cells(payload, r->a)) {
+            int32_t *cells = xmalloc((r->a + 1) * sizeof(int32_t));
+            memcpy(cells, payload, r->a * sizeof(int32_t));
+            set_board(&g->board, cells, r->a);
+            free(cells);
+        }
+        break;
+    default:
+        break;
+    }
+    g->out = out;
+}
+
+// Copies a name into a fixed-size scoreboard field, cutting it short if needed.
+static void publish_name(char *field, const char *name) {
+    size_t len = strlen(name);
+    if (len >= SCOREBOARD_NAME) len = SCOREBOARD_NAME - 1;
+    memcpy(field, name, len);
+    memset(field + len, 0, SCOREBOARD_NAME - len);
+}
+
+/**
+ * Publishes the game to a shared-memory scoreboard: the players in ranking
+ * order with their scores, the questions left in each category, the answered
+ * questions and the question being played. Only the game thread publishes, and
+ * it never waits for the spectators reading the scoreboard.
+ *
+ * @param g The game.
+ * @param sb The scoreboard, from scoreboard_create.
+ */
+void game_publish(const game *g, scoreboard *sb) {
+    int ranking[SCOREBOARD_PLAYERS];
+    int count = leaderboard_top(&g->players.ranking, SCOREBOARD_PLAYERS, ranking);
+    scoreboard_data *d = &sb->data;
+
+    scoreboard_begin(sb);
+    d->updates++;
+    d->status = g->status;
+    d->pending_question = g->pending_question;
+    d->pending_category = g->pending_question != -1 ? (int32_t)bank.questions[g->pending_question].category : -1;
+    d->pending_value = g->pending_question != -1 ? bank.questions[g->pending_question].value : 0;
+    d->pending_player = -1;
+    d->total_players = g->players.num_players;
+    d->num_players = count;
+    for (int i = 0; i < count; i++) {
+        int p = ranking[i];
+        publish_name(d->players[i].name, player_name(&g->players, p));
+        d->players[i].score = g->players.players[p].score;
+        d->players[i].rank = player_rank(&g->players, p);
+        if (p == g->pending_player) d->pending_player = i;
+    }
+
+    // A drawn board is published column by column, with its answered bitset by cell
+    const board_state *b = &g->board;
+    uint32_t categories = b->cells != NULL ? b->num_columns : bank.num_categories;
+    uint32_t questions = b->cells != NULL ? b->num_cells : bank.num_questions;
+    int32_t pending_category = d->pending_category;
+    d->num_categories = categories < SCOREBOARD_CATEGORIES ? categories : SCOREBOARD_CATEGORIES;
+    for (uint32_t c = 0; c < d->num_categories; c++) {
+        int category_id = b->cells != NULL ? (int)bank.questions[b->cells[b->column_start[c]]].category : (int)c;
+        publish_name(d->categories[c].name, category_name(category_id));
+        d->categories[c].remaining = category_remaining(b, category_id);
+        if (b->cells != NULL && category_id == pending_category) d->pending_category = c;
     }
 
-    // End of game: display final results
-    if (allAnswered) show_results(players, NUM_PLAYERS);
-    return EXIT_SUCCESS;
+    d->num_questions = questions < SCOREBOARD_QUESTIONS ? questions : SCOREBOARD_QUESTIONS;
+    d->questions_remaining = questions_remaining(&g->board);
+    memcpy(d->answered, g->board.answered, (d->num_questions + 63) / 64 * sizeof(uint64_t));
+    scoreboard_end(sb);
 }
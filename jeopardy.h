@@ -7,12 +7,147 @@
 #ifndef JEOPARDY_H_
 #define JEOPARDY_H_
 
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "buzzer.h"
+#include "journal.h"
+#include "scoreboard.h"
+#include "players.h"
+#include "questions.h"
+
 #define MAX_LEN 256
+#define MAX_TOKENS 8 // Tokens read from a command line; the rest of the line is ignored
+#define GAME_POOL_SIZE 256 // Released games a pool keeps for reuse
+
+// A token of an input line: a view of len bytes into the line, NUL-terminated in place
+typedef struct {
+    char *start;
+    size_t len;
+} token;
+
+// State of a game after processing a line of input
+typedef enum {
+    GAME_RUNNING,  // Waiting for the next command or answer
+    GAME_OVER,     // Every question has been answered
+    GAME_EXIT      // The exit command was given
+} game_status;
+
+// Rules a game is played by
+typedef struct {
+    bool buzzer;               // Questions go to the first player to buzz in, not to whoever picked them
+    uint64_t turn_timeout;     // Nanoseconds a player has to answer once it is their turn, 0 for no limit
+    uint64_t question_timeout; // Nanoseconds a picked question stays open, 0 for no limit
+    uint64_t buzz_settle;      // Nanoseconds the earliest buzz waits for earlier presses from other threads, 0 for none
+} game_rules;
+
+// A game on its own board of the shared question bank, driven one input line at a time.
+// Its players, board and other tables live in its own arena, which they point
+// to, so a game must stay where it was initialized
+typedef struct {
+    player_registry players;
+    board_state board;
+    FILE *out;             // Where game output is written, NULL to suppress it
+    bool interactive;      // Ask again for malformed answers instead of scoring them wrong
+    int pending_question;  // Question waiting for an answer, or -1
+    int pending_player;    // Player whose answer is awaited, or -1 while buzzers are open
+    game_status status;
+    game_rules rules;
+    buzz_queue buzzes;     // Arrivals of the open buzzer round
+    buzz waiting[BUZZ_CAPACITY]; // Buzzes drained but not yet given an answer window, in time order
+    int num_waiting;
+    int *attempted;        // Players who have answered or passed the open question
+    int num_attempted;
+    int attempted_capacity;
+    uint64_t turn_start;        // When the open question was picked or the current turn began (monotonic_ns)
+    uint64_t turn_deadline;     // When the current answer window runs out (monotonic_ns), 0 if none
+    uint64_t question_deadline; // When the open question is forfeited, 0 if none
+    journal *log;          // Journal the game's changes are recorded in, or NULL
+    uint64_t version;      // Incremented on every change to scores, board or turn
+    uint64_t id;           // Number of the game among those started by the process, for exported events
+    arena arena;           // Holds the players, board and attempts, freed all at once
+} game;
+
+// Games released by their players, kept with their arenas for the next games
+typedef struct {
+    game **games;
+    int num_games;
+    int capacity;
+} game_pool;
+
+// Trims leading and trailing whitespace in place, returning the start of the trimmed string
+extern char *trim(char *s);
 
 // Tokenizes user input into commands and parameters, facilitating command processing.
-extern void tokenize(char *input, char *tokens[], int maxTokens);
+// Returns the number of tokens, which are views into input
+extern int tokenize(char *input, token tokens[], int maxTokens);
 
 // Displays the final game results, showing player rankings and scores.
-extern void show_results(player *players, int num_players);
+extern void show_results(FILE *out, const player_registry *r);
+
+// Initializes a game with no players on a fresh board of the current bank,
+// drawn at random if boards are drawn (see deck.h)
+extern void game_init(game *g, FILE *out, bool interactive, const game_rules *rules);
+
+// Releases the memory held by a game
+extern void game_free(game *g);
+
+// Initializes an empty pool of games
+extern void game_pool_init(game_pool *pool);
+
+// Takes a game from a pool, or a new one if it is empty, initialized as by game_init
+extern game *game_acquire(game_pool *pool, FILE *out, bool interactive, const game_rules *rules);
+
+// Hands a game back to its pool, releasing everything it held at once
+extern void game_release(game_pool *pool, game *g);
+
+// Frees the games kept by a pool
+extern void game_pool_free(game_pool *pool);
+
+// Starts a game over with no players on a newly drawn board, or on the same
+// board unanswered if boards are not drawn
+extern void game_reset(game *g);
+
+// Registers a player; returns the player's handle, or -1 if the name is taken
+extern int game_join(game *g, const char *name);
+
+// Attaches a journal to a game, so its changes are recorded from then on
+extern void game_attach(game *g, journal *j);
+
+// Applies a recovered journal record to a game (a journal_apply for journal_open),
+// without printing anything or recording it again
+extern void game_apply(void *ctx, const journal_record *r, const char *payload);
+
+// Moves a game onto the bank its thread has just adopted (see bank_adopt) in
+// place of old, keeping the players, scores and the questions answered that the
+// new bank still has; returns the status of the game
+extern game_status game_rebase(game *g, const question_bank *old);
+
+// Publishes the game's scores and board to a shared-memory scoreboard
+extern void game_publish(const game *g, scoreboard *sb);
+
+// Prints the list of available commands
+extern void game_help(game *g);
+
+// Processes one line of input (a command, or the answer to a pending question)
+extern game_status game_line(game *g, char *line);
+
+// Buzzes in for the open question on behalf of a player; safe to call from any
+// thread while the game runs. Returns false if no buzzer round is open
+extern bool game_buzz(game *g, int p, uint64_t time);
+
+// Returns the earliest deadline of the game by the monotonic clock, or 0 if none
+// is pending: a turn or question running out, or a buzz settling
+extern uint64_t game_deadline(const game *g);
+
+// Forfeits the turn or question whose deadline has passed at time now; drivers
+// of timed games call it whenever the earliest deadline may have passed
+extern game_status game_tick(game *g, uint64_t now);
+
+// Gives the next answer window to the earliest buzz that has arrived, if no
+// window is open and the buzz has settled; the game thread calls it after
+// buzzes from other threads
+extern void game_poll(game *g);
 
-#endif /* JEOPARDY_H_ */
\ No newline at end of file
+#endif /* JEOPARDY_H_ */
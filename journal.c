@@ -0,0 +1,530 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Crash-safe game journal. Every change to a game (a player joining, a pick, a
+ * score change, a question being answered) is appended to a binary write-ahead
+ * log, so a game can be restored exactly after a crash or restart.
+ *
+ * Appending only copies the record into a memory buffer. A writer thread takes
+ * whatever has accumulated, writes it with one write call and makes it durable
+ * with one fdatasync, so while one batch is being synced the next one grows:
+ * the cost of a sync is shared by every record in the batch (group commit) and
+ * the game never waits for the disk.
+ *
+ * Every JOURNAL_SNAPSHOT_RECORDS records the game hands over a snapshot of its
+ * whole state, encoded as the records that rebuild it. The writer stores it in
+ * a separate file (written next to it and renamed into place) and then starts
+ * the log over, so recovery reads one compact snapshot plus a short log. Each
+ * snapshot has a generation number and the log records the generation it
+ * continues from; a log left over from before the latest snapshot is ignored,
+ * which keeps a crash between the two steps safe. Records carry a checksum, and
+ * a torn record at the end of the log (from a crash mid-write) is cut off.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "journal.h" // Include the journal structures and prototypes.
+#include "util.h"    // Allocation and hashing helpers.
+
+// Checksum of a record: everything after the checksum field, payload included.
+static uint32_t record_checksum(const journal_record *r, const char *payload) {
+    const size_t skip = sizeof(r->checksum);
+    uint32_t h = hash_string((const char *)r + skip, sizeof(journal_record) - skip);
+
+    // Continue the FNV-1a hash over the payload
+    for (size_t i = 0; i < r->length; i++) {
+        h ^= (unsigned char)payload[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Encodes a record at the end of a buffer.
+ *
+ * @param buf The buffer.
+ * @param type The kind of record.
+ * @param a The first field (see journal_type).
+ * @param b The second field.
+ * @param payload Bytes stored after the record, such as a player name, or NULL.
+ * @param length The number of payload bytes, at most 65535.
+ */
+void journal_put(journal_buffer *buf, journal_type type, int32_t a, int32_t b, const char *payload, size_t length) {
+    journal_record r;
+    memset(&r, 0, sizeof(r));
+    r.type = type;
+    r.length = length > UINT16_MAX ? UINT16_MAX : length;
+    r.a = a;
+    r.b = b;
+    r.checksum = record_checksum(&r, payload);
+
+    size_t needed = buf->size + sizeof(r) + r.length;
+    if (needed > buf->capacity) {
+        buf->capacity = needed * 2;
+        buf->data = xrealloc(buf->data, buf->capacity);
+    }
+    memcpy(buf->data + buf->size, &r, sizeof(r));
+    if (r.length) memcpy(buf->data + buf->size + sizeof(r), payload, r.length);
+    buf->size = needed;
+}
+
+// Writes a whole buffer, retrying short writes; returns 0 or -1 on error.
+static int write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// Reads a whole file; returns NULL if it does not exist or cannot be read.
+static char *read_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        if (errno != ENOENT) perror(path);
+        return NULL;
+    }
+
+    struct stat st;
+    char *data = NULL;
+    if (fstat(fd, &st) == 0) {
+        data = xmalloc(st.st_size ? st.st_size : 1);
+        *size = 0;
+        while (*size < (size_t)st.st_size) {
+            ssize_t n = read(fd, data + *size, st.st_size - *size);
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) break;
+            *size += n;
+        }
+    }
+
+    close(fd);
+    return data;
+}
+
+// Checks the header of a log or snapshot file.
+static bool header_ok(const char *data, size_t size, const char *magic) {
+    journal_header h;
+    if (size < sizeof(h)) return false;
+    memcpy(&h, data, sizeof(h));
+    return memcmp(h.magic, magic, sizeof(h.magic)) == 0 && h.version == JOURNAL_VERSION;
+}
+
+/**
+ * Applies the valid records of a log or snapshot body, in order, stopping at the
+ * first record that is truncated or fails its checksum, or at an END record.
+ *
+ * @param data The records.
+ * @param size The size of the records in bytes.
+ * @param apply Called for each record.
+ * @param ctx Passed to apply.
+ * @param end Set to the offset just past the last valid record.
+ * @param ended Set to whether an END record was reached.
+ * @return The number of records applied.
+ */
+static long replay(const char *data, size_t size, journal_apply apply, void *ctx, size_t *end, bool *ended) {
+    size_t offset = 0;
+    long count = 0;
+    *ended = false;
+
+    while (size - offset >= sizeof(journal_record)) {
+        journal_record r;
+        memcpy(&r, data + offset, sizeof(r));
+        const char *payload = data + offset + sizeof(r);
+
+        if (r.length > size - offset - sizeof(r) || record_checksum(&r, payload) != r.checksum) break;
+        offset += sizeof(r) + r.length;
+
+        if (r.type == JOURNAL_END) {
+            *ended = true;
+            break;
+        }
+        apply(ctx, &r, payload);
+        count++;
+    }
+
+    *end = offset;
+    return count;
+}
+
+// Writes the header of a log or snapshot file.
+static int write_header(int fd, const char *magic, uint32_t generation, uint64_t fingerprint) {
+    journal_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, magic, sizeof(h.magic));
+    h.version = JOURNAL_VERSION;
+    h.generation = generation;
+    h.fingerprint = fingerprint;
+    return write_all(fd, (const char *)&h, sizeof(h));
+}
+
+// Makes a rename in the directory of path durable.
+static void sync_directory(const char *path) {
+    const char *slash = strrchr(path, '/');
+    char *dir = slash ? strndup(path, slash == path ? 1 : (size_t)(slash - path)) : strdup(".");
+    int fd = open(dir, O_RDONLY | O_CLOEXEC);
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
+
+/**
+ * Writes a snapshot to a temporary file, syncs it and renames it over the
+ * previous snapshot, so a crash leaves either the old or the new one whole.
+ *
+ * @return 0 on success or -1 on error.
+ */
+static int write_snapshot(journal *j, journal_buffer *records, uint32_t generation, uint64_t fingerprint) {
+    size_t len = strlen(j->snapshot_path);
+    char *tmp_path = xmalloc(len + 5);
+    memcpy(tmp_path, j->snapshot_path, len);
+    memcpy(tmp_path + len, ".tmp", 5);
+
+    journal_put(records, JOURNAL_END, 0, 0, NULL, 0);
+
+    int status = -1;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd != -1) {
+        status = write_header(fd, SNAPSHOT_MAGIC, generation, fingerprint) == 0 &&
+                 write_all(fd, records->data, records->size) == 0 && fsync(fd) == 0 ? 0 : -1;
+        if (close(fd) != 0) status = -1;
+    }
+    if (status == 0 && rename(tmp_path, j->snapshot_path) != 0) status = -1;
+
+    if (status == 0) {
+        sync_directory(j->snapshot_path);
+    } else {
+        perror(tmp_path);
+        unlink(tmp_path);
+    }
+
+    free(tmp_path);
+    return status;
+}
+
+// Starts the log over, empty, continuing from the snapshot of the given generation.
+static int reset_log(journal *j, uint32_t generation, uint64_t fingerprint) {
+    if (ftruncate(j->fd, 0) != 0 || write_header(j->fd, JOURNAL_MAGIC, generation, fingerprint) != 0 ||
+        fdatasync(j->fd) != 0) {
+        perror(j->path);
+        return -1;
+    }
+    return 0;
+}
+
+// Gives up on journaling after a write error, releasing anyone waiting for a sync.
+static void journal_failed(journal *j) {
+    j->failed = true;
+    j->pending.size = 0;
+    j->durable = j->appended;
+    pthread_cond_broadcast(&j->synced);
+}
+
+/**
+ * Writer thread: writes the pending records in batches, one write and one
+ * fdatasync per batch, and stores snapshots as they are handed over.
+ */
+static void *writer(void *arg) {
+    journal *j = arg;
+    journal_buffer batch = { NULL, 0, 0 };
+
+    pthread_mutex_lock(&j->lock);
+    for (;;) {
+        while (!j->stopping && !j->snapshot_pending && j->pending.size == 0) {
+            pthread_cond_wait(&j->wake, &j->lock);
+        }
+
+        if (j->snapshot_pending) {
+            journal_buffer snapshot = j->snapshot;
+            uint32_t generation = j->generation + 1;
+            uint64_t covered = j->durable_after_snapshot;
+            uint64_t fingerprint = j->fingerprint;
+            memset(&j->snapshot, 0, sizeof(j->snapshot));
+            j->snapshot_pending = false;
+
+            pthread_mutex_unlock(&j->lock);
+            int status = write_snapshot(j, &snapshot, generation, fingerprint);
+            if (status == 0) status = reset_log(j, generation, fingerprint);
+            free(snapshot.data);
+            pthread_mutex_lock(&j->lock);
+
+            if (status != 0) {
+                journal_failed(j);
+            } else {
+                j->generation = generation;
+                if (covered > j->durable) j->durable = covered;
+                pthread_cond_broadcast(&j->synced);
+            }
+        } else if (j->pending.size > 0) {
+            // Swap buffers, so appends go on into the other one while this batch is written.
+            journal_buffer full = j->pending;
+            j->pending = batch;
+            batch = full;
+            uint64_t upto = j->appended;
+
+            pthread_mutex_unlock(&j->lock);
+            int status = write_all(j->fd, batch.data, batch.size) == 0 && fdatasync(j->fd) == 0 ? 0 : -1;
+            if (status != 0) perror(j->path);
+            batch.size = 0;
+            pthread_mutex_lock(&j->lock);
+
+            if (status != 0) {
+                journal_failed(j);
+            } else {
+                j->durable = upto;
+                pthread_cond_broadcast(&j->synced);
+            }
+        } else if (j->stopping) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&j->lock);
+
+    free(batch.data);
+    return NULL;
+}
+
+// Applies a recovery file's records, reporting a mismatched or damaged file.
+static long recover_file(const char *path, const char *data, size_t size, uint64_t fingerprint,
+                         journal_apply apply, void *ctx, size_t *end, bool *ended) {
+    journal_header h;
+    memcpy(&h, data, sizeof(h));
+    if (h.fingerprint != fingerprint) {
+        fprintf(stderr, "%s: journal was written for a different question bank\n", path);
+        return -1;
+    }
+
+    long count = replay(data + sizeof(h), size - sizeof(h), apply, ctx, end, ended);
+    *end += sizeof(h);
+    return count;
+}
+
+// Releases what journal_open set up before it failed; returns -1 to be returned.
+static long open_failed(journal *j) {
+    if (j->fd != -1) close(j->fd);
+    pthread_mutex_destroy(&j->lock);
+    pthread_cond_destroy(&j->wake);
+    pthread_cond_destroy(&j->synced);
+    free(j->path);
+    free(j->snapshot_path);
+    return -1;
+}
+
+/**
+ * Opens a journal, recovering the game it records: the latest snapshot is
+ * applied first, then the log written since. A torn record at the end of the
+ * log is cut off, and the log is then opened for appending. A log or snapshot
+ * that is not a journal of this version is refused rather than overwritten.
+ *
+ * @param j The journal to open.
+ * @param path The path of the log; the snapshot is kept next to it in path.snap.
+ * @param fingerprint Identifies the question bank; a journal written for another bank is refused.
+ * @param apply Called for each recovered record, in order.
+ * @param ctx Passed to apply.
+ * @return The number of records recovered, or -1 on error.
+ */
+long journal_open(journal *j, const char *path, uint64_t fingerprint, journal_apply apply, void *ctx) {
+    memset(j, 0, sizeof(*j));
+    j->fd = -1;
+    j->fingerprint = fingerprint;
+    j->path = xmalloc(strlen(path) + 1);
+    strcpy(j->path, path);
+    j->snapshot_path = xmalloc(strlen(path) + 6);
+    strcpy(j->snapshot_path, path);
+    strcat(j->snapshot_path, ".snap");
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->wake, NULL);
+    pthread_cond_init(&j->synced, NULL);
+
+    long recovered = 0;
+    uint32_t generation = 0;
+    size_t size = 0, end = 0;
+    bool ended;
+
+    // The snapshot comes first; without one the log starts from an empty game.
+    char *data = read_file(j->snapshot_path, &size);
+    if (data != NULL) {
+        long count = -1;
+        if (!header_ok(data, size, SNAPSHOT_MAGIC)) {
+            fprintf(stderr, "%s: not a journal snapshot\n", j->snapshot_path);
+        } else {
+            count = recover_file(j->snapshot_path, data, size, fingerprint, apply, ctx, &end, &ended);
+            if (count >= 0 && !ended) {
+                fprintf(stderr, "%s: damaged journal snapshot\n", j->snapshot_path);
+                count = -1;
+            }
+            memcpy(&generation, data + offsetof(journal_header, generation), sizeof(generation));
+        }
+        free(data);
+        if (count < 0) return open_failed(j);
+        recovered += count;
+    }
+
+    // Then the log, if it continues from that snapshot.
+    size_t valid = 0;
+    data = read_file(path, &size);
+    if (data != NULL && size > 0 && !header_ok(data, size, JOURNAL_MAGIC)) {
+        fprintf(stderr, "%s: not a journal\n", path);
+        free(data);
+        return open_failed(j);
+    }
+    if (data != NULL && size > 0) {
+        uint32_t log_generation;
+        memcpy(&log_generation, data + offsetof(journal_header, generation), sizeof(log_generation));
+
+        long count = 0;
+        if (log_generation > generation) {
+            fprintf(stderr, "%s: journal snapshot is missing\n", path);
+            count = -1;
+        } else if (log_generation == generation) {
+            count = recover_file(path, data, size, fingerprint, apply, ctx, &valid, &ended);
+        }
+        if (count < 0) {
+            free(data);
+            return open_failed(j);
+        }
+        recovered += count;
+
+        if (valid < size && valid > 0) {
+            fprintf(stderr, "%s: discarded %zu bytes of an incomplete record\n", path, size - valid);
+        }
+    }
+    free(data);
+
+    j->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (j->fd == -1) {
+        perror(path);
+        return open_failed(j);
+    }
+
+    j->generation = generation;
+    int status = valid > 0 ? ftruncate(j->fd, valid) : reset_log(j, generation, fingerprint);
+    if (status == 0) status = fdatasync(j->fd);
+    if (status != 0) {
+        perror(path);
+        return open_failed(j);
+    }
+
+    if (pthread_create(&j->thread, NULL, writer, j) != 0) {
+        fprintf(stderr, "%s: could not start the journal writer\n", path);
+        return open_failed(j);
+    }
+
+    return recovered;
+}
+
+/**
+ * Appends a record to the journal. The record is only copied into memory here;
+ * the writer thread makes it durable with the next batch.
+ *
+ * @param j The journal.
+ * @param type The kind of record.
+ * @param a The first field (see journal_type).
+ * @param b The second field.
+ * @param payload Bytes stored after the record, or NULL.
+ * @param length The number of payload bytes.
+ */
+void journal_append(journal *j, journal_type type, int32_t a, int32_t b, const char *payload, size_t length) {
+    pthread_mutex_lock(&j->lock);
+    if (!j->failed) {
+        bool idle = j->pending.size == 0;
+        journal_put(&j->pending, type, a, b, payload, length);
+        j->appended++;
+        j->since_snapshot++;
+        if (idle) pthread_cond_signal(&j->wake);
+    }
+    pthread_mutex_unlock(&j->lock);
+}
+
+// Returns true once enough records have been logged that a snapshot is due; the
+// writer thread may mark the journal failed, so the check is made under the lock.
+bool journal_wants_snapshot(journal *j) {
+    pthread_mutex_lock(&j->lock);
+    bool due = j->since_snapshot >= JOURNAL_SNAPSHOT_RECORDS && !j->failed;
+    pthread_mutex_unlock(&j->lock);
+    return due;
+}
+
+/**
+ * Hands a snapshot of the whole game state to the writer. Records still waiting
+ * to be written are dropped, since the snapshot already includes them; the
+ * writer stores the snapshot and then starts the log over.
+ *
+ * @param j The journal.
+ * @param records The state, encoded as records with journal_put; the journal
+ *        takes over the buffer and leaves records empty.
+ */
+void journal_snapshot(journal *j, journal_buffer *records) {
+    journal_rebase(j, j->fingerprint, records);
+}
+
+/**
+ * Hands the writer a snapshot of the game moved onto another question bank.
+ * The journal is identified with the new bank from the snapshot on, so after a
+ * crash it is recovered against the reloaded bank file.
+ *
+ * @param j The journal.
+ * @param fingerprint The fingerprint of the bank the snapshot refers to.
+ * @param records The state, as for journal_snapshot.
+ */
+void journal_rebase(journal *j, uint64_t fingerprint, journal_buffer *records) {
+    pthread_mutex_lock(&j->lock);
+    j->fingerprint = fingerprint;
+    free(j->snapshot.data);
+    j->snapshot = *records;
+    j->snapshot_pending = true;
+    j->pending.size = 0;
+    j->durable_after_snapshot = j->appended;
+    j->since_snapshot = 0;
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+
+    memset(records, 0, sizeof(*records));
+}
+
+// Waits until every record appended so far is on disk.
+void journal_sync(journal *j) {
+    pthread_mutex_lock(&j->lock);
+    uint64_t target = j->appended;
+    while (j->durable < target) {
+        pthread_cond_wait(&j->synced, &j->lock);
+    }
+    pthread_mutex_unlock(&j->lock);
+}
+
+// Syncs and closes the journal, stopping its writer thread.
+void journal_close(journal *j) {
+    journal_sync(j);
+
+    pthread_mutex_lock(&j->lock);
+    j->stopping = true;
+    pthread_cond_signal(&j->wake);
+    pthread_mutex_unlock(&j->lock);
+    pthread_join(j->thread, NULL);
+
+    close(j->fd);
+    pthread_mutex_destroy(&j->lock);
+    pthread_cond_destroy(&j->wake);
+    pthread_cond_destroy(&j->synced);
+    free(j->pending.data);
+    free(j->snapshot.data);
+    free(j->path);
+    free(j->snapshot_path);
+}
@@ -0,0 +1,109 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JOURNAL_MAGIC "JPDYJRNL"
+#define SNAPSHOT_MAGIC "JPDYSNAP"
+#define JOURNAL_VERSION 1
+#define JOURNAL_SNAPSHOT_RECORDS 4096 // Records logged between snapshots
+
+// Kinds of journal records
+typedef enum {
+    JOURNAL_JOIN = 1,      // A player joined; the payload is the name
+    JOURNAL_SCORE,         // a: player, b: points added to the score
+    JOURNAL_PICK,          // a: question, b: player (-1 for a buzzer round)
+    JOURNAL_ANSWERED,      // a: question, now answered
+    JOURNAL_RESET,         // The game started over
+    JOURNAL_END,           // Ends a snapshot
+    JOURNAL_BOARD          // A board was drawn; the payload is its question handles (int32_t), a: their number
+} journal_type;
+
+// Header of the log and snapshot files
+typedef struct {
+    char magic[8];         // JOURNAL_MAGIC or SNAPSHOT_MAGIC, without a terminating NUL
+    uint32_t version;      // JOURNAL_VERSION
+    uint32_t generation;   // Snapshot the log continues from; a snapshot's own generation
+    uint64_t fingerprint;  // Identifies the question bank the game is played on
+} journal_header;
+
+// A record as stored, followed by length bytes of payload
+typedef struct {
+    uint32_t checksum;     // FNV-1a of everything after this field, payload included
+    uint16_t type;
+    uint16_t length;
+    int32_t a;
+    int32_t b;
+} journal_record;
+
+// Growable buffer of encoded records
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} journal_buffer;
+
+// Called for each record recovered, in order
+typedef void (*journal_apply)(void *ctx, const journal_record *r, const char *payload);
+
+// An open journal: a write-ahead log with periodic snapshots. Appends are
+// buffered and written by a background thread, one fsync per batch
+typedef struct {
+    int fd;
+    char *path;            // Path of the log
+    char *snapshot_path;   // Path of the snapshot, the log path plus ".snap"
+    uint64_t fingerprint;  // Changed only by the game thread, under the lock
+    uint32_t generation;   // Generation of the current log
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;   // Signalled when there is work for the writer thread
+    pthread_cond_t synced; // Signalled when a batch is durable
+    journal_buffer pending;  // Records appended but not yet written
+    journal_buffer snapshot; // Snapshot waiting to be written
+    bool snapshot_pending;
+    bool stopping;
+    bool failed;           // A write failed; nothing more is logged
+    uint64_t appended;     // Records appended so far
+    uint64_t durable;      // Records known to be on disk
+    uint64_t since_snapshot; // Records appended since the last snapshot
+    uint64_t durable_after_snapshot; // Records covered by the pending snapshot
+} journal;
+
+// Encodes a record at the end of a buffer
+extern void journal_put(journal_buffer *buf, journal_type type, int32_t a, int32_t b,
+                        const char *payload, size_t length);
+
+// Opens the journal at path, first replaying its snapshot and log through apply;
+// returns the number of records recovered, or -1 on error
+extern long journal_open(journal *j, const char *path, uint64_t fingerprint, journal_apply apply, void *ctx);
+
+// Appends a record; it is written and synced to disk in the background
+extern void journal_append(journal *j, journal_type type, int32_t a, int32_t b, const char *payload, size_t length);
+
+// Returns true once enough records have been logged that a snapshot is due
+extern bool journal_wants_snapshot(journal *j);
+
+// Replaces the log with a snapshot of the whole state, given as encoded records;
+// the buffer is taken over by the journal
+extern void journal_snapshot(journal *j, journal_buffer *records);
+
+// Replaces the log with a snapshot taken after the game moved onto another
+// question bank, identified by its fingerprint from then on
+extern void journal_rebase(journal *j, uint64_t fingerprint, journal_buffer *records);
+
+// Waits until every record appended so far is on disk
+extern void journal_sync(journal *j);
+
+// Syncs and closes the journal
+extern void journal_close(journal *j);
+
+#endif /* JOURNAL_H_ */
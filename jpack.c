@@ -0,0 +1,49 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Command-line tool that compiles a TSV/CSV question bank into a binary pack
+ * the game can map at startup, or verifies an existing pack.
+ *
+ * Usage: jpack <bank> <pack>   compile a question bank into a pack
+ *        jpack <pack>          verify a pack and print a summary
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "questions.h" // Loads the question bank to be packed.
+#include "pack.h"      // Writes and verifies packs.
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <bank> <pack>\n       %s <pack>\n", argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Verify mode: loading a pack checks its header, layout and checksum.
+    if (argc == 2) {
+        if (!is_pack(argv[1])) {
+            fprintf(stderr, "%s: not a question pack\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+        if (load_questions(argv[1]) < 0) return EXIT_FAILURE;
+
+        printf("%s: %u questions in %u categories\n", argv[1], bank.num_questions, bank.num_categories);
+        return EXIT_SUCCESS;
+    }
+
+    printf("Loading %s\n", argv[1]);
+    if (load_questions(argv[1]) <= 0) {
+        fprintf(stderr, "No questions could be loaded from %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (write_pack(&bank, argv[2]) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    printf("Wrote %u questions in %u categories to %s\n", bank.num_questions, bank.num_categories, argv[2]);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Maintains the live player ranking as an order-statistic treap: a binary search
+ * tree ordered by score whose nodes also form a heap on pseudo-random priorities,
+ * which keeps its expected height logarithmic. Every node records the size of its
+ * subtree, so score changes, rank lookups and positional access are all O(log n)
+ * and the top of the ranking can be read without sorting the players.
+ */
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "leaderboard.h" // Include the leaderboard structures and prototypes.
+#include "util.h"        // Allocation helpers.
+
+// Returns the size of a subtree, 0 for an absent child.
+static int32_t subtree_size(const leaderboard *lb, int32_t t) {
+    return t == -1 ? 0 : lb->nodes[t].size;
+}
+
+// Recomputes a node's subtree size from its children.
+static void update_size(leaderboard *lb, int32_t t) {
+    lb->nodes[t].size = 1 + subtree_size(lb, lb->nodes[t].left) + subtree_size(lb, lb->nodes[t].right);
+}
+
+// Returns true if player a ranks ahead of player b: higher score first, then lower handle.
+static bool ranks_before(const leaderboard *lb, int32_t a, int32_t b) {
+    int score_a = lb->nodes[a].score, score_b = lb->nodes[b].score;
+    return score_a > score_b || (score_a == score_b && a < b);
+}
+
+// Derives a node priority from its handle with an integer hash finalizer.
+static uint32_t node_priority(uint32_t p) {
+    p ^= p >> 16;
+    p *= 0x7FEB352Du;
+    p ^= p >> 15;
+    p *= 0x846CA68Bu;
+    p ^= p >> 16;
+    return p;
+}
+
+/**
+ * Splits a subtree into the players ranked before a key player and the rest.
+ *
+ * @param t The root of the subtree to split.
+ * @param key The handle of the key player, whose score must be up to date.
+ * @param l Set to the subtree of players ranked before the key.
+ * @param r Set to the subtree of the remaining players.
+ */
+static void split(leaderboard *lb, int32_t t, int32_t key, int32_t *l, int32_t *r) {
+    if (t == -1) {
+        *l = *r = -1;
+    } else if (ranks_before(lb, t, key)) {
+        split(lb, lb->nodes[t].right, key, &lb->nodes[t].right, r);
+        *l = t;
+        update_size(lb, t);
+    } else {
+        split(lb, lb->nodes[t].left, key, l, &lb->nodes[t].left);
+        *r = t;
+        update_size(lb, t);
+    }
+}
+
+// Joins two subtrees where every player in l ranks before every player in r.
+static int32_t merge(leaderboard *lb, int32_t l, int32_t r) {
+    if (l == -1) return r;
+    if (r == -1) return l;
+
+    if (lb->nodes[l].priority > lb->nodes[r].priority) {
+        lb->nodes[l].right = merge(lb, lb->nodes[l].right, r);
+        update_size(lb, l);
+        return l;
+    }
+
+    lb->nodes[r].left = merge(lb, l, lb->nodes[r].left);
+    update_size(lb, r);
+    return r;
+}
+
+// Inserts a detached node at the position given by its score.
+static void insert_node(leaderboard *lb, int32_t p) {
+    int32_t l, r;
+    split(lb, lb->root, p, &l, &r);
+    lb->root = merge(lb, merge(lb, l, p), r);
+}
+
+// Removes node p from a subtree, returning the subtree's new root.
+static int32_t erase(leaderboard *lb, int32_t t, int32_t p) {
+    if (t == p) {
+        return merge(lb, lb->nodes[t].left, lb->nodes[t].right);
+    }
+
+    if (ranks_before(lb, p, t)) {
+        lb->nodes[t].left = erase(lb, lb->nodes[t].left, p);
+    } else {
+        lb->nodes[t].right = erase(lb, lb->nodes[t].right, p);
+    }
+    update_size(lb, t);
+    return t;
+}
+
+/**
+ * Initializes an empty leaderboard.
+ *
+ * @param lb The leaderboard to initialize.
+ * @param a The arena its nodes are allocated from, or NULL for the heap.
+ */
+void leaderboard_init(leaderboard *lb, arena *a) {
+    lb->nodes = NULL;
+    lb->root = -1;
+    lb->count = 0;
+    lb->capacity = 0;
+    lb->arena = a;
+}
+
+/**
+ * Releases the memory held by a leaderboard, leaving it empty.
+ *
+ * @param lb The leaderboard to free.
+ */
+void leaderboard_free(leaderboard *lb) {
+    arena_release(lb->arena, lb->nodes);
+    leaderboard_init(lb, lb->arena);
+}
+
+/**
+ * Adds a player to the ranking. Players are added in handle order, so the new
+ * player's handle is the number of players already ranked.
+ *
+ * @param lb The leaderboard.
+ * @param score The new player's score.
+ */
+void leaderboard_add(leaderboard *lb, int score) {
+    if (lb->count == lb->capacity) {
+        int capacity = lb->capacity ? lb->capacity * 2 : 16;
+        lb->nodes = arena_realloc(lb->arena, lb->nodes, lb->capacity * sizeof(rank_node), capacity * sizeof(rank_node));
+        lb->capacity = capacity;
+    }
+
+    int32_t p = lb->count++;
+    lb->nodes[p].left = lb->nodes[p].right = -1;
+    lb->nodes[p].size = 1;
+    lb->nodes[p].priority = node_priority(p);
+    lb->nodes[p].score = score;
+    insert_node(lb, p);
+}
+
+/**
+ * Records a player's new score, moving them to their new position in the ranking.
+ *
+ * @param lb The leaderboard.
+ * @param p The player's handle.
+ * @param score The player's new score.
+ */
+void leaderboard_set_score(leaderboard *lb, int p, int score) {
+    if (lb->nodes[p].score == score) return;
+
+    // Remove the node while its old score still locates it, then reinsert it.
+    lb->root = erase(lb, lb->root, p);
+    lb->nodes[p].left = lb->nodes[p].right = -1;
+    lb->nodes[p].size = 1;
+    lb->nodes[p].score = score;
+    insert_node(lb, p);
+}
+
+/**
+ * Returns a player's rank, counting tied players as sharing the best rank among
+ * them (so scores of 500, 300, 300 and 100 rank 1, 2, 2 and 4).
+ *
+ * @param lb The leaderboard.
+ * @param p The player's handle.
+ * @return The player's 1-based rank.
+ */
+int leaderboard_rank(const leaderboard *lb, int p) {
+    int score = lb->nodes[p].score;
+    int higher = 0;
+
+    // Count the players with a strictly higher score.
+    for (int32_t t = lb->root; t != -1; ) {
+        if (lb->nodes[t].score > score) {
+            higher += subtree_size(lb, lb->nodes[t].left) + 1;
+            t = lb->nodes[t].right;
+        } else {
+            t = lb->nodes[t].left;
+        }
+    }
+
+    return higher + 1;
+}
+
+/**
+ * Returns the player at a position in the ranking.
+ *
+ * @param lb The leaderboard.
+ * @param position The 0-based position, less than the number of players.
+ * @return The handle of the player at that position, or -1 if it is out of range.
+ */
+int leaderboard_at(const leaderboard *lb, int position) {
+    int32_t t = lb->root;
+    while (t != -1) {
+        int32_t left = subtree_size(lb, lb->nodes[t].left);
+        if (position < left) {
+            t = lb->nodes[t].left;
+        } else if (position == left) {
+            return t;
+        } else {
+            position -= left + 1;
+            t = lb->nodes[t].right;
+        }
+    }
+
+    return -1;
+}
+
+// Appends up to `limit` handles of a subtree to out in order; returns the new count.
+static int walk(const leaderboard *lb, int32_t t, int *out, int count, int limit) {
+    if (t == -1 || count == limit) return count;
+
+    count = walk(lb, lb->nodes[t].left, out, count, limit);
+    if (count < limit) out[count++] = t;
+    return walk(lb, lb->nodes[t].right, out, count, limit);
+}
+
+/**
+ * Lists the top of the ranking with an in-order walk that stops after k players,
+ * which costs O(k + log n) rather than a sort of every player.
+ *
+ * @param lb The leaderboard.
+ * @param k The number of players to list.
+ * @param out Receives at least min(k, number of players) handles.
+ * @return The number of handles written.
+ */
+int leaderboard_top(const leaderboard *lb, int k, int *out) {
+    if (k > lb->count) k = lb->count;
+    return walk(lb, lb->root, out, 0, k);
+}
@@ -0,0 +1,54 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef LEADERBOARD_H_
+#define LEADERBOARD_H_
+
+#include <stdint.h>
+
+#include "arena.h"
+
+// Node of the leaderboard tree, one per player handle
+typedef struct {
+    int32_t left;      // Child handles, -1 when absent
+    int32_t right;
+    int32_t size;      // Number of players in the subtree rooted here
+    uint32_t priority; // Heap priority that keeps the tree balanced
+    int score;         // Score the player is ordered by
+} rank_node;
+
+// Live ranking of players: an order-statistic treap ordered by descending score,
+// then by ascending handle so players with equal scores keep a stable order
+typedef struct {
+    rank_node *nodes;  // Indexed by player handle
+    int32_t root;      // -1 when empty
+    int count;
+    int capacity;
+    arena *arena;      // Arena the nodes are allocated from, NULL for the heap
+} leaderboard;
+
+// Initializes an empty leaderboard allocating from an arena, or the heap if it is NULL
+extern void leaderboard_init(leaderboard *lb, arena *a);
+
+// Releases the memory held by a leaderboard
+extern void leaderboard_free(leaderboard *lb);
+
+// Adds the next player handle (lb->count) with the given score
+extern void leaderboard_add(leaderboard *lb, int score);
+
+// Moves a player to the position for their new score in O(log n)
+extern void leaderboard_set_score(leaderboard *lb, int p, int score);
+
+// Returns a player's tie-aware rank: 1 + the number of players with a higher score
+extern int leaderboard_rank(const leaderboard *lb, int p);
+
+// Returns the handle of the player at a 0-based position in the ranking
+extern int leaderboard_at(const leaderboard *lb, int position);
+
+// Writes the handles of the first k players in ranking order to out; returns how many were written
+extern int leaderboard_top(const leaderboard *lb, int k, int *out);
+
+#endif /* LEADERBOARD_H_ */
@@ -0,0 +1,502 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Entry point of the Jeopardy game. Parses the command line, loads the board and
+ * feeds input lines to the game, either interactively from stdin, as a batch
+ * replay of a script file, or from clients of the multi-session server.
+ * Interactive and batch games can be journaled to a file, from which a game
+ * interrupted by a crash is recovered the next time it is started, and can be
+ * published to a shared-memory scoreboard for spectator processes. With -m the
+ * game is not played at all: bots play that many games to measure the board.
+ * With -R the question bank is reloaded whenever its file changes, and the
+ * games in progress carry on on the new bank with their players and scores.
+ * With -B every game is played on a board drawn at random from the bank
+ * instead of the whole bank, without repeating questions across games.
+ * With -E every pick, answer, pass and timeout of every game is exported to a
+ * columnar event file for evstat to analyse.
+ *
+ * Usage: jeopardy [-n players] [-z] [-t seconds] [-d seconds] [-j journal] [-p scoreboard] [-T stats [-I seconds]] [-E events] [-R] [-B categories[xrows]] [-b script [-q] [-r repeat]] [-s socket [-w workers]] [-m games [-a profile]... [-S seed] [-w workers]] [question bank]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "questions.h" // Includes the definitions and functions related to questions
+#include "players.h"   // Includes player struct and related functionalities
+#include "jeopardy.h"  // Includes the game engine
+#include "server.h"    // Includes the multi-session server
+#include "input.h"     // Includes the event-driven line input
+#include "events.h"    // Includes the event export
+#include "journal.h"   // Includes the crash-safe game journal
+#include "scoreboard.h" // Includes the shared-memory scoreboard
+#include "simulate.h"  // Includes the bot game simulator
+#include "stats.h"     // Includes the latency statistics
+#include "search.h"    // Includes the question search index
+#include "deck.h"      // Draws the boards of games from the bank
+#include "reload.h"    // Includes the hot reload of the question bank
+#include "util.h"      // Includes the monotonic clock
+
+#define BUFFER_LEN 256        // General purpose buffer length for input and strings
+#define NUM_PLAYERS 4         // Default number of players prompted for at startup
+#define BATCH_BUFFER (1 << 20) // stdio buffer size for batch input and output
+
+// Where a game is published for spectators
+typedef struct {
+    scoreboard *sb;        // The shared-memory scoreboard, or NULL if the game is not published
+    uint64_t version;      // Version of the game last published
+} spectators;
+
+// Publishes the game to its scoreboard if it changed since it was last published.
+static void publish(spectators *view, const game *g) {
+    if (view->sb == NULL || view->version == g->version) return;
+
+    game_publish(g, view->sb);
+    view->version = g->version;
+}
+
+// Moves the game onto a newer version of the question bank, if one was published
+// since the game last looked.
+static void follow_bank(bank_reader *reader, game *g) {
+    question_bank old;
+    if (!bank_adopt(reader, &old)) return;
+
+    game_rebase(g, &old);
+    bank_release(reader);
+}
+
+// Returns the current time of the monotonic clock in seconds.
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Waits for the next line of stdin, enforcing the game's deadlines meanwhile:
+ * the wait is cut short by a timer armed for the earliest deadline, and the game
+ * forfeits whatever ran out of time, so an idle player cannot stall the game.
+ * A reloaded question bank also cuts the wait short, and the game moves onto it.
+ * Before waiting, any change to the game is published to the spectators.
+ *
+ * @param in The reader of stdin.
+ * @param g The game.
+ * @param timer The deadline timer, or -1 if the game is not timed.
+ * @param view Where the game is published.
+ * @param reader The game thread's hold on the question bank.
+ * @return The line, or NULL at the end of input or once the game has ended.
+ */
+static char *next_line(line_reader *in, game *g, int timer, spectators *view, bank_reader *reader) {
+    for (;;) {
+        follow_bank(reader, g);
+        char *line = line_reader_next(in);
+        if (line != NULL) return line;
+        if (in->eof || g->status != GAME_RUNNING) return NULL;
+
+        publish(view, g);
+        fflush(stdout);
+        if (timer != -1) arm_deadline(timer, game_deadline(g));
+
+        wait_result w = wait_input(in, timer, reader->wake_fd);
+        if (w == WAIT_ERROR) return NULL;
+        if (w == WAIT_INPUT) line_reader_fill(in);
+        if (timer != -1) game_tick(g, monotonic_ns());
+    }
+}
+
+/**
+ * Opens the journal of a game, recovering the game it records, and attaches it
+ * so the game's changes are recorded from then on.
+ *
+ * @param j The journal to open.
+ * @param path The path of the journal.
+ * @param g The game, freshly initialized.
+ * @return 0 on success or -1 if the journal could not be opened.
+ */
+static int open_journal(journal *j, const char *path, game *g) {
+    long recovered = journal_open(j, path, bank_fingerprint(), game_apply, g);
+    if (recovered < 0) return -1;
+
+    game_attach(g, j);
+    if (recovered == 0 || g->out == NULL) return 0;
+
+    fprintf(g->out, "Recovered %ld journal records: %d players, %d questions left.\n",
+            recovered, g->players.num_players, questions_remaining(&g->board));
+    return 0;
+}
+
+// Shows the question a recovered game was waiting on, if any, and asks for the answer again.
+static void show_pending(game *g) {
+    if (g->pending_question == -1 || g->out == NULL) return;
+
+    display_question(g->out, g->pending_question);
+    fprintf(g->out, g->pending_player == -1 ? "Buzz in with: buzz [user]\n" : "Enter your answer: ");
+}
+
+/**
+ * Plays a game interactively on stdin/stdout: prompts for the player names,
+ * then processes commands until the board is cleared or the user exits. Input
+ * is read through poll, never with a blocking read, so timed turns and questions
+ * expire on time while waiting for a player.
+ *
+ * @param num_players The number of players to prompt for; a recovered game
+ *        keeps its players and only prompts for any that are missing.
+ * @param rules The rules of the game.
+ * @param journal_path The journal to recover the game from and record it in, or NULL.
+ * @param sb The scoreboard to publish the game to, or NULL.
+ * @return The program exit status.
+ */
+static int run_interactive(int num_players, const game_rules *rules, const char *journal_path, scoreboard *sb) {
+    spectators view = { sb, UINT64_MAX };
+    bank_reader reader;
+    line_reader in;
+    journal log;
+    game g;
+
+    if (bank_reader_register(&reader) != 0) return EXIT_FAILURE;
+    line_reader_init(&in, STDIN_FILENO);
+    game_init(&g, stdout, true, rules);
+    if (journal_path != NULL && open_journal(&log, journal_path, &g) != 0) {
+        game_free(&g);
+        bank_reader_unregister(&reader);
+        return EXIT_FAILURE;
+    }
+
+    int timer = -1;
+    if (rules->turn_timeout || rules->question_timeout) {
+        timer = deadline_timer();
+        if (timer == -1) perror("timerfd");
+    }
+
+    // Initial setup: prompt for player names and register them with a score of 0
+    while (g.players.num_players < num_players) {
+        printf("Enter name for player %d: ", g.players.num_players + 1);
+
+        char *line = next_line(&in, &g, -1, &view, &reader);
+        if (line == NULL) break;
+
+        char *name = trim(line); // Remove surrounding whitespace
+        if (name[0] == '\0') continue;
+
+        if (game_join(&g, name) == -1) {
+            printf("Player \"%s\" already exists. Please choose another name.\n", name);
+        }
+    }
+
+    if (g.players.num_players >= num_players) {
+        print_players(stdout, &g.players);
+        game_help(&g);
+        show_pending(&g);
+
+        // Main game loop: process user commands until all questions are answered or user exits
+        char *line;
+        while ((line = next_line(&in, &g, timer, &view, &reader)) != NULL) {
+            if (game_line(&g, line) != GAME_RUNNING) break;
+        }
+    }
+
+    // End of game: display final results
+    if (g.status == GAME_OVER) {
+        printf("All questions have been answered. The game is over.\n");
+        show_results(stdout, &g.players);
+    }
+    publish(&view, &g);
+
+    if (timer != -1) close(timer);
+    if (g.log != NULL) journal_close(g.log);
+    game_free(&g);
+    bank_reader_unregister(&reader);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Replays a script of commands and answers at full speed. Players are registered
+ * by join lines in the script, and a pick is answered by the line that follows it;
+ * an answer that is not phrased as a question is scored as incorrect instead of
+ * being asked for again. Input and output go through large stdio buffers, and with
+ * quiet set the game output is skipped entirely, so only the final results and the
+ * replay throughput (on stderr) are reported.
+ *
+ * @param path The path of the script.
+ * @param quiet Whether to suppress the game output.
+ * @param repeat How many times to replay the script, starting over each time.
+ * @param rules The rules of the game; time limits are not enforced in replays.
+ * @param journal_path The journal to recover the game from and record it in, or
+ *        NULL; the script then continues the recovered game.
+ * @param sb The scoreboard to publish the game to after every line that changes it, or NULL.
+ * @return The program exit status.
+ */
+static int run_batch(const char *path, bool quiet, long repeat, const game_rules *rules, const char *journal_path,
+                     scoreboard *sb) {
+    spectators view = { sb, UINT64_MAX };
+    char buffer[BUFFER_LEN];
+    long commands = 0;
+    bank_reader reader;
+    journal log;
+    game g;
+
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    if (bank_reader_register(&reader) != 0) {
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    setvbuf(in, NULL, _IOFBF, BATCH_BUFFER);
+    setvbuf(stdout, NULL, _IOFBF, BATCH_BUFFER);
+    game_init(&g, quiet ? NULL : stdout, false, rules);
+    if (journal_path != NULL && open_journal(&log, journal_path, &g) != 0) {
+        game_free(&g);
+        bank_reader_unregister(&reader);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    show_pending(&g);
+
+    double start = now();
+    for (long run = 0; run < repeat; run++) {
+        if (run > 0) {
+            rewind(in);
+            game_reset(&g);
+        }
+
+        while (fgets(buffer, BUFFER_LEN, in) != NULL) {
+            commands++;
+            follow_bank(&reader, &g);
+            if (g.status != GAME_RUNNING) break;
+
+            game_status status = game_line(&g, buffer);
+            publish(&view, &g);
+            if (status != GAME_RUNNING) break;
+        }
+    }
+    publish(&view, &g);
+    if (g.log != NULL) journal_sync(g.log); // The replay is done once its changes are durable
+    double elapsed = now() - start;
+
+    if (g.status == GAME_OVER) {
+        printf("All questions have been answered. The game is over.\n");
+    } else {
+        printf("The replay ended with %d questions unanswered.\n", questions_remaining(&g.board));
+    }
+    show_results(stdout, &g.players);
+    fflush(stdout);
+
+    fprintf(stderr, "Replayed %ld lines in %.3f s (%.0f lines/s)\n",
+            commands, elapsed, elapsed > 0 ? commands / elapsed : 0.0);
+
+    if (g.log != NULL) journal_close(g.log);
+    game_free(&g);
+    bank_reader_unregister(&reader);
+    fclose(in);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Simulates games between bots and prints the score and win-rate distributions.
+ *
+ * @param games The number of games to play.
+ * @param profiles The accuracy profile of each bot (see parse_bot_profile); with
+ *        none, SIM_BOTS bots of accuracy SIM_ACCURACY play.
+ * @param num_profiles The number of profiles.
+ * @param seed The seed of the random choices.
+ * @param workers The number of threads, or 0 for one per processor.
+ * @param rules The rules of the games.
+ * @return The program exit status.
+ */
+static int simulate(long games, const char *profiles[], int num_profiles, uint64_t seed, int workers,
+                    const game_rules *rules) {
+    simulation sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.games = games;
+    sim.seed = seed;
+    sim.rules = *rules;
+    sim.workers = workers > 0 ? workers : sysconf(_SC_NPROCESSORS_ONLN);
+    if (sim.workers < 1) sim.workers = 1;
+
+    int status = EXIT_SUCCESS;
+    for (; sim.num_bots < (num_profiles ? num_profiles : SIM_BOTS); sim.num_bots++) {
+        bot_profile *bot = &sim.bots[sim.num_bots];
+        if (num_profiles == 0) {
+            bot->accuracy = SIM_ACCURACY;
+        } else if (parse_bot_profile(profiles[sim.num_bots], bot) != 0) {
+            status = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if (status == EXIT_SUCCESS && run_simulation(&sim, stdout) != 0) status = EXIT_FAILURE;
+
+    for (int b = 0; b < sim.num_bots; b++) {
+        free_bot_profile(&sim.bots[b]);
+    }
+    return status;
+}
+
+// Parses a board shape given as categories[xrows], e.g. 6x5; returns false if it is not one.
+static bool parse_shape(const char *shape, int *columns, int *rows) {
+    char *end;
+    long c = strtol(shape, &end, 10), r = DECK_ROWS;
+    if (*end == 'x') r = strtol(end + 1, &end, 10);
+    if (*end != '\0' || c <= 0 || c > DECK_MAX_COLUMNS || r <= 0 || r > DECK_MAX_ROWS) return false;
+
+    *columns = c;
+    *rows = r;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int num_players = NUM_PLAYERS;
+    const char *script = NULL;
+    bool quiet = false;
+    long repeat = 1;
+    const char *socket_path = NULL;
+    int workers = 0;
+    const char *journal_path = NULL;
+    const char *scoreboard_name = NULL;
+    game_rules rules = { false, 0, 0, 0 };
+    long games = 0;
+    const char *profiles[MAX_BOTS];
+    int num_profiles = 0;
+    uint64_t seed = 1;
+    const char *stats_path = NULL;
+    int stats_interval = STATS_DUMP_INTERVAL;
+    const char *events_path = NULL;
+    bool reload = false;
+    int columns = 0, rows = DECK_ROWS;
+
+    // Command-line options: -n sets how many players are prompted for at startup,
+    // -b replays a script instead of reading stdin, -q silences the replay and
+    // -r repeats it, -s serves games on a Unix socket with -w worker threads,
+    // -z plays every question as a buzzer round, -t limits each turn and -d each
+    // question to a number of seconds, -j journals the game to a file and -p
+    // publishes it to a shared-memory scoreboard; -m simulates games between
+    // bots with the accuracy profiles given by -a, seeded with -S; -T dumps the
+    // latency statistics to a file every -I seconds; -E exports the events of
+    // every game to a file; -R reloads the question bank whenever its file
+    // changes or on SIGHUP; -B draws each game's board of a number of
+    // categories (by 5 value tiers unless given) from the bank
+    int opt;
+    while ((opt = getopt(argc, argv, "n:zt:d:j:p:T:I:E:RB:b:qr:s:w:m:a:S:")) != -1) {
+        if (opt == 'n' && atoi(optarg) > 0) {
+            num_players = atoi(optarg);
+        } else if (opt == 'z') {
+            rules.buzzer = true;
+        } else if (opt == 't' && atof(optarg) > 0) {
+            rules.turn_timeout = atof(optarg) * 1e9;
+        } else if (opt == 'd' && atof(optarg) > 0) {
+            rules.question_timeout = atof(optarg) * 1e9;
+        } else if (opt == 'j') {
+            journal_path = optarg;
+        } else if (opt == 'p') {
+            scoreboard_name = optarg;
+        } else if (opt == 'T') {
+            stats_path = optarg;
+        } else if (opt == 'I' && atoi(optarg) > 0) {
+            stats_interval = atoi(optarg);
+        } else if (opt == 'E') {
+            events_path = optarg;
+        } else if (opt == 'R') {
+            reload = true;
+        } else if (opt == 'B' && parse_shape(optarg, &columns, &rows)) {
+            // The shape is stored by parse_shape
+        } else if (opt == 'b') {
+            script = optarg;
+        } else if (opt == 'q') {
+            quiet = true;
+        } else if (opt == 'r' && atol(optarg) > 0) {
+            repeat = atol(optarg);
+        } else if (opt == 's') {
+            socket_path = optarg;
+        } else if (opt == 'w' && atoi(optarg) > 0) {
+            workers = atoi(optarg);
+        } else if (opt == 'm' && atol(optarg) > 0) {
+            games = atol(optarg);
+        } else if (opt == 'a' && num_profiles < MAX_BOTS) {
+            profiles[num_profiles++] = optarg;
+        } else if (opt == 'S') {
+            seed = strtoull(optarg, NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [-n players] [-z] [-t seconds] [-d seconds] [-j journal] [-p scoreboard]"
+                    " [-T stats [-I seconds]] [-E events] [-R] [-B categories[xrows]]\n       [-b script [-q] [-r repeat]] [-s socket [-w workers]]"
+                    " [-m games [-a profile]... [-S seed] [-w workers]] [question bank]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Game setup: load the question bank given on the command line, or the default board
+    FILE *listing = (script && quiet) || socket_path || games ? NULL : stdout;
+    if (optind < argc) {
+        if (load_questions(argv[optind]) <= 0) {
+            fprintf(stderr, "No questions could be loaded from %s\n", argv[optind]);
+            return EXIT_FAILURE;
+        }
+        if (listing) {
+            fprintf(listing, "Loaded %u questions in %u categories from %s\n",
+                    bank.num_questions, bank.num_categories, argv[optind]);
+        }
+    } else {
+        initialize_game(listing);
+    }
+
+    // Bots never search, so simulations skip indexing the bank; they also play the whole bank
+    if (games == 0 || socket_path != NULL) {
+        build_search_index();
+        if (columns > 0 && build_deck(columns, rows) != 0) {
+            fprintf(stderr, "Fewer than %d categories have %d questions and a single-word name to draw boards from\n",
+                    columns, rows);
+            return EXIT_FAILURE;
+        }
+    }
+    publish_bank();
+
+    // Simulations run to completion on the bank they started with, so only games follow reloads
+    if (reload && optind >= argc) {
+        fprintf(stderr, "Reloading (-R) needs a question bank file\n");
+        return EXIT_FAILURE;
+    }
+    if (reload && (games == 0 || socket_path != NULL) && reload_start(argv[optind]) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    // The statistics are dumped while any kind of game runs
+    if (stats_path != NULL && stats_dump_start(stats_path, stats_interval) != 0) {
+        return EXIT_FAILURE;
+    }
+    if (events_path != NULL && events_open(events_path) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_FAILURE;
+    if (socket_path != NULL) {
+        status = run_server(socket_path, workers ? workers : SERVER_WORKERS, &rules);
+    } else if (games > 0) {
+        status = simulate(games, profiles, num_profiles, seed, workers, &rules);
+    } else if (scoreboard_name == NULL) {
+        status = script != NULL ? run_batch(script, quiet, repeat, &rules, journal_path, NULL)
+                                : run_interactive(num_players, &rules, journal_path, NULL);
+    } else {
+        // Spectators attach to the scoreboard by name with spectate
+        scoreboard *sb = scoreboard_create(scoreboard_name);
+        if (sb != NULL) {
+            status = script != NULL ? run_batch(script, quiet, repeat, &rules, journal_path, sb)
+                                    : run_interactive(num_players, &rules, journal_path, sb);
+            scoreboard_close(sb, scoreboard_name);
+        }
+    }
+
+    if (reload) reload_stop();
+    stats_dump_stop();
+    events_close(); // Every game thread has finished, so their buffered events are all appended
+    return status;
+}
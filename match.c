@@ -0,0 +1,390 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Answer matching. Accepted answers are normalized once when a bank is loaded
+ * and a response is normalized the same way before it is looked up, so case,
+ * accents, punctuation, spacing and a leading article never decide a match.
+ * Normalization is a single pass over the text that copies plain runs of
+ * words a SIMD chunk at a time. A response that matches no accepted answer
+ * exactly is still correct within a few typos, counted with Myers'
+ * bit-parallel edit distance: each column of the edit distance matrix is a
+ * handful of word operations per 64 characters, so even the longest answers
+ * are checked in well under a microsecond.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "match.h" // Include the prototypes of the matching functions.
+
+#define WORD_BITS 64
+#define MAX_WORDS ((MAX_LEN + WORD_BITS - 1) / WORD_BITS)
+
+// Articles dropped from the start of an answer
+static const char *articles[] = { "a ", "an ", "the " };
+
+// Words a response is phrased with, as in "what is" or "who were"; "what's"
+// normalizes to "what s"
+static const char *question_words[] = { "what", "who", "where", "when" };
+static const char *question_verbs[] = { "is", "are", "was", "were", "s" };
+
+// Folded forms of U+00C0 to U+00FF, the accented letters of Latin-1; NULL for
+// the two signs among them (multiplication and division), which separate words
+static const char *latin1_folds[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "th", "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", NULL, "o", "u", "u", "u", "u", "y", "th", "y"
+};
+
+#if !defined(NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+
+#include <immintrin.h>
+
+#ifdef __AVX2__
+#define CHUNK 32
+#define CHUNK_FULL 0xffffffffu
+
+// Loads a chunk, stores it to out with ASCII letters lowercased, and returns
+// the mask of bytes that are ASCII letters, digits or spaces; spaces receives
+// the mask of spaces.
+static uint32_t fold_chunk(const char *s, char *out, uint32_t *spaces) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)s);
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+
+    _mm256_storeu_si256((__m256i *)out, _mm256_or_si256(v, _mm256_and_si256(letter, _mm256_set1_epi8(0x20))));
+    *spaces = (uint32_t)_mm256_movemask_epi8(space);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), space));
+}
+#else
+#define CHUNK 16
+#define CHUNK_FULL 0xffffu
+
+// Loads a chunk, stores it to out with ASCII letters lowercased, and returns
+// the mask of bytes that are ASCII letters, digits or spaces; spaces receives
+// the mask of spaces.
+static uint32_t fold_chunk(const char *s, char *out, uint32_t *spaces) {
+    __m128i v = _mm_loadu_si128((const __m128i *)s);
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+
+    _mm_storeu_si128((__m128i *)out, _mm_or_si128(v, _mm_and_si128(letter, _mm_set1_epi8(0x20))));
+    *spaces = (uint32_t)_mm_movemask_epi8(space);
+    return (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), space));
+}
+#endif
+
+#endif
+
+// Returns an ASCII letter or digit folded to lowercase, or 0 for any other byte.
+static char fold_ascii(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return c | 0x20;
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) return c;
+    return 0;
+}
+
+// Returns the length of the UTF-8 sequence at s, or 1 if it is malformed.
+static size_t sequence_length(const unsigned char *s, size_t len) {
+    size_t n = s[0] >= 0xF0 ? 4 : s[0] >= 0xE0 ? 3 : s[0] >= 0xC0 ? 2 : 1;
+    if (n > len) return 1;
+    for (size_t i = 1; i < n; i++) {
+        if ((s[i] & 0xC0) != 0x80) return 1;
+    }
+    return n;
+}
+
+/**
+ * Folds one character outside ASCII into a normalized text. Accented Latin-1
+ * letters are reduced to their base letters and other letters are copied as
+ * they are; the Latin-1 signs (including the no-break space) and the general
+ * punctuation block (curly quotes, dashes) separate words.
+ *
+ * @param s The character, whose first byte is not ASCII.
+ * @param len Bytes left in the text from s.
+ * @param out The normalized text, MAX_LEN bytes.
+ * @param n In/out length of the normalized text.
+ * @param separated In/out whether a separator came since the last word character.
+ * @return The bytes of s consumed, or 0 if the normalized text is full.
+ */
+static size_t fold_char(const unsigned char *s, size_t len, char *out, size_t *n, bool *separated) {
+    const char *folded = (const char *)s;
+    size_t used, size;
+
+    if (s[0] == 0xC3 && len >= 2 && (s[1] & 0xC0) == 0x80) {
+        folded = latin1_folds[s[1] - 0x80];
+        used = 2;
+    } else if (s[0] == 0xC2 && len >= 2 && (s[1] & 0xC0) == 0x80) {
+        folded = NULL; // U+0080 to U+00BF: controls, the no-break space and Latin-1 signs
+        used = 2;
+    } else if (s[0] == 0xE2 && len >= 3 && (s[1] == 0x80 || (s[1] == 0x81 && s[2] < 0xB0)) &&
+               (s[2] & 0xC0) == 0x80) {
+        folded = NULL; // U+2000 to U+206F, general punctuation
+        used = 3;
+    } else {
+        used = sequence_length(s, len);
+    }
+
+    if (folded == NULL) {
+        *separated = true;
+        return used;
+    }
+    size = folded == (const char *)s ? used : strlen(folded);
+
+    size_t space = *separated && *n > 0;
+    if (*n + space + size > MAX_LEN - 1) return 0;
+    if (space) out[(*n)++] = ' ';
+    memcpy(out + *n, folded, size);
+    *n += size;
+    *separated = false;
+    return used;
+}
+
+/**
+ * Normalizes a text in a single pass: letters and digits are kept, folded to
+ * lowercase and accented Latin-1 letters to their base letters, anything else
+ * separates words, and words are joined by single spaces with none at either
+ * end.
+ *
+ * Most of a typical answer is words separated by single spaces, which normalize
+ * to themselves apart from case. Such runs are handled a chunk at a time with
+ * SSE2 (or AVX2 when built with it): one load classifies every byte of the
+ * chunk and lowercases its letters, the chunk is stored as it is, and the
+ * output advances over the plain bytes at its start. Only the bytes that end a
+ * run (punctuation, a doubled space, anything outside ASCII) are folded one at
+ * a time. The last bytes of the text are copied into a padded chunk, so short
+ * answers take the same path.
+ *
+ * @param s The text, which does not need to be NUL-terminated.
+ * @param len The length of the text in bytes.
+ * @param out Receives the NUL-terminated normalized text; MAX_LEN bytes. The
+ *        text is cut short at a character boundary if it would not fit.
+ * @return The length of the normalized text.
+ */
+size_t normalize_text(const char *s, size_t len, char *out) {
+    const unsigned char *p = (const unsigned char *)s;
+    size_t i = 0, n = 0;
+    bool separated = false;
+
+    while (i < len) {
+#ifdef CHUNK
+        // The chunk is folded into place behind the space owed to the last word.
+        size_t space = separated && n > 0;
+        if (n + space + CHUNK < MAX_LEN) {
+            char tail[CHUNK];
+            const char *chunk = s + i;
+            if (len - i < CHUNK) {
+                memset(tail, 0, CHUNK); // NUL is not plain, so the run stops at the end of the text
+                memcpy(tail, s + i, len - i);
+                chunk = tail;
+            }
+
+            uint32_t spaces;
+            uint32_t plain = fold_chunk(chunk, out + n + space, &spaces);
+            uint32_t stops = (~plain & CHUNK_FULL) | (spaces & spaces >> 1);
+            if (separated || n == 0) stops |= spaces & 1;
+
+            size_t run = stops ? (size_t)__builtin_ctz(stops) : CHUNK;
+            if (run > 0) {
+                bool trailing = (spaces >> (run - 1)) & 1;
+                if (space) out[n] = ' ';
+                n += space + run - trailing;
+                separated = trailing;
+                i += run;
+                if (run == CHUNK || i == len) continue;
+            }
+        }
+#endif
+        if (p[i] >= 0x80) {
+            size_t used = fold_char(p + i, len - i, out, &n, &separated);
+            if (used == 0) break;
+            i += used;
+            continue;
+        }
+
+        char c = fold_ascii(p[i++]);
+        if (c == 0) {
+            separated = true;
+            continue;
+        }
+        size_t owed = separated && n > 0;
+        if (n + owed + 1 > MAX_LEN - 1) break;
+        if (owed) out[n++] = ' ';
+        out[n++] = c;
+        separated = false;
+    }
+
+    out[n] = '\0';
+    return n;
+}
+
+// Returns the length of the article a normalized answer starts with, if more words follow it, or 0.
+size_t leading_article(const char *s, size_t len) {
+    for (size_t i = 0; i < sizeof(articles) / sizeof(articles[0]); i++) {
+        size_t article_len = strlen(articles[i]);
+        if (len > article_len && memcmp(s, articles[i], article_len) == 0) return article_len;
+    }
+    return 0;
+}
+
+/**
+ * Normalizes an accepted answer or a response for comparison with
+ * normalize_text, then drops a leading "a", "an" or "the".
+ *
+ * @param s The answer, which does not need to be NUL-terminated.
+ * @param len The length of the answer in bytes.
+ * @param out Receives the NUL-terminated normalized answer; MAX_LEN bytes.
+ * @return The length of the normalized answer.
+ */
+size_t normalize_answer(const char *s, size_t len, char *out) {
+    size_t n = normalize_text(s, len, out);
+    size_t article = leading_article(out, n);
+
+    if (article > 0) {
+        n -= article;
+        memmove(out, out + article, n + 1);
+    }
+    return n;
+}
+
+// Returns the length of the given word that s starts with, up to a space or the end, or 0 if none matches.
+static size_t match_word(const char *s, const char **words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t len = strlen(words[i]);
+        if (strncmp(s, words[i], len) == 0 && (s[len] == ' ' || s[len] == '\0')) return len;
+    }
+    return 0;
+}
+
+/**
+ * Measures the phrase a normalized response starts with: a question word and a
+ * verb, as in "what is", "who were" or "what s" (from "what's").
+ *
+ * @param s The response, normalized by normalize_text.
+ * @return The length of the phrase and the space after it, or 0 if there is none.
+ */
+size_t question_phrase(const char *s) {
+    size_t n = match_word(s, question_words, sizeof(question_words) / sizeof(question_words[0]));
+    if (n == 0 || s[n] != ' ') return 0;
+
+    size_t verb = match_word(s + n + 1, question_verbs, sizeof(question_verbs) / sizeof(question_verbs[0]));
+    if (verb == 0) return 0;
+
+    n += 1 + verb;
+    return s[n] == ' ' ? n + 1 : n;
+}
+
+// Allows one typo per MATCH_CHARS_PER_TYPO characters, none in numbers such as years.
+int typo_tolerance(const char *answer, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (isdigit((unsigned char)answer[i])) return 0;
+    }
+
+    size_t typos = len / MATCH_CHARS_PER_TYPO;
+    return typos < MATCH_MAX_TYPOS ? (int)typos : MATCH_MAX_TYPOS;
+}
+
+/**
+ * Advances one 64-row block of the edit distance matrix by one column
+ * (Myers' algorithm in Hyyrö's block formulation). The block's vertical deltas
+ * are kept as bit vectors of +1 (pv) and -1 (mv) steps.
+ *
+ * @param pv In/out positive vertical deltas of the block.
+ * @param mv In/out negative vertical deltas of the block.
+ * @param eq The bits of the block's rows whose character equals the column's.
+ * @param hin The horizontal delta entering the block's top row (-1, 0 or 1).
+ * @param last The bit of the block's last row.
+ * @return The horizontal delta leaving the block's last row.
+ */
+static int advance_block(uint64_t *pv, uint64_t *mv, uint64_t eq, int hin, uint64_t last) {
+    uint64_t xv = eq | *mv;
+    eq |= (uint64_t)(hin < 0);
+    uint64_t xh = (((eq & *pv) + *pv) ^ *pv) | eq;
+    uint64_t ph = *mv | ~(xh | *pv);
+    uint64_t mh = *pv & xh;
+
+    // Branch-free, as the deltas are as good as random from one column to the next.
+    int hout = ((ph & last) != 0) - ((mh & last) != 0);
+    ph = ph << 1 | (uint64_t)(hin > 0);
+    mh = mh << 1 | (uint64_t)(hin < 0);
+
+    *pv = mh | ~(xv | ph);
+    *mv = ph & xv;
+    return hout;
+}
+
+/**
+ * Computes the edit distance (insertions, deletions and substitutions) between
+ * two strings. The rows of the matrix are a's characters, packed 64 to a word,
+ * and the matrix is advanced one column of b at a time; the distance is given
+ * up on as soon as the rest of b could no longer bring it down to max.
+ *
+ * @param a The first string, at most MAX_LEN - 1 bytes.
+ * @param b The second string, at most MAX_LEN - 1 bytes.
+ * @param max The largest distance of interest.
+ * @return The edit distance, or max + 1 if it is greater than max.
+ */
+int edit_distance(const char *a, size_t a_len, const char *b, size_t b_len, int max) {
+    const unsigned char *pa = (const unsigned char *)a, *pb = (const unsigned char *)b;
+    if (a_len >= MAX_LEN) a_len = MAX_LEN - 1;
+    if (b_len >= MAX_LEN) b_len = MAX_LEN - 1;
+
+    size_t difference = a_len > b_len ? a_len - b_len : b_len - a_len;
+    if (difference > (size_t)max) return max + 1;
+
+    // A common prefix or suffix never changes the distance; a typo usually leaves most of a long answer to both.
+    while (a_len > 0 && b_len > 0 && *pa == *pb) {
+        pa++;
+        pb++;
+        a_len--;
+        b_len--;
+    }
+    while (a_len > 0 && b_len > 0 && pa[a_len - 1] == pb[b_len - 1]) {
+        a_len--;
+        b_len--;
+    }
+    if (a_len == 0) return (int)b_len;
+
+    // Match bits of each character of a; only the characters of a and b are initialized or read.
+    size_t words = (a_len + WORD_BITS - 1) / WORD_BITS;
+    uint64_t peq[256][MAX_WORDS];
+    for (size_t i = 0; i < b_len; i++) memset(peq[pb[i]], 0, sizeof(peq[0])); // A constant size is a few stores
+    for (size_t i = 0; i < a_len; i++) memset(peq[pa[i]], 0, sizeof(peq[0]));
+    for (size_t i = 0; i < a_len; i++) peq[pa[i]][i / WORD_BITS] |= (uint64_t)1 << (i % WORD_BITS);
+
+    // Column 0 of the matrix counts up by one per row.
+    uint64_t pv[MAX_WORDS], mv[MAX_WORDS];
+    for (size_t w = 0; w < words; w++) {
+        pv[w] = ~(uint64_t)0;
+        mv[w] = 0;
+    }
+
+    uint64_t high = (uint64_t)1 << (WORD_BITS - 1);
+    uint64_t last = (uint64_t)1 << ((a_len - 1) % WORD_BITS);
+    int score = (int)a_len;
+
+    for (size_t j = 0; j < b_len; j++) {
+        const uint64_t *eq = peq[pb[j]];
+        int carry = 1; // Row 0 counts up by one per column
+        for (size_t w = 0; w < words; w++) {
+            carry = advance_block(&pv[w], &mv[w], eq[w], carry, w == words - 1 ? last : high);
+        }
+        score += carry;
+
+        // The last row changes by at most one per column.
+        if (score - (int)(b_len - j - 1) > max) return max + 1;
+    }
+
+    return score <= max ? score : max + 1;
+}
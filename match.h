@@ -0,0 +1,44 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef MATCH_H_
+#define MATCH_H_
+
+#include <stddef.h>
+
+#include "questions.h"
+
+#define ALIAS_SEPARATOR '|'     // Separates the accepted answers of a question in a bank
+#define MATCH_CHARS_PER_TYPO 5  // An answer tolerates one typo per this many characters
+#define MATCH_MAX_TYPOS 3       // ...but never more than this many
+
+// Normalizes a text into out (MAX_LEN bytes) in a single pass: case and Latin-1
+// accents folded, punctuation and runs of whitespace turned into single spaces,
+// none at either end. Returns the length of the normalized text
+extern size_t normalize_text(const char *s, size_t len, char *out);
+
+// Normalizes an answer like normalize_text and drops a leading article; returns
+// the length of the normalized answer
+extern size_t normalize_answer(const char *s, size_t len, char *out);
+
+// Returns the length of the "a ", "an " or "the " a normalized answer starts
+// with, if more words follow, or 0
+extern size_t leading_article(const char *s, size_t len);
+
+// Returns the length of a leading "what is", "who are", "what s" (from "what's")
+// or the like, including the space after it, or 0 if the normalized response
+// has none
+extern size_t question_phrase(const char *s);
+
+// Returns how many typos a normalized accepted answer tolerates: none for short
+// answers and answers containing digits, where one character changes the meaning
+extern int typo_tolerance(const char *answer, size_t len);
+
+// Returns the edit distance between two strings of at most MAX_LEN - 1 bytes,
+// or max + 1 as soon as it is known to exceed max
+extern int edit_distance(const char *a, size_t a_len, const char *b, size_t b_len, int max);
+
+#endif /* MATCH_H_ */
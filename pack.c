@@ -0,0 +1,298 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Reads and writes binary question packs. A pack holds a question bank's string
+ * table, category table and prebuilt lookup indexes in the same layout the game
+ * uses in memory, so the game can map a pack read-only and play from it without
+ * parsing or copying. Processes that map the same pack share its pages through
+ * the page cache.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pack.h" // Include the pack header layout and prototypes of the pack functions.
+
+#define PACK_ALIGN 8
+#define CHECKSUM_SEED 14695981039346656037ull
+
+// Rounds a size up to the pack section alignment.
+static uint64_t align_up(uint64_t size) {
+    return (size + PACK_ALIGN - 1) & ~(uint64_t)(PACK_ALIGN - 1);
+}
+
+/**
+ * Computes a 64-bit FNV-style checksum over 8-byte words. Working a word at a
+ * time keeps verification of large packs well under the cost of reading them.
+ *
+ * @param h The checksum so far (CHECKSUM_SEED for a new checksum).
+ * @param data The buffer, whose size must be a multiple of 8 bytes.
+ * @param size The size of the buffer in bytes.
+ * @return The updated checksum.
+ */
+uint64_t pack_checksum(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, sizeof(word));
+        h = (h ^ word) * 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * Writes one section of a pack, padded with zeros to the section alignment,
+ * and folds its bytes into the running checksum.
+ *
+ * @return 0 on success or -1 on a write error.
+ */
+static int write_section(FILE *fp, const void *data, uint64_t size, uint64_t *checksum) {
+    static const char zeros[PACK_ALIGN] = { 0 };
+    uint64_t whole = size & ~(uint64_t)(PACK_ALIGN - 1);
+    char tail[PACK_ALIGN] = { 0 };
+
+    *checksum = pack_checksum(*checksum, data, whole);
+    if (whole != size) {
+        memcpy(tail, (const char *)data + whole, size - whole);
+        *checksum = pack_checksum(*checksum, tail, PACK_ALIGN);
+    }
+
+    if (size && fwrite(data, 1, size, fp) != size) return -1;
+    if (fwrite(zeros, 1, align_up(size) - size, fp) != align_up(size) - size) return -1;
+    return 0;
+}
+
+/**
+ * Checks if a file starts with the pack magic.
+ *
+ * @param path The path of the file.
+ * @return true if the file is a pack, false otherwise (including if it cannot be read).
+ */
+bool is_pack(const char *path) {
+    char magic[sizeof(((pack_header *)0)->magic)];
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) return false;
+
+    bool match = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+                 memcmp(magic, PACK_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return match;
+}
+
+/**
+ * Writes a question bank to a pack file. The pack is written to a temporary
+ * file next to the destination and renamed into place, so a running game that
+ * maps the old pack never sees a partially written one.
+ *
+ * @param b The question bank to write.
+ * @param path The path of the pack file.
+ * @return 0 on success or -1 on error.
+ */
+int write_pack(const question_bank *b, const char *path) {
+    pack_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    header.version = PACK_VERSION;
+    header.header_size = sizeof(pack_header);
+    header.num_questions = b->num_questions;
+    header.num_categories = b->num_categories;
+    header.category_mask = b->category_mask;
+    header.question_mask = b->question_mask;
+    header.strings_size = b->strings_size;
+    header.num_aliases = b->num_aliases;
+    header.alias_mask = b->alias_mask;
+
+    // Lay the sections out one after another in the order they are written below.
+    uint64_t sizes[] = {
+        (uint64_t)b->num_categories * sizeof(uint32_t),
+        ((uint64_t)b->category_mask + 1) * sizeof(int32_t),
+        ((uint64_t)b->question_mask + 1) * sizeof(int32_t),
+        ((uint64_t)b->num_categories + 1) * sizeof(int32_t),
+        (uint64_t)b->num_questions * sizeof(int32_t),
+        (uint64_t)b->num_questions * sizeof(question),
+        (uint64_t)b->num_questions * sizeof(question_text),
+        (uint64_t)b->num_aliases * sizeof(answer_alias),
+        ((uint64_t)b->alias_mask + 1) * sizeof(int32_t),
+        b->strings_size
+    };
+    const void *sections[] = {
+        b->category_names, b->category_slots, b->question_slots,
+        b->category_start, b->category_order, b->questions, b->texts, b->aliases, b->alias_slots,
+        b->strings
+    };
+    uint64_t *offsets[] = {
+        &header.category_names, &header.category_slots, &header.question_slots,
+        &header.category_start, &header.category_order, &header.questions, &header.texts,
+        &header.aliases, &header.alias_slots, &header.strings
+    };
+    int num_sections = sizeof(sizes) / sizeof(sizes[0]);
+
+    uint64_t offset = sizeof(pack_header);
+    for (int i = 0; i < num_sections; i++) {
+        *offsets[i] = offset;
+        offset += align_up(sizes[i]);
+    }
+    header.file_size = offset;
+
+    size_t path_len = strlen(path);
+    char *tmp_path = malloc(path_len + 5);
+    if (tmp_path == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    memcpy(tmp_path, path, path_len);
+    memcpy(tmp_path + path_len, ".tmp", 5);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        perror(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+
+    // Write a placeholder header, then the sections, then the finished header.
+    uint64_t checksum = CHECKSUM_SEED;
+    int status = fwrite(&header, sizeof(header), 1, fp) == 1 ? 0 : -1;
+    for (int i = 0; i < num_sections && status == 0; i++) {
+        status = write_section(fp, sections[i], sizes[i], &checksum);
+    }
+
+    header.checksum = checksum;
+    if (status == 0 && (fseek(fp, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, fp) != 1)) {
+        status = -1;
+    }
+    if (fclose(fp) != 0) {
+        status = -1;
+    }
+
+    if (status == 0 && rename(tmp_path, path) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        perror(path);
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    return status;
+}
+
+// Checks that a section of `count` elements of `size` bytes lies inside the pack.
+static bool section_ok(const pack_header *h, uint64_t offset, uint64_t count, uint64_t size) {
+    return offset % PACK_ALIGN == 0 && offset >= h->header_size &&
+           offset <= h->file_size && count * size <= h->file_size - offset;
+}
+
+// Checks that a hash table mask describes a power-of-two table size.
+static bool mask_ok(uint32_t mask) {
+    return mask != UINT32_MAX && ((mask + 1) & mask) == 0;
+}
+
+/**
+ * Maps a pack file read-only and points the bank at its sections. The header,
+ * section bounds and checksum are verified before the bank is used.
+ *
+ * @param path The path of the pack file.
+ * @param b The bank to fill in; it is left untouched on error.
+ * @return 0 on success or -1 on error.
+ */
+int map_pack(const char *path, question_bank *b) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror(path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    if ((uint64_t)st.st_size < sizeof(pack_header)) {
+        fprintf(stderr, "%s: truncated pack\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    const pack_header *h = mapping;
+    const char *base = mapping;
+    const char *error = NULL;
+
+    if (memcmp(h->magic, PACK_MAGIC, sizeof(h->magic)) != 0) {
+        error = "not a question pack";
+    } else if (h->version != PACK_VERSION || h->header_size != sizeof(pack_header)) {
+        error = "unsupported pack version";
+    } else if (h->file_size != (uint64_t)st.st_size) {
+        error = "pack size does not match its header";
+    } else if (!mask_ok(h->category_mask) || !mask_ok(h->question_mask) || !mask_ok(h->alias_mask) ||
+               h->strings_size == 0 ||
+               !section_ok(h, h->category_names, h->num_categories, sizeof(uint32_t)) ||
+               !section_ok(h, h->category_slots, (uint64_t)h->category_mask + 1, sizeof(int32_t)) ||
+               !section_ok(h, h->question_slots, (uint64_t)h->question_mask + 1, sizeof(int32_t)) ||
+               !section_ok(h, h->category_start, (uint64_t)h->num_categories + 1, sizeof(int32_t)) ||
+               !section_ok(h, h->category_order, h->num_questions, sizeof(int32_t)) ||
+               !section_ok(h, h->questions, h->num_questions, sizeof(question)) ||
+               !section_ok(h, h->texts, h->num_questions, sizeof(question_text)) ||
+               !section_ok(h, h->aliases, h->num_aliases, sizeof(answer_alias)) ||
+               !section_ok(h, h->alias_slots, (uint64_t)h->alias_mask + 1, sizeof(int32_t)) ||
+               !section_ok(h, h->strings, h->strings_size, 1) ||
+               base[h->strings + h->strings_size - 1] != '\0') {
+        error = "corrupt pack layout";
+    } else if ((h->file_size - h->header_size) % PACK_ALIGN != 0 ||
+               pack_checksum(CHECKSUM_SEED, base + h->header_size, h->file_size - h->header_size) != h->checksum) {
+        error = "pack checksum mismatch";
+    }
+
+    if (error != NULL) {
+        fprintf(stderr, "%s: %s\n", path, error);
+        munmap(mapping, st.st_size);
+        return -1;
+    }
+
+    // The sections are only read through the bank, the mapping is read-only.
+    memset(b, 0, sizeof(*b));
+    b->category_names = (uint32_t *)(base + h->category_names);
+    b->category_slots = (int32_t *)(base + h->category_slots);
+    b->question_slots = (int32_t *)(base + h->question_slots);
+    b->category_start = (int32_t *)(base + h->category_start);
+    b->category_order = (int32_t *)(base + h->category_order);
+    b->questions = (question *)(base + h->questions);
+    b->texts = (question_text *)(base + h->texts);
+    b->aliases = (answer_alias *)(base + h->aliases);
+    b->alias_slots = (int32_t *)(base + h->alias_slots);
+    b->strings = (char *)(base + h->strings);
+    b->strings_size = h->strings_size;
+    b->num_questions = h->num_questions;
+    b->num_categories = h->num_categories;
+    b->category_mask = h->category_mask;
+    b->question_mask = h->question_mask;
+    b->num_aliases = h->num_aliases;
+    b->alias_mask = h->alias_mask;
+    b->mapping = mapping;
+    b->mapping_size = st.st_size;
+
+    return 0;
+}
+
+// Unmaps a bank previously mapped by map_pack.
+void unmap_pack(question_bank *b) {
+    munmap(b->mapping, b->mapping_size);
+    memset(b, 0, sizeof(*b));
+}
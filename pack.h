@@ -0,0 +1,63 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef PACK_H_
+#define PACK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "questions.h"
+
+#define PACK_MAGIC "JPDYPACK"
+#define PACK_VERSION 3
+
+// Header at the start of a binary question pack. Every section offset is
+// relative to the start of the file and aligned to 8 bytes; the sections hold
+// the question_bank arrays exactly as they are laid out in memory, in the
+// byte order of the machine that built the pack.
+typedef struct {
+    char magic[8];             // PACK_MAGIC, without a terminating NUL
+    uint32_t version;          // PACK_VERSION
+    uint32_t header_size;      // sizeof(pack_header)
+    uint64_t file_size;
+    uint64_t checksum;         // pack_checksum of every byte after the header
+    uint32_t num_questions;
+    uint32_t num_categories;
+    uint32_t category_mask;
+    uint32_t question_mask;
+    uint32_t strings_size;
+    uint32_t num_aliases;
+    uint32_t alias_mask;
+    uint32_t reserved;
+    uint64_t category_names;   // uint32_t[num_categories]
+    uint64_t category_slots;   // int32_t[category_mask + 1]
+    uint64_t question_slots;   // int32_t[question_mask + 1]
+    uint64_t category_start;   // int32_t[num_categories + 1]
+    uint64_t category_order;   // int32_t[num_questions]
+    uint64_t questions;        // question[num_questions]
+    uint64_t texts;            // question_text[num_questions]
+    uint64_t aliases;          // answer_alias[num_aliases]
+    uint64_t alias_slots;      // int32_t[alias_mask + 1]
+    uint64_t strings;          // char[strings_size]
+} pack_header;
+
+// Returns true if the file starts with the pack magic
+extern bool is_pack(const char *path);
+
+// Writes a question bank to a pack file; returns 0 on success or -1 on error
+extern int write_pack(const question_bank *b, const char *path);
+
+// Maps a pack file read-only and points the bank at its sections; returns 0 on success or -1 on error
+extern int map_pack(const char *path, question_bank *b);
+
+// Unmaps a bank previously mapped by map_pack
+extern void unmap_pack(question_bank *b);
+
+// Checksum of a buffer whose size is a multiple of 8 bytes, continuing from a previous value
+extern uint64_t pack_checksum(uint64_t h, const void *data, size_t size);
+
+#endif /* PACK_H_ */
@@ -5,66 +5,242 @@
  * All rights reserved.
  * 
  * Implements functions for managing players in a Jeopardy-style game.
- * This includes checking for player existence, updating scores, and displaying player information.
+ * This includes registering players, looking them up by name, updating scores,
+ * and displaying player information.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "players.h" // Include the definition of the player struct and prototypes of player-related functions.
+#include "util.h"    // Allocation and hashing helpers.
 
 /**
- * Checks if a given player already exists in the array of players.
+ * Initializes an empty player registry.
  * 
- * @param players Array of player structs.
- * @param num_players The number of players in the array.
- * @param name The name of the player to check for.
- * @return true if the player exists, false otherwise.
+ * @param r The registry to initialize.
+ * @param a The arena its tables are allocated from (the game's), or NULL for the heap.
+ */
+void init_players(player_registry *r, arena *a) {
+    memset(r, 0, sizeof(*r));
+    r->arena = a;
+    leaderboard_init(&r->ranking, a);
+}
+
+/**
+ * Releases the players, names and name index held by a registry,
+ * leaving it empty and ready for reuse.
+ * 
+ * @param r The registry to free.
+ */
+void free_players(player_registry *r) {
+    arena_release(r->arena, r->players);
+    arena_release(r->arena, r->names);
+    arena_release(r->arena, r->slots);
+    leaderboard_free(&r->ranking);
+    init_players(r, r->arena);
+}
+
+/**
+ * Rebuilds a registry in new tables from its arena, so the blocks holding the
+ * old ones can be freed. Players are added again in handle order, so every
+ * handle, name and score stays the same.
+ *
+ * @param r The registry to copy.
+ */
+void copy_players(player_registry *r) {
+    player_registry copy;
+    init_players(&copy, r->arena);
+    for (int p = 0; p < r->num_players; p++) {
+        add_player(&copy, player_name(r, p));
+        update_score(&copy, p, r->players[p].score);
+    }
+
+    free_players(r);
+    *r = copy;
+}
+
+// Places a player handle in the name index, which must have a free slot.
+static void insert_slot(player_registry *r, int p) {
+    const char *name = player_name(r, p);
+    uint32_t slot = hash_string(name, strlen(name)) & r->mask;
+    while (r->slots[slot] != -1) {
+        slot = (slot + 1) & r->mask;
+    }
+    r->slots[slot] = p;
+}
+
+// Rebuilds the name index at a size of at least twice the number of players.
+static void grow_slots(player_registry *r) {
+    uint32_t size = 16;
+    while (size < (uint32_t)r->num_players * 2) {
+        size <<= 1;
+    }
+
+    arena_release(r->arena, r->slots);
+    r->slots = arena_alloc(r->arena, size * sizeof(int32_t));
+    memset(r->slots, 0xff, size * sizeof(int32_t)); // All bits set is -1, the empty marker
+    r->mask = size - 1;
+
+    for (int i = 0; i < r->num_players; i++) {
+        insert_slot(r, i);
+    }
+}
+
+/**
+ * Looks up a player by name through the registry's hash index.
+ * 
+ * @param r The player registry.
+ * @param name The name of the player to find.
+ * @return The player's handle, or -1 if no player has that name.
  */
-bool player_exists(player *players, int num_players, char *name) {
-    for (int i = 0; i < num_players; i++) {
-        // Use strcmp to compare the current player's name with the given name.
-        if (strcmp(players[i].name, name) == 0) 
-            // If a match is found, return true immediately.
-            return true;
+int find_player(const player_registry *r, const char *name) {
+    if (r->slots == NULL) return -1;
+
+    uint32_t slot = hash_string(name, strlen(name)) & r->mask;
+    while (r->slots[slot] != -1) {
+        int p = r->slots[slot];
+        if (strcmp(player_name(r, p), name) == 0) {
+            return p;
+        }
+        slot = (slot + 1) & r->mask;
     }
 
-    // If no match is found after checking all players, return false.
-    return false;
+    return -1;
 }
 
 /**
- * Updates the score of a specified player by adding the given score to their current score.
- * If the player does not exist, no action is taken.
+ * Registers a new player with a score of 0. The name is copied into the
+ * registry's name arena, so only its actual length is stored.
  * 
- * @param players Array of player structs.
- * @param num_players The number of players in the array.
- * @param name The name of the player whose score is to be updated.
- * @param score The amount to add to the player's score.
+ * @param r The player registry.
+ * @param name The name of the new player (at most MAX_LEN - 1 bytes are kept).
+ * @return The new player's handle, or -1 if the name is already taken.
  */
-void update_score(player *players, int num_players, char *name, int score) {
-    for (int i = 0; i < num_players; i++) {
-        // Find the player by name.
-        if (strcmp(players[i].name, name) == 0) {
-            // Update the player's score by adding the given score.
-            players[i].score += score;
-
-            // Exit the loop early since the intended player has been found and updated.
-            break;
+int add_player(player_registry *r, const char *name) {
+    size_t len = strlen(name);
+    char copy[MAX_LEN];
+
+    if (len >= MAX_LEN) len = MAX_LEN - 1;
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+
+    if (find_player(r, copy) != -1) return -1;
+
+    if (r->num_players == r->capacity) {
+        int capacity = r->capacity ? r->capacity * 2 : 16;
+        r->players = arena_realloc(r->arena, r->players, r->capacity * sizeof(player), capacity * sizeof(player));
+        r->capacity = capacity;
+    }
+    if (r->names_size + len + 1 > r->names_capacity) {
+        size_t capacity = r->names_capacity ? r->names_capacity : 1024;
+        while (r->names_size + len + 1 > capacity) {
+            capacity *= 2;
         }
+        r->names = arena_realloc(r->arena, r->names, r->names_capacity, capacity);
+        r->names_capacity = capacity;
+    }
+
+    int p = r->num_players++;
+    r->players[p].name = r->names_size;
+    r->players[p].score = 0;
+    memcpy(r->names + r->names_size, copy, len + 1);
+    r->names_size += len + 1;
+    leaderboard_add(&r->ranking, 0);
+
+    if (r->slots == NULL || (uint32_t)r->num_players * 2 > r->mask + 1) {
+        grow_slots(r);
+    } else {
+        insert_slot(r, p);
     }
+
+    return p;
+}
+
+/**
+ * Returns the name of a player.
+ * 
+ * @param r The player registry.
+ * @param p The player's handle.
+ * @return The player's name, owned by the registry.
+ */
+const char *player_name(const player_registry *r, int p) {
+    return r->names + r->players[p].name;
+}
+
+/**
+ * Checks if a given player already exists in the registry.
+ * 
+ * @param r The player registry.
+ * @param name The name of the player to check for.
+ * @return true if the player exists, false otherwise.
+ */
+bool player_exists(const player_registry *r, const char *name) {
+    return find_player(r, name) != -1;
+}
+
+/**
+ * Updates the score of a player by adding the given score to their current score,
+ * and moves the player to their new place in the ranking.
+ * 
+ * @param r The player registry.
+ * @param p The handle of the player whose score is to be updated.
+ * @param score The amount to add to the player's score.
+ */
+void update_score(player_registry *r, int p, int score) {
+    r->players[p].score += score;
+    leaderboard_set_score(&r->ranking, p, r->players[p].score);
+}
+
+/**
+ * Returns a player's rank. Players with equal scores share a rank, so the
+ * player after two tied leaders is ranked third.
+ * 
+ * @param r The player registry.
+ * @param p The player's handle.
+ * @return The player's 1-based rank.
+ */
+int player_rank(const player_registry *r, int p) {
+    return leaderboard_rank(&r->ranking, p);
 }
 
 /**
  * Prints the names and scores of all players.
  * 
- * @param players Array of player structs.
- * @param num_players The number of players in the array.
+ * @param out The stream to print to.
+ * @param r The player registry.
  */
-void print_players(player *players, int num_players) {
-    // Iterate over the array of players.
-    for (int i = 0; i < num_players; i++) {
+void print_players(FILE *out, const player_registry *r) {
+    // Iterate over the registered players.
+    for (int i = 0; i < r->num_players; i++) {
         // For each player, print their name and current score.
-        printf("Player: %s, Score: $%d\n", players[i].name, players[i].score);
+        fprintf(out, "Player: %s, Score: $%d\n", player_name(r, i), r->players[i].score);
+    }
+}
+
+/**
+ * Prints the rank, name and score of the top players, ties sharing a rank.
+ * 
+ * @param out The stream to print to.
+ * @param r The player registry.
+ * @param k The number of players to print; more than are registered prints them all.
+ */
+void print_top_players(FILE *out, const player_registry *r, int k) {
+    // Capped before allocating, so a huge count from a client costs no more than the registry
+    if (k > r->num_players) k = r->num_players;
+    if (k <= 0) return;
+
+    int *top = xmalloc(k * sizeof(int));
+    int count = leaderboard_top(&r->ranking, k, top);
+    int rank = 0;
+
+    for (int i = 0; i < count; i++) {
+        // A player's rank only changes from the previous one when their score does.
+        if (i == 0 || r->players[top[i]].score != r->players[top[i - 1]].score) {
+            rank = i + 1;
+        }
+        fprintf(out, "%i. Player: %s, Score: $%d\n", rank, player_name(r, top[i]), r->players[top[i]].score);
     }
+
+    free(top);
 }
@@ -9,23 +9,69 @@
 #define PLAYERS_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "leaderboard.h"
 
 #define MAX_LEN 256
 
-// Player struct for each player
+// Player struct for each player; the name lives in the registry's name arena
 typedef struct {
-    char name[MAX_LEN];
+    uint32_t name; // Offset of the player's name in the registry's name arena
     int score;
 } player;
 
+// Growable registry of players with a hash index over their names. A player
+// handle is the player's index in players[] and stays valid as the registry grows
+typedef struct {
+    player *players;
+    int num_players;
+    int capacity;
+    char *names;           // Arena of NUL-terminated player names
+    size_t names_size;
+    size_t names_capacity;
+    int32_t *slots;        // Hash table of player handles by name, -1 when empty
+    uint32_t mask;         // Size of slots minus one (a power of two minus one)
+    leaderboard ranking;   // Live ranking of the players, kept in step with their scores
+    arena *arena;          // Arena the tables are allocated from, NULL for the heap
+} player_registry;
+
+// Initializes an empty player registry allocating from an arena, or the heap if it is NULL
+extern void init_players(player_registry *r, arena *a);
+
+// Releases the memory held by a player registry
+extern void free_players(player_registry *r);
+
+// Copies a registry's players into new tables allocated from its arena, keeping
+// their handles and scores; the old tables must stay readable until it returns
+extern void copy_players(player_registry *r);
+
+// Registers a new player with a score of 0; returns the player's handle,
+// or -1 if a player with that name already exists
+extern int add_player(player_registry *r, const char *name);
+
+// Returns the handle of the player with the given name, or -1 if there is none
+extern int find_player(const player_registry *r, const char *name);
+
+// Returns the name of the player with the given handle
+extern const char *player_name(const player_registry *r, int p);
+
 // Returns true if the player name matches one of the existing players
-extern bool player_exists(player *players, int num_players, char *name);
+extern bool player_exists(const player_registry *r, const char *name);
+
+// Adds to the score of the player with the given handle and updates the ranking
+extern void update_score(player_registry *r, int p, int score);
+
+// Returns the tie-aware rank (1 for the leader) of the player with the given handle
+extern int player_rank(const player_registry *r, int p);
 
-// Go through the list of players and update the score for the 
-// player given their name
-extern void update_score(player *players, int num_players, char *name, int score);
+// Print the top k players in ranking order
+extern void print_top_players(FILE *out, const player_registry *r, int k);
 
 // Print the scores for each player
-extern void print_players(player *players, int num_players);
+extern void print_players(FILE *out, const player_registry *r);
 
-#endif /* PLAYERS_H_ */
\ No newline at end of file
+#endif /* PLAYERS_H_ */
@@ -12,11 +12,544 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <limits.h>
 
 #include "questions.h" // Include the definitions for question structures and related functions.
+#include "pack.h"      // Binary question packs that can be mapped instead of parsed.
+#include "match.h"     // Answer normalization and typo-tolerant matching.
+#include "util.h"      // Allocation and hashing helpers.
 
-// Global array storing all game questions.
-question questions[NUM_QUESTIONS];
+#define LOAD_CHUNK (1 << 20) // Bytes read from a question bank per fread call
+
+// The calling thread's copy of the question bank, shared read-only by every
+// game once loaded (see reload.c for how threads pick up a reloaded bank).
+_Thread_local question_bank bank;
+
+// Allocated capacities of the growable bank tables while a bank is being built.
+static size_t strings_capacity = 0;
+static uint32_t questions_capacity = 0;
+static uint32_t categories_capacity = 0;
+static uint32_t aliases_capacity = 0;
+
+// Hash set of answer string offsets (0 when empty) used while building a bank,
+// so an answer shared by many questions is stored once in the string table.
+static uint32_t *answer_slots = NULL;
+static uint32_t answer_mask = 0;
+static uint32_t num_answers = 0;
+
+// Mixes an interned category id and a dollar value into a single hash.
+static uint32_t hash_key(uint32_t category_id, int32_t value) {
+    uint32_t h = category_id * 0x9E3779B1u ^ (uint32_t)value * 0x85EBCA77u;
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    return h;
+}
+
+// Allocates a table of empty slots able to hold `count` entries at a load factor of at most 1/2.
+static int32_t *alloc_slots(uint32_t count, uint32_t *mask) {
+    uint32_t size = 16;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+
+    int32_t *slots = xmalloc(size * sizeof(int32_t));
+    memset(slots, 0xff, size * sizeof(int32_t)); // All bits set is -1, the empty marker
+    *mask = size - 1;
+    return slots;
+}
+
+// Places a category id in the category table, which must have a free slot.
+static void insert_category_slot(uint32_t id) {
+    const char *name = category_name(id);
+    uint32_t slot = hash_string(name, strlen(name)) & bank.category_mask;
+    while (bank.category_slots[slot] != -1) {
+        slot = (slot + 1) & bank.category_mask;
+    }
+    bank.category_slots[slot] = id;
+}
+
+// Places a question handle in the question table, which must have a free slot.
+static void insert_question_slot(uint32_t q) {
+    uint32_t slot = hash_key(bank.questions[q].category, bank.questions[q].value) & bank.question_mask;
+    while (bank.question_slots[slot] != -1) {
+        slot = (slot + 1) & bank.question_mask;
+    }
+    bank.question_slots[slot] = q;
+}
+
+// Hashes an accepted answer together with the handle of its question.
+static uint32_t hash_alias(uint32_t q, const char *answer, size_t len) {
+    return hash_key(q, (int32_t)hash_string(answer, len));
+}
+
+// Looks up a category name of the given length, returning its id or -1.
+static int lookup_category(const char *name, size_t len) {
+    if (bank.category_slots == NULL) return -1;
+
+    uint32_t slot = hash_string(name, len) & bank.category_mask;
+    while (bank.category_slots[slot] != -1) {
+        const char *candidate = category_name(bank.category_slots[slot]);
+        if (strncmp(candidate, name, len) == 0 && candidate[len] == '\0') {
+            return bank.category_slots[slot];
+        }
+        slot = (slot + 1) & bank.category_mask;
+    }
+
+    return -1;
+}
+
+// Looks up a (category id, value) pair, returning the question handle or -1.
+static int lookup_question(uint32_t category_id, int32_t value) {
+    if (bank.question_slots == NULL) return -1;
+
+    uint32_t slot = hash_key(category_id, value) & bank.question_mask;
+    while (bank.question_slots[slot] != -1) {
+        int q = bank.question_slots[slot];
+        if (bank.questions[q].category == category_id && bank.questions[q].value == value) {
+            return q;
+        }
+        slot = (slot + 1) & bank.question_mask;
+    }
+
+    return -1;
+}
+
+// Returns the length of a string in the string table from its length byte.
+static size_t string_length(uint32_t offset) {
+    return (unsigned char)bank.strings[offset - 1];
+}
+
+// Places an alias index in the alias set, which must have a free slot.
+static void insert_alias_slot(uint32_t i) {
+    const answer_alias *alias = &bank.aliases[i];
+    uint32_t slot = hash_alias(alias->question, bank.strings + alias->answer, string_length(alias->answer)) &
+                    bank.alias_mask;
+    while (bank.alias_slots[slot] != -1) {
+        slot = (slot + 1) & bank.alias_mask;
+    }
+    bank.alias_slots[slot] = i;
+}
+
+// Looks up a normalized answer among the accepted answers of a question, returning its alias index or -1.
+static int lookup_alias(uint32_t q, const char *answer, size_t len) {
+    if (bank.alias_slots == NULL) return -1;
+
+    uint32_t slot = hash_alias(q, answer, len) & bank.alias_mask;
+    while (bank.alias_slots[slot] != -1) {
+        const answer_alias *alias = &bank.aliases[bank.alias_slots[slot]];
+        if (alias->question == q && string_length(alias->answer) == len &&
+            memcmp(bank.strings + alias->answer, answer, len) == 0) {
+            return bank.alias_slots[slot];
+        }
+        slot = (slot + 1) & bank.alias_mask;
+    }
+
+    return -1;
+}
+
+/**
+ * Appends a string to the string table as a length byte, the string and a NUL.
+ * Strings are truncated to MAX_LEN - 1 bytes so their length fits in the prefix.
+ *
+ * @param s The string, which does not need to be NUL-terminated.
+ * @param len The length of the string in bytes.
+ * @return The offset of the stored string (just after its length byte).
+ */
+static uint32_t add_string(const char *s, size_t len) {
+    if (len >= MAX_LEN) len = MAX_LEN - 1;
+
+    if (bank.strings_size + len + 2 > strings_capacity) {
+        while (bank.strings_size + len + 2 > strings_capacity) {
+            strings_capacity = strings_capacity ? strings_capacity * 2 : 4096;
+        }
+        if (strings_capacity > UINT32_MAX) {
+            fprintf(stderr, "Question bank text exceeds 4 GiB\n");
+            exit(EXIT_FAILURE);
+        }
+        bank.strings = xrealloc(bank.strings, strings_capacity);
+    }
+
+    char *dst = bank.strings + bank.strings_size;
+    dst[0] = (char)len;
+    memcpy(dst + 1, s, len);
+    dst[len + 1] = '\0';
+
+    uint32_t offset = bank.strings_size + 1;
+    bank.strings_size += len + 2;
+    return offset;
+}
+
+// Places an answer string offset in the answer set, which must have a free slot.
+static void insert_answer_slot(uint32_t offset) {
+    uint32_t slot = hash_string(bank.strings + offset, string_length(offset)) & answer_mask;
+    while (answer_slots[slot] != 0) {
+        slot = (slot + 1) & answer_mask;
+    }
+    answer_slots[slot] = offset;
+}
+
+/**
+ * Stores an answer in lowercase, reusing the stored copy if the same answer was
+ * added before. Answers such as years, names and true/false repeat across large
+ * banks, so this keeps a single copy of each in the string table.
+ *
+ * @param answer The answer, which does not need to be NUL-terminated.
+ * @param len The length of the answer in bytes.
+ * @return The string table offset of the lowercased answer.
+ */
+static uint32_t intern_answer(const char *answer, size_t len) {
+    char lower[MAX_LEN];
+
+    if (len >= MAX_LEN) len = MAX_LEN - 1;
+    for (size_t i = 0; i < len; i++) {
+        lower[i] = tolower((unsigned char)answer[i]);
+    }
+
+    if (answer_slots != NULL) {
+        uint32_t slot = hash_string(lower, len) & answer_mask;
+        while (answer_slots[slot] != 0) {
+            uint32_t offset = answer_slots[slot];
+            if (string_length(offset) == len && memcmp(bank.strings + offset, lower, len) == 0) {
+                return offset;
+            }
+            slot = (slot + 1) & answer_mask;
+        }
+    }
+
+    uint32_t offset = add_string(lower, len);
+    num_answers++;
+
+    if (answer_slots == NULL || num_answers * 2 > answer_mask + 1) {
+        uint32_t old_size = answer_slots ? answer_mask + 1 : 0;
+        uint32_t *old_slots = answer_slots;
+
+        // alloc_slots fills the table with -1; the answer set uses 0 as its empty marker.
+        answer_slots = (uint32_t *)alloc_slots(num_answers, &answer_mask);
+        memset(answer_slots, 0, (answer_mask + 1) * sizeof(uint32_t));
+        for (uint32_t i = 0; i < old_size; i++) {
+            if (old_slots[i] != 0) insert_answer_slot(old_slots[i]);
+        }
+        free(old_slots);
+    }
+
+    insert_answer_slot(offset);
+    return offset;
+}
+
+/**
+ * Returns the id of a category, interning the name if it has not been seen before.
+ * The category table is rehashed into a table twice the size when it becomes half full.
+ *
+ * @param name The category name, which does not need to be NUL-terminated.
+ * @param len The length of the name in bytes (at most MAX_LEN - 1 are kept).
+ * @return The category id.
+ */
+static uint32_t intern_category(const char *name, size_t len) {
+    if (len >= MAX_LEN) len = MAX_LEN - 1;
+
+    int found = lookup_category(name, len);
+    if (found != -1) return found;
+
+    if (bank.num_categories == categories_capacity) {
+        categories_capacity = categories_capacity ? categories_capacity * 2 : 16;
+        bank.category_names = xrealloc(bank.category_names, categories_capacity * sizeof(uint32_t));
+    }
+
+    uint32_t id = bank.num_categories++;
+    bank.category_names[id] = add_string(name, len);
+
+    if (bank.category_slots == NULL || bank.num_categories * 2 > bank.category_mask + 1) {
+        free(bank.category_slots);
+        bank.category_slots = alloc_slots(bank.num_categories, &bank.category_mask);
+        for (uint32_t i = 0; i < bank.num_categories; i++) {
+            insert_category_slot(i);
+        }
+    } else {
+        insert_category_slot(id);
+    }
+
+    return id;
+}
+
+// Trims the spaces around a field of the given length, returning its start and updating the length.
+static const char *trim_field(const char *s, size_t *len) {
+    while (*len > 0 && isspace((unsigned char)s[*len - 1])) (*len)--;
+    while (*len > 0 && isspace((unsigned char)*s)) {
+        s++;
+        (*len)--;
+    }
+    return s;
+}
+
+/**
+ * Adds an accepted answer of a question to the alias set, unless the question
+ * already accepts it. The set is rehashed into a table twice the size when it
+ * becomes half full.
+ *
+ * @param q The handle of the question, which must be the last one added.
+ * @param answer The normalized answer.
+ * @param len The length of the answer in bytes.
+ */
+static void add_alias(uint32_t q, const char *answer, size_t len) {
+    if (len == 0 || lookup_alias(q, answer, len) != -1) return;
+
+    if (bank.num_aliases == aliases_capacity) {
+        aliases_capacity = aliases_capacity ? aliases_capacity * 2 : 64;
+        bank.aliases = xrealloc(bank.aliases, aliases_capacity * sizeof(answer_alias));
+    }
+
+    uint32_t i = bank.num_aliases++;
+    bank.aliases[i].question = q;
+    bank.aliases[i].answer = intern_answer(answer, len);
+    bank.texts[q].num_aliases++;
+
+    if (bank.alias_slots == NULL || bank.num_aliases * 2 > bank.alias_mask + 1) {
+        free(bank.alias_slots);
+        bank.alias_slots = alloc_slots(bank.num_aliases, &bank.alias_mask);
+        for (uint32_t j = 0; j < bank.num_aliases; j++) {
+            insert_alias_slot(j);
+        }
+    } else {
+        insert_alias_slot(i);
+    }
+}
+
+// Adds each of the answers separated by ALIAS_SEPARATOR in an answer field to the question's accepted answers.
+static void add_aliases(uint32_t q, const char *answer, size_t len) {
+    const char *end = answer + len;
+    bank.texts[q].first_alias = bank.num_aliases;
+    bank.texts[q].num_aliases = 0;
+
+    for (;;) {
+        const char *sep = memchr(answer, ALIAS_SEPARATOR, end - answer);
+        char normalized[MAX_LEN];
+
+        add_alias(q, normalized, normalize_answer(answer, (sep ? sep : end) - answer, normalized));
+        if (sep == NULL) break;
+        answer = sep + 1;
+    }
+}
+
+/**
+ * Appends a question to the bank and indexes it by (category id, value).
+ * The first of its accepted answers is stored in lowercase to be shown to
+ * players, and every accepted answer is normalized into the alias set.
+ *
+ * @return The handle of the new question, or -1 if the category already has
+ *         a question with that value.
+ */
+static int add_question(uint32_t category_id, int32_t value,
+                        const char *text, size_t text_len,
+                        const char *answer, size_t answer_len) {
+    if (lookup_question(category_id, value) != -1) return -1;
+
+    if (bank.num_questions == questions_capacity) {
+        questions_capacity = questions_capacity ? questions_capacity * 2 : 64;
+        bank.questions = xrealloc(bank.questions, questions_capacity * sizeof(question));
+        bank.texts = xrealloc(bank.texts, questions_capacity * sizeof(question_text));
+    }
+
+    uint32_t q = bank.num_questions++;
+    bank.questions[q].category = category_id;
+    bank.questions[q].value = value;
+    bank.texts[q].question = add_string(text, text_len);
+
+    const char *sep = memchr(answer, ALIAS_SEPARATOR, answer_len);
+    size_t shown_len = sep ? (size_t)(sep - answer) : answer_len;
+    const char *shown = trim_field(answer, &shown_len);
+    bank.texts[q].answer = intern_answer(shown, shown_len);
+    add_aliases(q, answer, answer_len);
+
+    if (bank.question_slots == NULL || bank.num_questions * 2 > bank.question_mask + 1) {
+        free(bank.question_slots);
+        bank.question_slots = alloc_slots(bank.num_questions, &bank.question_mask);
+        for (uint32_t i = 0; i < bank.num_questions; i++) {
+            insert_question_slot(i);
+        }
+    } else {
+        insert_question_slot(q);
+    }
+
+    return q;
+}
+
+// Releases the current bank, unmapping it if it came from a pack, so a new one can be loaded.
+void free_questions(void) {
+    if (bank.mapping != NULL) {
+        unmap_pack(&bank);
+    } else {
+        free(bank.strings);
+        free(bank.questions);
+        free(bank.texts);
+        free(bank.category_names);
+        free(bank.category_slots);
+        free(bank.question_slots);
+        free(bank.category_start);
+        free(bank.category_order);
+        free(bank.aliases);
+        free(bank.alias_slots);
+    }
+
+    free(answer_slots);
+    answer_slots = NULL;
+    num_answers = 0;
+    memset(&bank, 0, sizeof(bank));
+    strings_capacity = 0;
+    questions_capacity = categories_capacity = aliases_capacity = 0;
+}
+
+// Orders question handles by value, for qsort.
+static int compare_handles(const void *a, const void *b) {
+    int32_t va = bank.questions[*(const int32_t *)a].value;
+    int32_t vb = bank.questions[*(const int32_t *)b].value;
+    return (va > vb) - (va < vb);
+}
+
+/**
+ * Groups the question handles by category (a counting sort on category id)
+ * and sorts each group by dollar value, so categories can be displayed without
+ * searching the question table. Also releases the answer set and the unused
+ * capacity of the growable tables, which are not needed once a bank is built.
+ */
+static void finish_bank(void) {
+    uint32_t nc = bank.num_categories, nq = bank.num_questions;
+
+    free(answer_slots);
+    answer_slots = NULL;
+    num_answers = 0;
+
+    if (nq) {
+        bank.questions = xrealloc(bank.questions, nq * sizeof(question));
+        bank.texts = xrealloc(bank.texts, nq * sizeof(question_text));
+        questions_capacity = nq;
+    }
+    if (bank.num_aliases) {
+        bank.aliases = xrealloc(bank.aliases, bank.num_aliases * sizeof(answer_alias));
+        aliases_capacity = bank.num_aliases;
+    }
+    if (bank.strings_size) {
+        bank.strings = xrealloc(bank.strings, bank.strings_size);
+        strings_capacity = bank.strings_size;
+    }
+
+    if (bank.alias_slots == NULL) {
+        bank.alias_slots = alloc_slots(0, &bank.alias_mask); // Packs always hold an alias set, even an empty one
+    }
+
+    bank.category_start = xmalloc((nc + 1) * sizeof(int32_t));
+    bank.category_order = xmalloc((nq ? nq : 1) * sizeof(int32_t));
+
+    memset(bank.category_start, 0, (nc + 1) * sizeof(int32_t));
+    for (uint32_t i = 0; i < nq; i++) {
+        bank.category_start[bank.questions[i].category + 1]++;
+    }
+    for (uint32_t c = 0; c < nc; c++) {
+        bank.category_start[c + 1] += bank.category_start[c];
+    }
+
+    int32_t *next = xmalloc((nc ? nc : 1) * sizeof(int32_t));
+    memcpy(next, bank.category_start, nc * sizeof(int32_t));
+    for (uint32_t i = 0; i < nq; i++) {
+        bank.category_order[next[bank.questions[i].category]++] = i;
+    }
+    free(next);
+
+    for (uint32_t c = 0; c < nc; c++) {
+        qsort(bank.category_order + bank.category_start[c], bank.category_start[c + 1] - bank.category_start[c],
+              sizeof(int32_t), compare_handles);
+    }
+}
+
+// Number of 64-bit words in the answered bitset of a board with n questions.
+static size_t bitset_words(uint32_t n) {
+    return (n + 63) / 64;
+}
+
+/**
+ * Allocates the state of a board on the current bank, with every question unanswered.
+ * Each game owns its board, so any number of games can share one bank.
+ *
+ * @param b The board to initialize.
+ * @param a The arena to allocate it from (its game's), or NULL for the heap.
+ */
+void init_board(board_state *b, arena *a) {
+    b->arena = a;
+    b->answered = arena_alloc(a, (bitset_words(bank.num_questions) + 1) * sizeof(uint64_t));
+    b->remaining = arena_alloc(a, (bank.num_categories + 1) * sizeof(uint32_t));
+    b->cells = NULL;
+    b->column_start = NULL;
+    b->num_columns = b->num_cells = 0;
+    reset_board(b);
+}
+
+/**
+ * Replaces a board with a drawn board of a few questions of the current bank,
+ * every one unanswered. A new column starts wherever the category changes, so
+ * the board is only as large as its questions, however large the bank.
+ *
+ * @param b The board, released and replaced.
+ * @param cells The question handles, grouped by category and sorted by value within each.
+ * @param num_cells The number of handles.
+ */
+void set_board(board_state *b, const int32_t *cells, uint32_t num_cells) {
+    uint32_t columns = 0;
+    for (uint32_t i = 0; i < num_cells; i++) {
+        if (i == 0 || bank.questions[cells[i]].category != bank.questions[cells[i - 1]].category) columns++;
+    }
+
+    free_board(b);
+    b->answered = arena_alloc(b->arena, (bitset_words(num_cells) + 1) * sizeof(uint64_t));
+    b->remaining = arena_alloc(b->arena, (columns + 1) * sizeof(uint32_t));
+    b->cells = arena_alloc(b->arena, (num_cells + 1) * sizeof(int32_t));
+    b->column_start = arena_alloc(b->arena, (columns + 1) * sizeof(uint32_t));
+    b->num_columns = columns;
+    b->num_cells = num_cells;
+
+    memcpy(b->cells, cells, num_cells * sizeof(int32_t));
+    for (uint32_t i = 0, c = 0; i < num_cells; i++) {
+        if (i == 0 || bank.questions[cells[i]].category != bank.questions[cells[i - 1]].category) {
+            b->column_start[c++] = i;
+        }
+    }
+    b->column_start[columns] = num_cells;
+    reset_board(b);
+}
+
+// Releases the memory held by a board, which stays tied to its arena.
+void free_board(board_state *b) {
+    arena *a = b->arena;
+    arena_release(a, b->answered);
+    arena_release(a, b->remaining);
+    arena_release(a, b->cells);
+    arena_release(a, b->column_start);
+    memset(b, 0, sizeof(*b));
+    b->arena = a;
+}
+
+// Returns the column of a drawn board holding a category, or -1 if none does.
+static int board_column(const board_state *b, uint32_t category_id) {
+    for (uint32_t c = 0; c < b->num_columns; c++) {
+        if (bank.questions[b->cells[b->column_start[c]]].category == category_id) return c;
+    }
+    return -1;
+}
+
+// Returns the cell of a drawn board holding a question, or -1 if it is not on the board.
+static int board_cell(const board_state *b, int q) {
+    int c = board_column(b, bank.questions[q].category);
+    if (c == -1) return -1;
+
+    for (uint32_t i = b->column_start[c]; i < b->column_start[c + 1]; i++) {
+        if (b->cells[i] == q) return i;
+    }
+    return -1;
+}
+
+// Returns true if a question is on the board: always, unless the board was drawn.
+bool on_board(const board_state *b, int q) {
+    return b->cells == NULL || board_cell(b, q) != -1;
+}
 
 // Converts a string to lowercase to standardize answer checking.
 void stringToLower(char *s) {
@@ -26,141 +559,491 @@ void stringToLower(char *s) {
 }
 
 /**
- * Initializes the game questions, assigning each question to its category,
+ * Looks up the interned id of a category name.
+ *
+ * @param category The category name to look up.
+ * @return The category id, or -1 if it does not exist.
+ */
+int find_category(const char *category) {
+    return lookup_category(category, strlen(category));
+}
+
+/**
+ * Resolves a category and dollar value to a question handle.
+ *
+ * @param category The category name.
+ * @param value The dollar value of the question.
+ * @return The index of the question in the bank, or -1 if there is no such question.
+ */
+int find_question(const char *category, int value) {
+    int category_id = find_category(category);
+    if (category_id < 0) return -1;
+
+    return lookup_question(category_id, value);
+}
+
+// Hashes the string table and the question records, which fix every question handle.
+uint64_t bank_fingerprint(void) {
+    uint32_t strings = hash_string(bank.strings, bank.strings_size);
+    uint32_t questions = hash_string((const char *)bank.questions, bank.num_questions * sizeof(question));
+    return (uint64_t)strings << 32 | questions;
+}
+
+// Returns the name of the category with the given id.
+const char *category_name(int category_id) {
+    return bank.strings + bank.category_names[category_id];
+}
+
+// Returns the lowercased answer shown for the question with the given handle.
+const char *question_answer(int q) {
+    return bank.strings + bank.texts[q].answer;
+}
+
+/**
+ * Initializes the default game questions, assigning each question to its category,
  * setting its dollar value, and marking it as unanswered. Also prints each
- * category and its questions to the console as they are initialized.
+ * category and its questions to out as they are initialized, unless out is NULL.
  */
-void initialize_game(void) {
-    int question_index = 0; // Track the index for the next question to initialize.
+void initialize_game(FILE *out) {
+    static const char *default_categories[NUM_CATEGORIES] = {
+        "programming",
+        "algorithms",
+        "databases"
+    };
+
+    free_questions();
 
     // Loop through each category.
     for (int i = 0; i < NUM_CATEGORIES; i++) {
-        printf("Category: %s", categories[i]);
+        uint32_t category_id = intern_category(default_categories[i], strlen(default_categories[i]));
+        if (out) fprintf(out, "Category: %s", default_categories[i]);
 
         // Initialize questions for the current category.
         for (int j = 0; j < NUM_QUESTIONS_PER_CATEGORY; j++) {
-            // Copy category name, formulate the question and answer text,
-            // set the dollar value, and mark as unanswered.
-            strcpy(questions[question_index].category, categories[i]);
-            sprintf(questions[question_index].question, "Question %d in category %s", j+1, categories[i]);
-            sprintf(questions[question_index].answer, "Answer %d in category %s", j+1, categories[i]);
-            
-            questions[question_index].value = (j + 1) * 100;
-            questions[question_index].answered = false;
-
-            // Convert the answer to lowercase for case-insensitive comparison.
-            stringToLower(questions[question_index].answer);        
-            printf(" $%i (%i)", questions[question_index].value, j + 1);
-
-            if (j < NUM_QUESTIONS_PER_CATEGORY - 1) {
-                printf(",");
-            }
+            char text[MAX_LEN], answer[MAX_LEN];
+
+            // Formulate the question and answer text and set the dollar value.
+            int text_len = snprintf(text, sizeof(text), "Question %d in category %s", j + 1, default_categories[i]);
+            int answer_len = snprintf(answer, sizeof(answer), "Answer %d in category %s", j + 1, default_categories[i]);
+            int q = add_question(category_id, (j + 1) * 100, text, text_len, answer, answer_len);
 
-            question_index++;
+            if (out) fprintf(out, " $%i (%i)", bank.questions[q].value, j + 1);
+
+            if (out && j < NUM_QUESTIONS_PER_CATEGORY - 1) {
+                fprintf(out, ",");
+            }
         }
 
-        printf("\n");
+        if (out) fprintf(out, "\n");
     }
+
+    finish_bank();
 }
 
 /**
- * Displays each category and the dollar values of unanswered questions.
- * Answered questions are shown with a strikethrough effect.
+ * Splits the next field off a TSV or CSV row. CSV fields may be wrapped in double
+ * quotes, with "" standing for a literal quote; such fields are unquoted in place.
+ *
+ * @param cursor In/out pointer to the start of the field; advanced past the delimiter.
+ * @param end One past the last byte of the row.
+ * @param delim The field delimiter ('\t' or ',').
+ * @param len Set to the length of the field.
+ * @return A pointer to the field contents.
  */
-void display_categories(void) {
-    int question_index = 0; // Used to iterate through the questions array.
+static char *next_field(char **cursor, char *end, char delim, size_t *len) {
+    char *start = *cursor;
 
-    // Loop through each category to display its unanswered questions.
-    for (int i = 0; i < NUM_CATEGORIES; i++) {
-        printf("%s", categories[i]);
-        for (int j = 0; j < NUM_QUESTIONS_PER_CATEGORY; j++) {
-            // Display the question value, using strikethrough for answered questions.
-            if (questions[question_index].answered) {
-                printf(" \e[9m$%i\e[0m", questions[question_index].value);
-            } else {
-                printf(" $%i", questions[question_index].value);
+    if (delim == ',' && start < end && *start == '"') {
+        char *src = start + 1, *dst = start;
+        while (src < end) {
+            if (*src == '"') {
+                if (src + 1 < end && src[1] == '"') {
+                    *dst++ = '"';
+                    src += 2;
+                    continue;
+                }
+                src++; // Closing quote
+                break;
             }
+            *dst++ = *src++;
+        }
 
-            if (j < NUM_QUESTIONS_PER_CATEGORY - 1) {
-                printf(",");
-            }
+        *len = dst - start;
+        char *sep = memchr(src, delim, end - src);
+        *cursor = sep ? sep + 1 : end;
+        return start;
+    }
+
+    char *sep = memchr(start, delim, end - start);
+    *len = (sep ? sep : end) - start;
+    *cursor = sep ? sep + 1 : end;
+    return start;
+}
+
+// Parses a dollar value such as "200" or "$200"; returns -1 if it is not a value
+// or does not fit in an int.
+int parse_value(const char *s, size_t len) {
+    size_t i = 0;
+    int value = 0;
+
+    if (i < len && s[i] == '$') i++;
+    if (i == len) return -1;
+
+    for (; i < len; i++) {
+        if (!isdigit((unsigned char)s[i])) return -1;
+        int digit = s[i] - '0';
+        if (value > (INT_MAX - digit) / 10) return -1;
+        value = value * 10 + digit;
+    }
+
+    return value;
+}
+
+// Returns true if a row of a question bank holds no question: it is blank or a '#' comment.
+static bool skipped_row(const char *row, const char *end) {
+    if (end > row && end[-1] == '\r') end--;
+    return end == row || *row == '#';
+}
+
+/**
+ * Parses one row of a question bank and adds it to the question table.
+ *
+ * @param first Whether this is the first row that is not blank or a comment,
+ *        which may be a header.
+ * @return 1 if a question was added, 0 if the row was blank, a comment or a
+ *         header, and -1 if it was malformed or duplicated an earlier question.
+ */
+static int load_row(char *row, char *end, char delim, long line, bool first) {
+    if (skipped_row(row, end)) return 0;
+    if (end[-1] == '\r') end--;
+
+    char *cursor = row;
+    size_t category_len, value_len, text_len, answer_len;
+    char *category = next_field(&cursor, end, delim, &category_len);
+    char *value_field = next_field(&cursor, end, delim, &value_len);
+    char *text = next_field(&cursor, end, delim, &text_len);
+    char *answer = next_field(&cursor, end, delim, &answer_len);
+
+    int value = parse_value(value_field, value_len);
+    if (value < 0 || category_len == 0 || answer_len == 0) {
+        if (first) return 0; // A header row such as "category,value,question,answer"
+        fprintf(stderr, "line %ld: expected category, value, question and answer\n", line);
+        return -1;
+    }
+
+    uint32_t category_id = intern_category(category, category_len);
+    if (add_question(category_id, value, text, text_len, answer, answer_len) == -1) {
+        fprintf(stderr, "line %ld: duplicate question for %s $%d\n", line, category_name(category_id), value);
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * Loads a question bank, replacing the current questions. Each line of the file
+ * holds one question as category, value, question and answer fields, separated by
+ * tabs (TSV) or commas (CSV, with optional double quoting); the delimiter is taken
+ * from the first line that is not blank or a comment. Blank lines, lines starting
+ * with '#' and a header line are skipped.
+ *
+ * The file is read in a single streaming pass through a fixed-size buffer and rows
+ * are parsed in place, so loading needs no more memory than the question tables
+ * themselves plus one buffer.
+ *
+ * If the file is a binary pack built by jpack, it is mapped read-only instead and
+ * the game runs directly from the mapping without parsing or copying anything.
+ *
+ * @param path The path of the question bank or pack.
+ * @return The number of questions loaded, or -1 if the file could not be read.
+ */
+int load_questions(const char *path) {
+    if (is_pack(path)) {
+        free_questions();
+        if (map_pack(path, &bank) == -1) return -1;
+        return bank.num_questions;
+    }
 
-            question_index++;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    free_questions();
+
+    size_t capacity = LOAD_CHUNK, pending = 0;
+    char *buffer = xmalloc(capacity);
+    char delim = 0;
+    long line = 0, skipped = 0;
+
+    for (;;) {
+        size_t n = fread(buffer + pending, 1, capacity - pending, fp);
+        bool eof = n == 0;
+        pending += n;
+
+        char *row = buffer, *end = buffer + pending;
+        for (;;) {
+            char *newline = memchr(row, '\n', end - row);
+            if (newline == NULL && !(eof && row < end)) break;
+            if (newline == NULL) newline = end; // Last line without a trailing newline
+
+            // The first row with data decides the delimiter, and may be a header
+            bool first = delim == 0 && !skipped_row(row, newline);
+            if (first) delim = memchr(row, '\t', newline - row) ? '\t' : ',';
+            if (load_row(row, newline, delim, ++line, first) < 0) skipped++;
+
+            row = newline < end ? newline + 1 : end;
+        }
+
+        if (eof) break;
+
+        // Keep the incomplete last row, growing the buffer if a single row fills it.
+        pending = end - row;
+        memmove(buffer, row, pending);
+        if (pending == capacity) {
+            capacity *= 2;
+            buffer = xrealloc(buffer, capacity);
+        }
+    }
+
+    if (ferror(fp)) {
+        perror(path);
+    }
+
+    free(buffer);
+    fclose(fp);
+    finish_bank();
+
+    if (skipped) fprintf(stderr, "%s: %ld rows skipped\n", path, skipped);
+    return bank.num_questions;
+}
+
+// Displays a category and the dollar values of its questions on the board,
+// given as handles sorted by value, striking through those answered.
+static void display_column(FILE *out, const board_state *b, uint32_t category_id,
+                           const int32_t *handles, int32_t count, uint32_t remaining) {
+    bool untouched = remaining == (uint32_t)count;
+
+    // Exhausted categories have their name struck through as well.
+    if (remaining == 0) {
+        fprintf(out, "\e[9m%s\e[0m", category_name(category_id));
+    } else {
+        fprintf(out, "%s", category_name(category_id));
+    }
+
+    for (int32_t j = 0; j < count; j++) {
+        int q = handles[j];
+
+        // Display the question value, using strikethrough for answered questions.
+        if (!untouched && (remaining == 0 || already_answered(b, q))) {
+            fprintf(out, " \e[9m$%i\e[0m", bank.questions[q].value);
+        } else {
+            fprintf(out, " $%i", bank.questions[q].value);
         }
 
-        printf("\n");
+        if (j < count - 1) {
+            fprintf(out, ",");
+        }
     }
+
+    fprintf(out, "\n");
 }
 
 /**
- * Displays the specified question for a given category and dollar value.
- * If no matching question is found, no output is produced.
+ * Displays each category and the dollar values of unanswered questions, or
+ * only the columns of a drawn board. Answered questions are shown with a
+ * strikethrough effect. The per-category counters decide whether a category
+ * is untouched or exhausted, so only partially answered categories consult
+ * the answered bitset.
  */
-void display_question(char *category, int value) {
-    for (int i = 0; i < NUM_QUESTIONS; i++) {
-        // Find and display the question matching the category and value.
-        if (
-            strcmp(questions[i].category, category) == 0 && 
-            questions[i].value == value
-        ) {
-            printf("Category: %s $%d\n", questions[i].category, questions[i].value);
-            printf("Question: %s\n", questions[i].question);
-            break;
+void display_categories(FILE *out, const board_state *b) {
+    if (b->cells != NULL) {
+        for (uint32_t c = 0; c < b->num_columns; c++) {
+            const int32_t *column = b->cells + b->column_start[c];
+            display_column(out, b, bank.questions[column[0]].category, column,
+                           b->column_start[c + 1] - b->column_start[c], b->remaining[c]);
         }
+        return;
+    }
+
+    // Loop through each category to display its unanswered questions.
+    for (uint32_t i = 0; i < bank.num_categories; i++) {
+        int32_t first = bank.category_start[i], last = bank.category_start[i + 1];
+        display_column(out, b, i, bank.category_order + first, last - first, b->remaining[i]);
     }
 }
 
 /**
- * Checks if a question in a given category and dollar value has already been answered.
- * 
+ * Displays the question with the given handle, as returned by find_question.
+ */
+void display_question(FILE *out, int q) {
+    fprintf(out, "Category: %s $%d\n", category_name(bank.questions[q].category), bank.questions[q].value);
+    fprintf(out, "Question: %s\n", bank.strings + bank.texts[q].question);
+}
+
+/**
+ * Checks if the question with the given handle has already been answered.
+ *
  * @return true if the question has been answered, false otherwise.
  */
-bool already_answered(char *category, int value) {
-    // Search for the question and return its answered status.
-     for (int i = 0; i < NUM_QUESTIONS; i++) {        
-        if (
-            strcmp(questions[i].category, category) == 0 && 
-            questions[i].value == value
-        ) {
-            return questions[i].answered;
-        }
+bool already_answered(const board_state *b, int q) {
+    int i = b->cells != NULL ? board_cell(b, q) : q;
+    return i != -1 && ((b->answered[i / 64] >> (i % 64)) & 1);
+}
+
+/**
+ * Marks the question with the given handle as answered, updating the remaining
+ * counters of its category (or column) and of the board. Marking a question
+ * twice, or one that is not on the board, has no effect.
+ */
+void mark_answered(board_state *b, int q) {
+    int i = q, counter = bank.questions[q].category;
+    if (b->cells != NULL) {
+        counter = board_column(b, counter);
+        i = board_cell(b, q);
+        if (i == -1) return;
     }
 
-    return false; // No matching question found, or it hasn't been answered yet.
+    uint64_t bit = (uint64_t)1 << (i % 64);
+    if (b->answered[i / 64] & bit) return;
+
+    b->answered[i / 64] |= bit;
+    b->remaining[counter]--;
+    b->total_remaining--;
 }
 
 /**
- * Validates a player's answer for a specified category and dollar value.
- * Converts the provided answer to lowercase before comparison to ensure
- * case-insensitive checking.
- * 
- * @return A ValidationResult struct indicating if the answer was correct and
- *         the index of the question.
+ * Finds the question of the current bank that takes the place of a question of
+ * another bank: the one in the category of the same name with the same value.
+ *
+ * @param old The bank the handle belongs to.
+ * @param q The handle in old.
+ * @return The handle in the current bank, or -1 if it has no such question.
  */
-ValidationResult valid_answer(char *category, int value, char *answer) {
-    ValidationResult result = {false, 0}; // Initialize result as not valid.
+int rebase_question(const question_bank *old, int q) {
+    const char *name = old->strings + old->category_names[old->questions[q].category];
+    int category_id = lookup_category(name, strlen(name));
+    if (category_id < 0) return -1;
 
-    // Convert the answer to lowercase for comparison.
-    stringToLower(answer);
+    return lookup_question(category_id, old->questions[q].value);
+}
 
-    // Search for the question and compare the answer.
-    for (int i = 0; i < NUM_QUESTIONS; i++) {        
-        if (
-            strcmp(questions[i].category, category) == 0 && 
-            questions[i].value == value
-        ) {
-            result.question = i; // Record the question index.
+// Moves a drawn board onto the current bank, dropping the questions it no longer has.
+static void rebase_drawn_board(board_state *b, const question_bank *old) {
+    int32_t *cells = xmalloc((b->num_cells + 1) * sizeof(int32_t));
+    uint64_t *answered = xcalloc(bitset_words(b->num_cells) + 1, sizeof(uint64_t));
+    uint32_t n = 0;
 
-            if (strcmp(questions[i].answer, answer) == 0) {
-                result.valid = true; // Answer matches, mark as valid.
-                return result;
-            }
+    for (uint32_t i = 0; i < b->num_cells; i++) {
+        int q = rebase_question(old, b->cells[i]);
+        if (q == -1) continue;
+        if ((b->answered[i / 64] >> (i % 64)) & 1) answered[n / 64] |= (uint64_t)1 << (n % 64);
+        cells[n++] = q;
+    }
+
+    set_board(b, cells, n);
+    for (uint32_t i = 0; i < n; i++) {
+        if ((answered[i / 64] >> (i % 64)) & 1) mark_answered(b, cells[i]);
+    }
+    free(cells);
+    free(answered);
+}
 
-            break; // Question found and answer checked, no need to continue.
+/**
+ * Moves a board of another bank onto the current bank: the questions answered
+ * on it are marked answered on a new board by rebase_question, and those the
+ * current bank no longer has are dropped. A drawn board keeps its columns,
+ * less the questions the current bank no longer has.
+ *
+ * @param b The board, replaced by the new one.
+ * @param old The bank the board was played on.
+ */
+void rebase_board(board_state *b, const question_bank *old) {
+    if (b->cells != NULL) {
+        rebase_drawn_board(b, old);
+        return;
+    }
+
+    board_state moved;
+    init_board(&moved, b->arena);
+
+    for (uint32_t w = 0; w < bitset_words(old->num_questions); w++) {
+        for (uint64_t bits = b->answered[w]; bits != 0; bits &= bits - 1) {
+            int q = rebase_question(old, w * 64 + __builtin_ctzll(bits));
+            if (q != -1) mark_answered(&moved, q);
         }
-        
-        result.question = i;
     }
 
-    return result; // Return the result (validity and question index).
+    free_board(b);
+    *b = moved;
+}
+
+/**
+ * Marks every question of a board as unanswered and resets the remaining
+ * counters from the category layout of the bank, or from the columns of a
+ * drawn board.
+ */
+void reset_board(board_state *b) {
+    if (b->cells != NULL) {
+        memset(b->answered, 0, bitset_words(b->num_cells) * sizeof(uint64_t));
+        for (uint32_t c = 0; c < b->num_columns; c++) {
+            b->remaining[c] = b->column_start[c + 1] - b->column_start[c];
+        }
+        b->total_remaining = b->num_cells;
+        return;
+    }
+
+    memset(b->answered, 0, bitset_words(bank.num_questions) * sizeof(uint64_t));
+    for (uint32_t c = 0; c < bank.num_categories; c++) {
+        b->remaining[c] = bank.category_start[c + 1] - bank.category_start[c];
+    }
+    b->total_remaining = bank.num_questions;
+}
+
+// Returns the number of unanswered questions left in a category.
+int category_remaining(const board_state *b, int category_id) {
+    if (b->cells != NULL) {
+        int c = board_column(b, category_id);
+        return c != -1 ? (int)b->remaining[c] : 0;
+    }
+    return b->remaining[category_id];
+}
+
+// Returns the number of unanswered questions left on the board.
+int questions_remaining(const board_state *b) {
+    return b->total_remaining;
+}
+
+/**
+ * Checks a normalized answer against the accepted answers of the question with
+ * the given handle: an exact match in the alias set, or failing that, an
+ * accepted answer within its typo tolerance.
+ *
+ * @param q The handle of the question.
+ * @param answer The answer, normalized by normalize_answer.
+ * @param len The length of the answer in bytes.
+ * @return true if the answer matches one of the question's accepted answers, false otherwise.
+ */
+bool answer_matches(int q, const char *answer, size_t len) {
+    if (len == 0) return false;
+    if (lookup_alias(q, answer, len) != -1) return true;
+
+    const question_text *text = &bank.texts[q];
+    for (uint32_t i = text->first_alias; i < text->first_alias + text->num_aliases; i++) {
+        const char *accepted = bank.strings + bank.aliases[i].answer;
+        size_t accepted_len = string_length(bank.aliases[i].answer);
+        int typos = typo_tolerance(accepted, accepted_len);
+
+        if (typos > 0 && edit_distance(accepted, accepted_len, answer, len, typos) <= typos) return true;
+    }
+
+    return false;
+}
+
+// Normalizes a player's answer and checks it against the question's accepted answers.
+bool valid_answer(int q, const char *answer) {
+    char normalized[MAX_LEN];
+    size_t len = normalize_answer(answer, strlen(answer), normalized);
+    return answer_matches(q, normalized, len);
 }
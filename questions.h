@@ -8,57 +8,175 @@
 #define QUESTIONS_H_
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
 
 #define MAX_LEN 256
-#define NUM_CATEGORIES 3
 
-// The number of questions, you can use this in your functions in
-// questions.c, this can be accessed in questions.c
+// Shape of the default board built by initialize_game; boards loaded
+// with load_questions can have any number of categories and questions
+#define NUM_CATEGORIES 3
 #define NUM_QUESTIONS_PER_CATEGORY 4 
 #define NUM_QUESTIONS 12
 
-// List of 3 categories as array of strings
-static char categories[NUM_CATEGORIES][MAX_LEN] = {
-    "programming", 
-    "algorithms", 
-    "databases"
-};
-
-// Questions struct for each question
+// Questions struct for each question, holding the fields every lookup reads
 typedef struct {
-    char category[MAX_LEN];
-    char question[MAX_LEN];
-    char answer[MAX_LEN];
-    int value;
-    bool answered;
+    uint32_t category; // Interned category id
+    int32_t value;
 } question;
 
-// An array of 12 questions (4 for each category), initialized in initialize_game
-// this may need to be a pointer if you want it set dynamically
-extern question questions[NUM_QUESTIONS];
+// Text of each question, kept apart from the question records because it is
+// only read when a question is shown or an answer is checked. Offsets point
+// into the bank's string table, where every string is preceded by a length
+// byte and followed by a NUL
+typedef struct {
+    uint32_t question;    // String table offset of the question text
+    uint32_t answer;      // String table offset of the lowercased answer shown to players
+    uint32_t first_alias; // The question's accepted answers are aliases[first_alias ..
+    uint32_t num_aliases; //   first_alias + num_aliases)
+} question_text;
+
+// One accepted answer of a question, normalized by normalize_answer
+typedef struct {
+    uint32_t question; // Handle of the question
+    uint32_t answer;   // String table offset of the normalized answer
+} answer_alias;
+
+// A question bank: the question records, category names and lookup indexes.
+// Built on the heap by initialize_game/load_questions, or mapped read-only
+// from a binary pack file, in which case nothing in it may be modified.
+typedef struct {
+    char *strings;             // String table of length-prefixed, NUL-terminated strings
+    question *questions;
+    question_text *texts;
+    uint32_t *category_names;  // String table offset of each category name
+    int32_t *category_slots;   // Hash table of category ids by name
+    int32_t *question_slots;   // Hash table of question handles by (category, value)
+    int32_t *category_start;   // Category c holds category_order[category_start[c] .. category_start[c + 1])
+    int32_t *category_order;   // Question handles grouped by category, sorted by value
+    answer_alias *aliases;     // Accepted answers of every question, grouped by question
+    int32_t *alias_slots;      // Hash set of alias indexes by (question, normalized answer)
+    uint32_t strings_size;
+    uint32_t num_questions;
+    uint32_t num_categories;
+    uint32_t category_mask;    // Size of category_slots minus one (a power of two minus one)
+    uint32_t question_mask;    // Size of question_slots minus one
+    uint32_t num_aliases;
+    uint32_t alias_mask;       // Size of alias_slots minus one
+    void *mapping;             // The pack mapping backing the bank, or NULL if heap allocated
+    size_t mapping_size;
+} question_bank;
+
+// The question bank, shared read-only by every game once loaded. Each thread
+// reads its own copy of the version it last adopted, so a reload can swap the
+// bank without stopping the games (see reload.h)
+extern _Thread_local question_bank bank;
+
+// Answered state of a board, kept apart from the bank because a mapped pack
+// is read-only and because every game plays its own board on the shared bank.
+// A board is either the whole bank or a drawn board of a few of its questions
+// (see deck.h), laid out in columns of one category each. The counters are
+// updated as questions are answered, so game over and exhausted categories
+// are known without scanning the board
+typedef struct {
+    uint64_t *answered;        // Bitset of answered questions, indexed by question handle, or by cell of a drawn board
+    uint32_t *remaining;       // Unanswered questions left in each category, or in each column of a drawn board
+    uint32_t total_remaining;  // Unanswered questions left on the board
+    int32_t *cells;            // Question handles of a drawn board, column by column, or NULL for the whole bank
+    uint32_t *column_start;    // Column c holds cells[column_start[c] .. column_start[c + 1])
+    uint32_t num_columns;
+    uint32_t num_cells;
+    arena *arena;              // Arena the board is allocated from, NULL for the heap
+} board_state;
+
+// Initializes the array of questions for the game with the default board,
+// listing the board to out unless it is NULL
+extern void initialize_game(FILE *out);
+
+// Loads a TSV/CSV question bank (category, value, question, answer per line, with
+// accepted answers separated by '|') or maps a binary pack, replacing the current
+// bank; returns the number of questions or -1 on error
+extern int load_questions(const char *path);
+
+// Releases the current bank
+extern void free_questions(void);
+
+// Returns a fingerprint of the current bank's contents and question handles,
+// so state saved against one bank is not restored onto another
+extern uint64_t bank_fingerprint(void);
 
-// Initializes the array of questions for the game
-extern void initialize_game(void);
+// Allocates a board on the current bank with every question unanswered, from
+// an arena, or the heap if it is NULL
+extern void init_board(board_state *b, arena *a);
+
+// Replaces a board with a drawn board of the given question handles, grouped
+// by category and sorted by value within each, with every question unanswered;
+// it is allocated like the board it replaces
+extern void set_board(board_state *b, const int32_t *cells, uint32_t num_cells);
+
+// Releases the memory held by a board
+extern void free_board(board_state *b);
+
+// Returns true if the question with the given handle is on the board
+extern bool on_board(const board_state *b, int q);
 
 // Displays each of the remaining categories and question dollar values that have not been answered
-extern void display_categories(void);
+extern void display_categories(FILE *out, const board_state *b);
+
+// Returns the interned id of a category name, or -1 if there is no such category
+extern int find_category(const char *category);
+
+// Parses a dollar value such as "200" or "$200" of len characters; returns -1
+// if it is not a value or does not fit in an int
+extern int parse_value(const char *s, size_t len);
+
+// Returns the handle (index into questions[]) of the question for the category
+// and dollar value, or -1 if there is no such question
+extern int find_question(const char *category, int value);
+
+// Displays the question with the given handle
+extern void display_question(FILE *out, int q);
+
+// Returns the name of the category with the given id
+extern const char *category_name(int category_id);
 
-// Displays the question for the category and dollar value
-extern void display_question(char *category, int value);
+// Returns the lowercased answer shown for the question with the given handle
+extern const char *question_answer(int q);
+
+// Marks the question with the given handle as answered
+extern void mark_answered(board_state *b, int q);
+
+// Marks every question of a board as unanswered
+extern void reset_board(board_state *b);
+
+// Returns the handle in the current bank of the question with the same category
+// and value as question q of another bank, or -1 if there is none
+extern int rebase_question(const question_bank *old, int q);
+
+// Moves a board of another bank onto the current bank, keeping the questions
+// answered on it that the current bank still has
+extern void rebase_board(board_state *b, const question_bank *old);
+
+// Returns the number of unanswered questions left in a category
+extern int category_remaining(const board_state *b, int category_id);
+
+// Returns the number of unanswered questions left on the board; the game is over at 0
+extern int questions_remaining(const board_state *b);
 
 // String to lower case
 extern void stringToLower(char *s);
 
-// answer struct for each answer
-typedef struct {
-   int question;
-   bool valid;
-} ValidationResult;
+// Returns true if the answer matches an accepted answer of the question with the
+// given handle, ignoring case, punctuation, a leading article and a few typos
+extern bool valid_answer(int q, const char *answer);
 
-// Returns true if the answer is correct for the question for that category and dollar value
-extern ValidationResult valid_answer(char *category, int value, char *answer);
+// Returns true if an answer already normalized by normalize_answer matches an
+// accepted answer of the question with the given handle
+extern bool answer_matches(int q, const char *answer, size_t len);
 
-// Returns true if the question has already been answered
-extern bool already_answered(char *category, int value);
+// Returns true if the question with the given handle is on the board and has already been answered
+extern bool already_answered(const board_state *b, int q);
 
 #endif /* QUESTIONS_H_ */
@@ -0,0 +1,361 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Hot reload of the question bank. A background thread watches the bank file
+ * with inotify (and listens for SIGHUP), loads the new contents and builds
+ * their search index (and deck, when boards are drawn) off the game threads,
+ * then publishes them as a new version with a single atomic pointer store.
+ *
+ * Reclamation is RCU-style and quiescent-state based. Every thread that plays
+ * games (the interactive loop, each server worker, each simulation worker) is a
+ * registered reader whose bank is a thread-local copy of the version it last
+ * adopted. Readers only adopt a new version between input lines or event
+ * batches, when nothing of theirs refers to a question handle in flight, so
+ * display_question, valid_answer and the rest read their own copy without any
+ * lock and never see a version being built. Once every reader has adopted the
+ * new version and moved its games over, the old one is freed.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include "reload.h"    // Include the reader and reload prototypes.
+#include "questions.h" // The bank being reloaded.
+#include "search.h"    // Its search index, rebuilt with it.
+#include "deck.h"      // Its deck, rebuilt with it.
+#include "util.h"      // Allocation helpers and the monotonic clock.
+
+// A published version of the bank
+typedef struct {
+    question_bank bank;
+    search_index index;
+    board_deck deck;
+    uint64_t number;       // Versions are numbered from 1 in order of publication
+} bank_version;
+
+static _Atomic(bank_version *) current; // The newest version
+
+// Registered readers; the lock is only taken to register, to wake the readers
+// and to check on them, never to read the bank.
+static pthread_mutex_t readers_lock = PTHREAD_MUTEX_INITIALIZER;
+static bank_reader *readers;
+
+// The reload thread and what it watches.
+static struct {
+    pthread_t thread;
+    char *path;
+    const char *name;      // File name of the bank within its directory
+    int inotify_fd;        // Watches the bank's directory, so a file replaced by a rename is seen
+    int stop_fd;           // eventfd signalled to stop the thread
+    int columns, rows;     // Shape of the deck to build, 0 columns if boards are not drawn
+    bool running;
+} reloader = { .inotify_fd = -1, .stop_fd = -1 };
+
+// The eventfd the SIGHUP handler signals; write is async-signal-safe.
+static int hangup_fd = -1;
+
+// Signal handler for SIGHUP: asks for a reload.
+static void on_hangup(int sig) {
+    (void)sig;
+    uint64_t one = 1;
+    ssize_t n = write(hangup_fd, &one, sizeof(one));
+    (void)n;
+}
+
+// Resets an eventfd to unsignalled.
+static void drain(int fd) {
+    uint64_t count;
+    ssize_t n = read(fd, &count, sizeof(count));
+    (void)n;
+}
+
+/**
+ * Publishes the calling thread's bank and search index as the newest version
+ * and wakes the readers to adopt it.
+ *
+ * @return The version it replaces, or NULL for the first.
+ */
+static bank_version *publish(void) {
+    bank_version *v = xmalloc(sizeof(bank_version));
+    bank_version *old = atomic_load_explicit(&current, memory_order_relaxed);
+    v->bank = bank;
+    v->index = bank_index;
+    v->deck = deck;
+    v->number = old ? old->number + 1 : 1;
+    atomic_store_explicit(&current, v, memory_order_release);
+
+    uint64_t one = 1;
+    pthread_mutex_lock(&readers_lock);
+    for (bank_reader *r = readers; r != NULL; r = r->next) {
+        ssize_t n = write(r->wake_fd, &one, sizeof(one));
+        (void)n;
+    }
+    pthread_mutex_unlock(&readers_lock);
+    return old;
+}
+
+// Publishes the calling thread's bank and search index as the first version.
+void publish_bank(void) {
+    publish();
+}
+
+// Registers the calling thread as a reader and gives it the current version.
+int bank_reader_register(bank_reader *r) {
+    r->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->wake_fd == -1) {
+        perror("eventfd");
+        return -1;
+    }
+
+    // Adopted under the lock, so a reload checking on the readers sees either
+    // no reader yet or one already on the version it loaded
+    pthread_mutex_lock(&readers_lock);
+    bank_version *v = atomic_load_explicit(&current, memory_order_acquire);
+    bank = v->bank;
+    bank_index = v->index;
+    deck = v->deck;
+    r->adopted = v->number;
+    atomic_store_explicit(&r->seen, v->number, memory_order_relaxed);
+    r->next = readers;
+    readers = r;
+    pthread_mutex_unlock(&readers_lock);
+    return 0;
+}
+
+// Unregisters a reader, so reloads no longer wait for it.
+void bank_reader_unregister(bank_reader *r) {
+    pthread_mutex_lock(&readers_lock);
+    for (bank_reader **link = &readers; *link != NULL; link = &(*link)->next) {
+        if (*link == r) {
+            *link = r->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&readers_lock);
+    close(r->wake_fd);
+}
+
+/**
+ * Switches the calling thread to the newest version. The version it was on is
+ * not freed before the thread calls bank_release, so the caller can still
+ * read the old bank through old while it moves its games over.
+ *
+ * @return true if the thread switched, false if it was already on the newest.
+ */
+bool bank_adopt(bank_reader *r, question_bank *old) {
+    bank_version *v = atomic_load_explicit(&current, memory_order_acquire);
+    if (v->number == r->adopted) return false;
+
+    drain(r->wake_fd);
+    *old = bank;
+    bank = v->bank;
+    bank_index = v->index;
+    deck = v->deck;
+    r->adopted = v->number;
+    return true;
+}
+
+// Reports that the thread is done with every version older than the one it adopted.
+void bank_release(bank_reader *r) {
+    atomic_store_explicit(&r->seen, r->adopted, memory_order_release);
+}
+
+/**
+ * Waits for the grace period of a version: until every reader has adopted it
+ * (or a later one) and released the older ones.
+ *
+ * @return true once it has passed, false if the reload thread was stopped first.
+ */
+static bool wait_for_readers(uint64_t number) {
+    struct pollfd stop = { .fd = reloader.stop_fd, .events = POLLIN };
+
+    for (;;) {
+        bool passed = true;
+        pthread_mutex_lock(&readers_lock);
+        for (bank_reader *r = readers; r != NULL && passed; r = r->next) {
+            passed = atomic_load_explicit(&r->seen, memory_order_acquire) >= number;
+        }
+        pthread_mutex_unlock(&readers_lock);
+
+        if (passed) return true;
+        if (poll(&stop, 1, RELOAD_POLL_MS) > 0) return false;
+    }
+}
+
+// Frees a version no reader refers to any more, by making it the calling thread's bank and releasing that.
+static void free_version(bank_version *v) {
+    bank = v->bank;
+    bank_index = v->index;
+    deck = v->deck;
+    free_questions();
+    free_search_index();
+    free_deck();
+    free(v);
+}
+
+/**
+ * Loads the bank file again and publishes it, then frees the version it
+ * replaces once every reader has moved on. A file that cannot be read, holds
+ * no questions or cannot fill a drawn board leaves the current version in place.
+ */
+static void reload_bank(void) {
+    uint64_t start = monotonic_ns();
+
+    // The thread's bank still points at the published version; load into a fresh one
+    memset(&bank, 0, sizeof(bank));
+    memset(&bank_index, 0, sizeof(bank_index));
+    memset(&deck, 0, sizeof(deck));
+    if (load_questions(reloader.path) <= 0) {
+        fprintf(stderr, "%s: no questions could be reloaded; keeping the current bank\n", reloader.path);
+        free_questions();
+        return;
+    }
+    if (reloader.columns > 0 && build_deck(reloader.columns, reloader.rows) != 0) {
+        fprintf(stderr, "%s: too few categories to draw boards from; keeping the current bank\n", reloader.path);
+        free_questions();
+        return;
+    }
+    build_search_index();
+
+    bank_version *old = publish();
+    fprintf(stderr, "Reloaded %u questions in %u categories from %s in %.1f ms\n", bank.num_questions,
+            bank.num_categories, reloader.path, (monotonic_ns() - start) / 1e6);
+
+    if (old != NULL && wait_for_readers(old->number + 1)) free_version(old);
+}
+
+// Returns true if a batch of inotify events includes a change to the bank file.
+static bool bank_changed(void) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+
+    for (;;) {
+        ssize_t n = read(reloader.inotify_fd, buffer, sizeof(buffer));
+        if (n <= 0) return changed;
+
+        for (char *p = buffer; p < buffer + n;) {
+            const struct inotify_event *e = (const struct inotify_event *)p;
+            if (e->len > 0 && strcmp(e->name, reloader.name) == 0) changed = true;
+            p += sizeof(struct inotify_event) + e->len;
+        }
+    }
+}
+
+/**
+ * Reload thread: reloads the bank on SIGHUP, and when the file changes once it
+ * has been quiet for RELOAD_SETTLE_MS, so an editor's or a copy's several
+ * writes make one reload. Runs until reload_stop.
+ */
+static void *reload_thread(void *arg) {
+    (void)arg;
+    struct pollfd fds[3] = {
+        { .fd = reloader.stop_fd, .events = POLLIN },
+        { .fd = hangup_fd, .events = POLLIN },
+        { .fd = reloader.inotify_fd, .events = POLLIN }
+    };
+    bool changed = false;
+
+    for (;;) {
+        int n = poll(fds, 3, changed ? RELOAD_SETTLE_MS : -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        if (fds[0].revents) break;
+
+        if (fds[1].revents) {
+            drain(hangup_fd);
+            changed = false;
+            reload_bank();
+        } else if (fds[2].revents) {
+            changed |= bank_changed();
+        } else if (changed) {
+            changed = false;
+            reload_bank();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Starts the reload thread on a bank file. The file's directory is watched
+ * rather than the file itself, so the bank is still followed after it is
+ * replaced by renaming a new file over it.
+ *
+ * @param path The path of the bank the game was started with.
+ * @return 0 on success or -1 on error.
+ */
+int reload_start(const char *path) {
+    reloader.path = strdup(path);
+    reloader.columns = deck.columns;
+    reloader.rows = deck.rows;
+    const char *slash = strrchr(reloader.path, '/');
+    reloader.name = slash ? slash + 1 : reloader.path;
+    char *dir = slash ? strndup(reloader.path, slash == reloader.path ? 1 : (size_t)(slash - reloader.path))
+                      : strdup(".");
+
+    reloader.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    reloader.stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    hangup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int status = reloader.inotify_fd == -1 || reloader.stop_fd == -1 || hangup_fd == -1 ? -1 : 0;
+
+    if (status == 0 && inotify_add_watch(reloader.inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        perror(dir);
+        status = -1;
+    } else if (status == -1) {
+        perror("reload");
+    }
+    free(dir);
+
+    if (status == 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_hangup;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGHUP, &sa, NULL);
+
+        reloader.running = pthread_create(&reloader.thread, NULL, reload_thread, NULL) == 0;
+        if (!reloader.running) {
+            fprintf(stderr, "Could not start the reload thread\n");
+            status = -1;
+        }
+    }
+
+    if (status != 0) reload_stop();
+    return status;
+}
+
+// Stops the reload thread and closes what it watched.
+void reload_stop(void) {
+    if (reloader.running) {
+        uint64_t one = 1;
+        ssize_t n = write(reloader.stop_fd, &one, sizeof(one));
+        (void)n;
+        pthread_join(reloader.thread, NULL);
+        reloader.running = false;
+        signal(SIGHUP, SIG_DFL);
+    }
+
+    if (reloader.inotify_fd != -1) close(reloader.inotify_fd);
+    if (reloader.stop_fd != -1) close(reloader.stop_fd);
+    if (hangup_fd != -1) close(hangup_fd);
+    reloader.inotify_fd = reloader.stop_fd = hangup_fd = -1;
+    free(reloader.path);
+    reloader.path = NULL;
+}
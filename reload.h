@@ -0,0 +1,56 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef RELOAD_H_
+#define RELOAD_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "questions.h"
+
+#define RELOAD_SETTLE_MS 200 // Quiet time after the bank file changes before it is reloaded
+#define RELOAD_POLL_MS 10    // Interval at which a reload checks whether every reader has moved on
+
+// A thread that plays games on the bank. Its bank is a private copy of the
+// published version it last adopted, which stays valid until it reports a
+// quiescent state with bank_release
+typedef struct bank_reader {
+    atomic_uint_least64_t seen; // Version the thread has moved on to; older ones may be freed
+    uint64_t adopted;      // Version the thread's bank is a copy of
+    int wake_fd;           // eventfd signalled when a newer version is published
+    struct bank_reader *next;
+} bank_reader;
+
+// Publishes the calling thread's bank and search index as the first version,
+// before any reader is registered
+extern void publish_bank(void);
+
+// Registers the calling thread as a reader and gives it the current version;
+// returns 0 on success or -1 on error
+extern int bank_reader_register(bank_reader *r);
+
+// Unregisters a reader, so reloads no longer wait for it
+extern void bank_reader_unregister(bank_reader *r);
+
+// Switches the calling thread to the newest version if it is not on it yet,
+// saving the bank it replaces in old; returns false if there was nothing newer
+extern bool bank_adopt(bank_reader *r, question_bank *old);
+
+// Reports that the thread no longer refers to any bank older than the one it
+// adopted, so the reload that published it can free the old one
+extern void bank_release(bank_reader *r);
+
+// Starts reloading the bank from path whenever the file is replaced or written,
+// or the process receives SIGHUP, drawing boards from each like the calling
+// thread's deck; returns 0 on success or -1 on error
+extern int reload_start(const char *path);
+
+// Stops reloading
+extern void reload_stop(void);
+
+#endif /* RELOAD_H_ */
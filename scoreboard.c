@@ -0,0 +1,130 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Shared-memory scoreboard. The game publishes its scores and board to a POSIX
+ * shared-memory segment that any number of spectator processes map read-only.
+ *
+ * The segment is guarded by a seqlock. The game makes the sequence number odd,
+ * rewrites the state and makes it even again; it never waits for anyone. A
+ * reader copies the state and keeps the copy only if the sequence number was
+ * even and unchanged around it, so readers never block the game or each other
+ * and reading costs no system calls.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "scoreboard.h" // Include the scoreboard layout and prototypes.
+
+#define READ_ATTEMPTS 1000 // Copies tried before a reader gives up on a busy writer
+
+/**
+ * Creates the named shared-memory segment and maps it for publishing. A segment
+ * left behind by an earlier game is reused.
+ *
+ * @param name The name of the segment, e.g. "/jeopardy".
+ * @return The mapped scoreboard with nothing published yet, or NULL on error.
+ */
+scoreboard *scoreboard_create(const char *name) {
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        perror(name);
+        return NULL;
+    }
+
+    scoreboard *sb = MAP_FAILED;
+    if (ftruncate(fd, sizeof(scoreboard)) == 0) {
+        sb = mmap(NULL, sizeof(scoreboard), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (sb == MAP_FAILED) {
+        perror(name);
+        return NULL;
+    }
+
+    // Mark the segment busy while it is set up, in case readers are already attached.
+    atomic_store(&sb->sequence, 1);
+    memset(&sb->data, 0, sizeof(sb->data));
+    sb->data.pending_question = -1;
+    sb->data.pending_player = -1;
+    sb->magic = SCOREBOARD_MAGIC;
+    sb->version = SCOREBOARD_VERSION;
+    atomic_store_explicit(&sb->sequence, 2, memory_order_release);
+    return sb;
+}
+
+/**
+ * Maps an existing scoreboard read-only.
+ *
+ * @param name The name the game published it under.
+ * @return The scoreboard, or NULL if it does not exist or is not a scoreboard.
+ */
+const scoreboard *scoreboard_attach(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        perror(name);
+        return NULL;
+    }
+
+    const scoreboard *sb = mmap(NULL, sizeof(scoreboard), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (sb == MAP_FAILED) {
+        perror(name);
+        return NULL;
+    }
+
+    if (sb->magic != SCOREBOARD_MAGIC || sb->version != SCOREBOARD_VERSION) {
+        fprintf(stderr, "%s: not a scoreboard\n", name);
+        munmap((void *)sb, sizeof(scoreboard));
+        return NULL;
+    }
+    return sb;
+}
+
+// Makes the sequence odd; the release fence keeps the data writes after it.
+void scoreboard_begin(scoreboard *sb) {
+    unsigned s = atomic_load_explicit(&sb->sequence, memory_order_relaxed);
+    atomic_store_explicit(&sb->sequence, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+// Makes the sequence even again, publishing the data written since scoreboard_begin.
+void scoreboard_end(scoreboard *sb) {
+    unsigned s = atomic_load_explicit(&sb->sequence, memory_order_relaxed);
+    atomic_store_explicit(&sb->sequence, s + 1, memory_order_release);
+}
+
+/**
+ * Copies the published state. The copy is retried while the game is in the
+ * middle of an update, so it is never torn.
+ *
+ * @param sb The scoreboard.
+ * @param out Receives the state.
+ * @return true on success, false if every attempt overlapped an update.
+ */
+bool scoreboard_read(const scoreboard *sb, scoreboard_data *out) {
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        unsigned before = atomic_load_explicit(&sb->sequence, memory_order_acquire);
+        if (before & 1) continue;
+
+        memcpy(out, &sb->data, sizeof(*out));
+
+        // Keep the copy ahead of the second sequence load.
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&sb->sequence, memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+// Unmaps a scoreboard and, given its name, removes the segment.
+void scoreboard_close(const scoreboard *sb, const char *name) {
+    munmap((void *)sb, sizeof(scoreboard));
+    if (name != NULL) shm_unlink(name);
+}
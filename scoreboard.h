@@ -0,0 +1,81 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef SCOREBOARD_H_
+#define SCOREBOARD_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCOREBOARD_MAGIC 0x4250534au  // "JSPB"
+#define SCOREBOARD_VERSION 1
+#define SCOREBOARD_PLAYERS 64         // Players published, the leaders first
+#define SCOREBOARD_CATEGORIES 64      // Categories published
+#define SCOREBOARD_QUESTIONS 4096     // Questions whose answered bit is published
+#define SCOREBOARD_NAME 32            // Bytes of a published name, NUL included; longer names are cut
+
+// A published player, in ranking order
+typedef struct {
+    char name[SCOREBOARD_NAME];
+    int32_t score;
+    int32_t rank;          // Tie-aware rank, 1 for the leader
+} scoreboard_player;
+
+// A published category with the questions it has left
+typedef struct {
+    char name[SCOREBOARD_NAME];
+    int32_t remaining;
+} scoreboard_category;
+
+// The state of a game as shown to spectators
+typedef struct {
+    uint64_t updates;      // Number of times the state has been published
+    int32_t status;        // game_status of the game
+    int32_t pending_question;  // Question on the board, or -1
+    int32_t pending_category;  // Index into categories of that question
+    int32_t pending_value;     // Dollar value of that question
+    int32_t pending_player;    // Index into players of the player answering it, or -1
+    uint32_t total_players;    // Players in the game; only the first SCOREBOARD_PLAYERS are published
+    uint32_t num_players;
+    uint32_t num_categories;
+    uint32_t num_questions;
+    uint32_t questions_remaining;
+    scoreboard_player players[SCOREBOARD_PLAYERS];
+    scoreboard_category categories[SCOREBOARD_CATEGORIES];
+    uint64_t answered[SCOREBOARD_QUESTIONS / 64]; // Bitset of answered questions by handle, or by cell of a drawn board
+} scoreboard_data;
+
+// A shared-memory segment holding the published state, guarded by a seqlock:
+// sequence is odd while the game is writing and changes with every update
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    atomic_uint sequence;
+    scoreboard_data data;
+} scoreboard;
+
+// Creates (or takes over) the named shared-memory segment for publishing;
+// returns NULL on error
+extern scoreboard *scoreboard_create(const char *name);
+
+// Maps an existing segment read-only for a spectator; returns NULL on error
+extern const scoreboard *scoreboard_attach(const char *name);
+
+// Starts an update of the published state; readers retry until it ends
+extern void scoreboard_begin(scoreboard *sb);
+
+// Ends an update of the published state
+extern void scoreboard_end(scoreboard *sb);
+
+// Copies a consistent view of the published state; returns false if the
+// game kept updating it through every attempt
+extern bool scoreboard_read(const scoreboard *sb, scoreboard_data *out);
+
+// Unmaps a segment, removing it if name is not NULL
+extern void scoreboard_close(const scoreboard *sb, const char *name);
+
+#endif /* SCOREBOARD_H_ */
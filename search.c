@@ -0,0 +1,584 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Keyword search over the question bank. When a bank is loaded, the text and
+ * category of every question are normalized into words and an inverted index
+ * maps each word to the questions containing it. Accepted answers are left
+ * out: any player can search, and must not be able to look an answer up. The
+ * terms are kept sorted, so a prefix query is a binary search for a range of
+ * terms.
+ *
+ * Posting lists are compressed: the ascending question handles are stored as
+ * varint deltas, a byte for most gaps, in blocks of SEARCH_BLOCK with a skip
+ * entry holding each block's first handle. A query is answered by walking the
+ * cheapest of its terms and checking each candidate against the other terms,
+ * whose lists are entered by binary search over their skip entries instead of
+ * being decoded, so rare words find their questions in a few microseconds even
+ * when combined with words that occur in millions of questions.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "search.h"    // Include the index layout and prototypes of the search functions.
+#include "questions.h" // The bank being indexed.
+#include "match.h"     // Questions and queries are split into words the way answers are normalized.
+#include "util.h"      // Allocation and hashing helpers.
+
+// The calling thread's copy of the index of its bank.
+_Thread_local search_index bank_index;
+
+// Terms interned while the index is being built, in order of first appearance,
+// and the terms of each question by id.
+static struct {
+    char *text;            // NUL-terminated terms
+    size_t text_size, text_capacity;
+    uint32_t *offsets;     // Offset of each term in text
+    uint32_t *counts;      // Questions containing each term
+    uint32_t *last;        // Last question each term was counted for, so repeats in a question count once
+    uint32_t num_terms, capacity;
+    uint32_t *slots;       // Hash table of term ids plus one (0 when empty)
+    uint32_t mask;
+    uint32_t *ids;         // Question q holds the terms ids[question_start[q] .. question_start[q + 1])
+    uint64_t *question_start;
+    uint64_t num_ids, ids_capacity;
+} builder;
+
+// Places a term id in the builder's hash table, which must have a free slot.
+static void insert_term_slot(uint32_t id) {
+    const char *term = builder.text + builder.offsets[id];
+    uint32_t slot = hash_string(term, strlen(term)) & builder.mask;
+    while (builder.slots[slot] != 0) {
+        slot = (slot + 1) & builder.mask;
+    }
+    builder.slots[slot] = id + 1;
+}
+
+/**
+ * Returns the id of a term, interning it if it has not been seen before. The
+ * hash table is rehashed into a table twice the size when it becomes half full.
+ */
+static uint32_t intern_term(const char *word, size_t len) {
+    uint32_t slot = hash_string(word, len) & builder.mask;
+    while (builder.slots[slot] != 0) {
+        uint32_t id = builder.slots[slot] - 1;
+        const char *term = builder.text + builder.offsets[id];
+        if (strncmp(term, word, len) == 0 && term[len] == '\0') return id;
+        slot = (slot + 1) & builder.mask;
+    }
+
+    if (builder.num_terms == builder.capacity) {
+        builder.capacity *= 2;
+        builder.offsets = xrealloc(builder.offsets, builder.capacity * sizeof(uint32_t));
+        builder.counts = xrealloc(builder.counts, builder.capacity * sizeof(uint32_t));
+        builder.last = xrealloc(builder.last, builder.capacity * sizeof(uint32_t));
+    }
+    while (builder.text_size + len + 1 > builder.text_capacity) {
+        builder.text_capacity *= 2;
+        builder.text = xrealloc(builder.text, builder.text_capacity);
+    }
+
+    uint32_t id = builder.num_terms++;
+    builder.offsets[id] = builder.text_size;
+    builder.counts[id] = 0;
+    builder.last[id] = UINT32_MAX;
+    memcpy(builder.text + builder.text_size, word, len);
+    builder.text[builder.text_size + len] = '\0';
+    builder.text_size += len + 1;
+
+    if (builder.num_terms * 2 > builder.mask + 1) {
+        free(builder.slots);
+        builder.mask = builder.mask * 2 + 1;
+        builder.slots = xcalloc(builder.mask + 1, sizeof(uint32_t));
+        for (uint32_t i = 0; i < builder.num_terms; i++) {
+            insert_term_slot(i);
+        }
+    } else {
+        builder.slots[slot] = id + 1;
+    }
+    return id;
+}
+
+// Records a word of the question being indexed, once per question.
+static void add_word(uint32_t q, const char *word, size_t len) {
+    uint32_t id = intern_term(word, len);
+    if (builder.last[id] == q) return;
+
+    builder.last[id] = q;
+    builder.counts[id]++;
+    if (builder.num_ids == builder.ids_capacity) {
+        builder.ids_capacity *= 2;
+        builder.ids = xrealloc(builder.ids, builder.ids_capacity * sizeof(uint32_t));
+    }
+    builder.ids[builder.num_ids++] = id;
+}
+
+// Returns the searchable text of a question: its text, or its category name for part 1.
+static const char *searchable(uint32_t q, int part) {
+    return part == 0 ? bank.strings + bank.texts[q].question : category_name(bank.questions[q].category);
+}
+
+// Records the terms of a question: the words of its normalized text, then those of its category.
+static void index_question(uint32_t q) {
+    char normalized[MAX_LEN];
+
+    builder.question_start[q] = builder.num_ids;
+    for (int part = 0; part < 2; part++) {
+        const char *source = searchable(q, part);
+        size_t len = normalize_text(source, strlen(source), normalized);
+
+        const char *word = normalized, *end = normalized + len;
+        while (word < end) {
+            const char *space = memchr(word, ' ', end - word);
+            if (space == NULL) space = end;
+            add_word(q, word, space - word);
+            word = space + 1;
+        }
+    }
+}
+
+// Orders term ids by their text, for qsort.
+static int compare_terms(const void *a, const void *b) {
+    return strcmp(builder.text + builder.offsets[*(const uint32_t *)a],
+                  builder.text + builder.offsets[*(const uint32_t *)b]);
+}
+
+// Appends a value as a varint (7 bits per byte, low bits first) to a growable buffer.
+static void put_varint(unsigned char **buffer, size_t *size, size_t *capacity, uint32_t value) {
+    if (*size + 5 > *capacity) {
+        *capacity *= 2;
+        *buffer = xrealloc(*buffer, *capacity);
+    }
+    while (value >= 0x80) {
+        (*buffer)[(*size)++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    (*buffer)[(*size)++] = (unsigned char)value;
+}
+
+// Reads a varint written by put_varint, advancing the pointer past it.
+static uint32_t get_varint(const unsigned char **p) {
+    uint32_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        unsigned char byte = *(*p)++;
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (byte < 0x80) return value;
+    }
+}
+
+// Releases the index.
+void free_search_index(void) {
+    free(bank_index.terms);
+    free(bank_index.term_offsets);
+    free(bank_index.counts);
+    free(bank_index.skip_start);
+    free(bank_index.skips);
+    free(bank_index.postings);
+    memset(&bank_index, 0, sizeof(bank_index));
+}
+
+/**
+ * Builds the index of the current bank. The words of every question are
+ * interned and counted first, so once the terms are sorted each question can
+ * be placed straight into its position in the posting lists, which are then
+ * compressed into blocks and the temporary tables released.
+ */
+void build_search_index(void) {
+    free_search_index();
+
+    builder.capacity = 1024;
+    builder.text_capacity = 16384;
+    builder.mask = 2047;
+    builder.ids_capacity = 4096;
+    builder.offsets = xmalloc(builder.capacity * sizeof(uint32_t));
+    builder.counts = xmalloc(builder.capacity * sizeof(uint32_t));
+    builder.last = xmalloc(builder.capacity * sizeof(uint32_t));
+    builder.text = xmalloc(builder.text_capacity);
+    builder.slots = xcalloc(builder.mask + 1, sizeof(uint32_t));
+    builder.ids = xmalloc(builder.ids_capacity * sizeof(uint32_t));
+    builder.question_start = xmalloc((bank.num_questions + 1) * sizeof(uint64_t));
+
+    for (uint32_t q = 0; q < bank.num_questions; q++) {
+        index_question(q);
+    }
+    builder.question_start[bank.num_questions] = builder.num_ids;
+
+    // Sort the terms and lay the posting lists out in term order
+    uint32_t nt = builder.num_terms;
+    uint64_t total = builder.num_ids;
+    uint32_t *order = xmalloc((nt ? nt : 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < nt; i++) order[i] = i;
+    qsort(order, nt, sizeof(uint32_t), compare_terms);
+
+    uint64_t *next = xmalloc((nt ? nt : 1) * sizeof(uint64_t)); // Next free posting of each term id
+    uint32_t *postings = xmalloc((total ? total : 1) * sizeof(uint32_t));
+    for (uint64_t r = 0, start = 0; r < nt; r++) {
+        next[order[r]] = start;
+        start += builder.counts[order[r]];
+    }
+    for (uint32_t q = 0; q < bank.num_questions; q++) {
+        for (uint64_t i = builder.question_start[q]; i < builder.question_start[q + 1]; i++) {
+            postings[next[builder.ids[i]]++] = q;
+        }
+    }
+
+    // Copy the sorted terms and compress each posting list into blocks.
+    search_index *ix = &bank_index;
+    size_t postings_size = 0, postings_capacity = 4096;
+    uint32_t num_skips = 0;
+    ix->terms = xmalloc(builder.text_size ? builder.text_size : 1);
+    ix->term_offsets = xmalloc((nt ? nt : 1) * sizeof(uint32_t));
+    ix->counts = xmalloc((nt ? nt : 1) * sizeof(uint32_t));
+    ix->skip_start = xmalloc((nt + 1) * sizeof(uint32_t));
+    ix->postings = xmalloc(postings_capacity);
+
+    uint32_t skips_capacity = 1024;
+    ix->skips = xmalloc(skips_capacity * sizeof(search_skip));
+
+    const uint32_t *posting = postings;
+    for (uint32_t r = 0, text_size = 0; r < nt; r++) {
+        const char *term = builder.text + builder.offsets[order[r]];
+        size_t len = strlen(term) + 1;
+        memcpy(ix->terms + text_size, term, len);
+        ix->term_offsets[r] = text_size;
+        text_size += len;
+
+        uint32_t count = builder.counts[order[r]];
+        ix->counts[r] = count;
+        ix->skip_start[r] = num_skips;
+        for (uint32_t i = 0; i < count; i++) {
+            if (i % SEARCH_BLOCK == 0) {
+                if (num_skips == skips_capacity) {
+                    skips_capacity *= 2;
+                    ix->skips = xrealloc(ix->skips, skips_capacity * sizeof(search_skip));
+                }
+                ix->skips[num_skips].first = posting[i];
+                ix->skips[num_skips].offset = postings_size;
+                num_skips++;
+            } else {
+                put_varint(&ix->postings, &postings_size, &postings_capacity, posting[i] - posting[i - 1]);
+            }
+        }
+        posting += count;
+    }
+    ix->skip_start[nt] = num_skips;
+    ix->num_terms = nt;
+    ix->num_postings = total;
+
+    free(order);
+    free(next);
+    free(postings);
+    free(builder.ids);
+    free(builder.question_start);
+    free(builder.text);
+    free(builder.offsets);
+    free(builder.counts);
+    free(builder.last);
+    free(builder.slots);
+    memset(&builder, 0, sizeof(builder));
+}
+
+// Returns the term at a sorted position.
+static const char *term_at(uint32_t t) {
+    return bank_index.terms + bank_index.term_offsets[t];
+}
+
+// Returns the first sorted position whose term is not before the word (or, with
+// past_prefix, whose term neither starts with the word nor comes before it).
+static uint32_t lower_bound(const char *word, size_t len, bool past_prefix) {
+    uint32_t lo = 0, hi = bank_index.num_terms;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = strncmp(term_at(mid), word, len);
+        if (cmp == 0 && !past_prefix && term_at(mid)[len] != '\0') cmp = 1; // Longer than the word
+        if (cmp < 0 || (cmp == 0 && past_prefix)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Position in the posting list of one term.
+typedef struct {
+    uint32_t term;
+    uint32_t index;              // Position of current in the list
+    uint32_t current;            // Current question handle, UINT32_MAX once the list is exhausted
+    const unsigned char *next;   // Delta of the posting after current
+} cursor;
+
+// Positions a cursor on the first posting of a block of its term.
+static void enter_block(cursor *c, uint32_t block) {
+    const search_skip *skip = &bank_index.skips[bank_index.skip_start[c->term] + block];
+    c->index = block * SEARCH_BLOCK;
+    c->current = skip->first;
+    c->next = bank_index.postings + skip->offset;
+}
+
+// Positions a cursor on the first posting of a term.
+static void open_cursor(cursor *c, uint32_t term) {
+    c->term = term;
+    enter_block(c, 0);
+}
+
+// Moves a cursor to its next posting.
+static void advance(cursor *c) {
+    if (++c->index >= bank_index.counts[c->term]) {
+        c->current = UINT32_MAX;
+    } else if (c->index % SEARCH_BLOCK == 0) {
+        enter_block(c, c->index / SEARCH_BLOCK);
+    } else {
+        c->current += get_varint(&c->next);
+    }
+}
+
+/**
+ * Moves a cursor to the first posting at or after a question handle. When the
+ * handle lies beyond the current block, the skip entries are binary searched
+ * for the last block starting at or before it, so whole blocks are passed over
+ * without being decoded.
+ *
+ * @return The posting the cursor is on, or UINT32_MAX if there is none.
+ */
+static uint32_t seek(cursor *c, uint32_t q) {
+    if (c->current >= q) return c->current;
+
+    const search_skip *skips = bank_index.skips + bank_index.skip_start[c->term];
+    uint32_t blocks = bank_index.skip_start[c->term + 1] - bank_index.skip_start[c->term];
+    uint32_t block = c->index / SEARCH_BLOCK;
+
+    if (block + 1 < blocks && skips[block + 1].first <= q) {
+        uint32_t lo = block + 1, hi = blocks;
+        while (hi - lo > 1) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (skips[mid].first <= q) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        enter_block(c, lo);
+    }
+
+    while (c->current < q) advance(c);
+    return c->current;
+}
+
+// A query term: a range of sorted terms (a single one unless it is a prefix).
+typedef struct {
+    uint32_t first, last;        // Terms [first, last)
+    uint64_t cost;               // Postings across the range
+    const char *word;            // The word as queried, a NUL-terminated copy
+    size_t len;
+} query_term;
+
+// Checks a question for a word starting with a prefix, by its text and category rather than the index.
+static bool question_has_prefix(uint32_t q, const char *prefix, size_t len) {
+    char normalized[MAX_LEN];
+
+    for (int part = 0; part < 2; part++) {
+        const char *source = searchable(q, part);
+        size_t n = normalize_text(source, strlen(source), normalized);
+
+        for (const char *word = normalized; word != NULL && word < normalized + n;) {
+            if (strncmp(word, prefix, len) == 0) return true;
+            word = memchr(word, ' ', normalized + n - word);
+            if (word != NULL) word++;
+        }
+    }
+    return false;
+}
+
+// Orders query terms by cost, cheapest first, for qsort.
+static int compare_cost(const void *a, const void *b) {
+    uint64_t ca = ((const query_term *)a)->cost, cb = ((const query_term *)b)->cost;
+    return (ca > cb) - (ca < cb);
+}
+
+// Returns the first posting at or after a question handle among a term's cursors,
+// or UINT32_MAX if there is none.
+static uint32_t seek_any(cursor *cursors, int n, uint32_t q) {
+    uint32_t first = UINT32_MAX;
+    for (int i = 0; i < n; i++) {
+        uint32_t p = seek(&cursors[i], q);
+        if (p < first) first = p;
+    }
+    return first;
+}
+
+// A prefix too wide for its terms to be merged posting by posting: its postings
+// are gathered into a bitset one window of question handles at a time
+typedef struct {
+    cursor *cursors;             // One per term of the prefix
+    uint32_t num_cursors;
+    uint32_t start;              // The window is handles [start, start + SEARCH_WINDOW)
+    uint32_t after;              // First posting past the window, UINT32_MAX if none
+    uint64_t marked[SEARCH_WINDOW / 64];
+} window;
+
+// Gathers the postings of the window starting at a handle.
+static void fill_window(window *w, uint32_t start) {
+    uint32_t end = start + SEARCH_WINDOW;
+    w->start = start;
+    w->after = UINT32_MAX;
+    memset(w->marked, 0, sizeof(w->marked));
+
+    for (uint32_t i = 0; i < w->num_cursors; i++) {
+        cursor *c = &w->cursors[i];
+        for (seek(c, start); c->current < end; advance(c)) {
+            w->marked[(c->current - start) / 64] |= 1ULL << (c->current % 64);
+        }
+        if (c->current < w->after) w->after = c->current;
+    }
+}
+
+/**
+ * Finds the first posting at or after a question handle among the terms of a
+ * wide prefix, moving the window on as needed. A window with nothing left past
+ * the handle moves straight to the window of the next posting, so the empty
+ * stretches of the lists are skipped.
+ *
+ * @return The posting, or UINT32_MAX if there is none.
+ */
+static uint32_t next_in_window(window *w, uint32_t q) {
+    for (;;) {
+        if (q >= w->start + SEARCH_WINDOW || q < w->start) {
+            if (q == UINT32_MAX) return UINT32_MAX;
+            fill_window(w, q - q % SEARCH_WINDOW);
+        }
+
+        uint32_t word = (q - w->start) / 64;
+        uint64_t bits = w->marked[word] & (~0ULL << (q % 64));
+        while (bits == 0 && ++word < SEARCH_WINDOW / 64) {
+            bits = w->marked[word];
+        }
+        if (bits != 0) return w->start + word * 64 + __builtin_ctzll(bits);
+        q = w->after;
+    }
+}
+
+/**
+ * Splits a query into terms and resolves each to its range in the index. Each
+ * whitespace-separated word is normalized like question text, which may split
+ * it further (o'brien is o and brien); a trailing '*' makes its last part a prefix.
+ *
+ * @param words Receives the NUL-terminated normalized words the terms point into.
+ * @return The number of terms, 0 if there are none, or -1 if some term matches nothing.
+ */
+static int parse_query(const char *query, query_term *terms, char words[][MAX_LEN]) {
+    int count = 0;
+    const char *p = query;
+
+    while (*p != '\0' && count < SEARCH_MAX_TERMS) {
+        while (*p == ' ' || *p == '\t') p++;
+        const char *end = p;
+        while (*end != '\0' && *end != ' ' && *end != '\t') end++;
+        if (end == p) break;
+
+        bool prefix = end[-1] == '*';
+        char normalized[MAX_LEN];
+        size_t n = normalize_text(p, end - p, normalized);
+        p = end;
+
+        for (char *word = normalized; n > 0 && count < SEARCH_MAX_TERMS;) {
+            char *space = memchr(word, ' ', normalized + n - word);
+            size_t len = (space ? space : normalized + n) - word;
+            bool is_prefix = prefix && space == NULL;
+
+            query_term *t = &terms[count];
+            memcpy(words[count], word, len);
+            words[count][len] = '\0';
+            t->word = words[count];
+            t->len = len;
+            t->first = lower_bound(word, len, false);
+            t->last = is_prefix ? lower_bound(word, len, true) : t->first + 1;
+            if (!is_prefix && (t->first == bank_index.num_terms || strcmp(term_at(t->first), t->word) != 0)) {
+                return -1;
+            }
+            if (t->first == t->last) return -1;
+
+            t->cost = 0;
+            for (uint32_t r = t->first; r < t->last; r++) t->cost += bank_index.counts[r];
+            count++;
+
+            if (space == NULL) break;
+            word = space + 1;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Answers a query: the questions whose text or category contain every
+ * term. The terms are intersected in ascending order of question handle,
+ * leapfrogging: the cheapest term proposes a candidate and every other term
+ * either contains it or names the next question it could match, from which the
+ * cheapest term proposes again. A term is followed through a cursor per term
+ * of its range; a prefix wider than SEARCH_CURSORS terms is instead gathered
+ * window by window when it is the cheapest, or checked against the
+ * candidate's text otherwise. The search stops once max_results matches are found.
+ *
+ * @param query Words separated by spaces; a word ending in '*' is a prefix.
+ * @param results Receives the handles of the matching questions.
+ * @param max_results The most handles to store.
+ * @return The number of handles stored.
+ */
+int search_questions(const char *query, int32_t *results, int max_results) {
+    query_term terms[SEARCH_MAX_TERMS];
+    char words[SEARCH_MAX_TERMS][MAX_LEN];
+    int num_terms = parse_query(query, terms, words);
+    if (num_terms <= 0 || max_results <= 0) return 0;
+
+    qsort(terms, num_terms, sizeof(query_term), compare_cost);
+
+    cursor cursors[SEARCH_MAX_TERMS][SEARCH_CURSORS];
+    int num_cursors[SEARCH_MAX_TERMS];
+    for (int t = 0; t < num_terms; t++) {
+        uint32_t range = terms[t].last - terms[t].first;
+        num_cursors[t] = range <= SEARCH_CURSORS ? (int)range : 0;
+        for (int i = 0; i < num_cursors[t]; i++) open_cursor(&cursors[t][i], terms[t].first + i);
+    }
+
+    // A wide prefix proposing the candidates is gathered window by window
+    window *wide = NULL;
+    if (num_cursors[0] == 0) {
+        wide = xmalloc(sizeof(window));
+        wide->num_cursors = terms[0].last - terms[0].first;
+        wide->cursors = xmalloc(wide->num_cursors * sizeof(cursor));
+        for (uint32_t i = 0; i < wide->num_cursors; i++) open_cursor(&wide->cursors[i], terms[0].first + i);
+        fill_window(wide, 0);
+    }
+
+    int found = 0;
+    uint32_t q = 0;
+    while (found < max_results) {
+        q = wide ? next_in_window(wide, q) : seek_any(cursors[0], num_cursors[0], q);
+        if (q == UINT32_MAX) break;
+
+        uint32_t next = q;
+        for (int t = 1; t < num_terms && next == q; t++) {
+            if (num_cursors[t] > 0) {
+                next = seek_any(cursors[t], num_cursors[t], q);
+            } else if (!question_has_prefix(q, terms[t].word, terms[t].len)) {
+                next = q + 1;
+            }
+        }
+
+        if (next == q) {
+            results[found++] = q;
+            next = q + 1;
+        }
+        if (next == UINT32_MAX) break;
+        q = next;
+    }
+
+    if (wide) free(wide->cursors);
+    free(wide);
+    return found;
+}
@@ -0,0 +1,54 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+#include <stdint.h>
+
+#define SEARCH_BLOCK 128      // Postings per block of a posting list, each reachable through its skip entry
+#define SEARCH_MAX_TERMS 8    // Terms in a query; the rest are ignored
+#define SEARCH_CURSORS 16     // Terms a prefix may expand to before candidates are checked against their text
+#define SEARCH_WINDOW 4096    // Question handles gathered at a time from the terms of a wider prefix
+#define SEARCH_RESULTS 20     // Matches listed by the search command
+
+// Start of one block of a posting list
+typedef struct {
+    uint32_t first;  // The block's first question handle
+    uint32_t offset; // Byte offset of the varint deltas of the rest of the block in postings
+} search_skip;
+
+// Inverted index of the words of every question's text and category.
+// Terms are sorted, so a prefix is a range of terms; each term's posting list
+// holds the handles of the questions containing it in ascending order, as
+// blocks of varint-encoded deltas behind a skip table.
+typedef struct {
+    char *terms;               // NUL-terminated terms, in sorted order
+    uint32_t *term_offsets;    // Offset of each term in terms
+    uint32_t *counts;          // Postings of each term
+    uint32_t *skip_start;      // Term t's blocks are skips[skip_start[t] .. skip_start[t + 1])
+    search_skip *skips;
+    unsigned char *postings;
+    uint32_t num_terms;
+    uint64_t num_postings;
+} search_index;
+
+// The index of the current bank, shared read-only by every game once built and
+// copied per thread along with the bank
+extern _Thread_local search_index bank_index;
+
+// Builds the index of the current bank, replacing the previous one
+extern void build_search_index(void);
+
+// Releases the index
+extern void free_search_index(void);
+
+// Finds the questions containing every word of a query, where a word ending in
+// '*' matches any word it is a prefix of; stores up to max_results handles in
+// ascending order and returns how many were stored
+extern int search_questions(const char *query, int32_t *results, int max_results);
+
+#endif /* SEARCH_H_ */
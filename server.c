@@ -0,0 +1,1067 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Multi-session game server. Clients connect to a Unix domain socket and each
+ * connection plays its own game, with its own board and players, on the question
+ * bank shared read-only by every session. Each worker thread runs its own epoll
+ * loop; the listening socket is in every loop (with EPOLLEXCLUSIVE, so one worker
+ * wakes per connection) and the worker that accepts a connection owns the session
+ * for its whole life. Nothing of a session is shared between threads, so sessions
+ * need no locking; only the shared games below are locked.
+ *
+ * Sockets are non-blocking. Input is split into lines by a line reader and fed
+ * to game_line, and the game output is written to a per-session buffer through a
+ * stdio stream, then sent as the socket accepts it. A session with unsent output
+ * is not read from until the output drains, so a client that stops reading
+ * cannot grow it forever. Timed games also get a timerfd in the same loop, armed
+ * for the game's next deadline, so an idle player forfeits on time.
+ *
+ * Each worker is a reader of the question bank. When a reloaded bank is
+ * published, the worker is woken and moves all of its games onto it between
+ * two batches of events, so no event is ever handled half on the old bank.
+ *
+ * Each worker also keeps a pool of the games of its closed sessions, so a new
+ * connection takes a game whose arena has already grown to the size of a game
+ * and ending a session frees all of its game at once.
+ *
+ * A connection may instead enter a shared game with game <id>, giving up its own
+ * game; every connection entering the same id plays the same game. The worker
+ * that created a shared game hosts it: only that worker plays its lines, ticks
+ * its deadlines and moves it onto a reloaded bank, so the game stays on one
+ * worker's copy of the bank. Members on other workers hand their lines to the
+ * host through an inbox under the game's lock and copy its output from a shared
+ * log, each side waking the other with an eventfd. Buzzes skip the host: the
+ * member's worker stamps a buzz when it reads the line and presses it straight
+ * into the game's lock-free buzz queue, so buzzes racing in on several workers
+ * are ordered by when they arrived, not by when the host got to them. A buzz
+ * settles for BUZZ_SETTLE before it is granted, so an earlier buzz still on its
+ * way from a busy worker is not overtaken.
+ */
+#define _GNU_SOURCE // fopencookie, accept4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "server.h"   // Include the server prototypes.
+#include "jeopardy.h" // Include the game engine.
+#include "input.h"    // Include the line reader and deadline timers.
+#include "reload.h"   // Include the bank readers.
+#include "util.h"     // Allocation helpers and the monotonic clock.
+
+#define MAX_EVENTS 16      // Events taken from epoll per wait
+#define LISTEN_BACKLOG 128
+#define SHARED_ID_LEN 64   // Longest id of a shared game, with its NUL
+#define BUZZ_SETTLE 1000000ULL // Nanoseconds a buzz in a shared game settles before it is granted
+
+// What an epoll event refers to.
+typedef enum {
+    SOURCE_LISTEN,         // The listening socket
+    SOURCE_STOP,           // The eventfd that stops the workers
+    SOURCE_RELOAD,         // The worker's eventfd signalled when a reloaded bank is published
+    SOURCE_SOCKET,         // A session's connection
+    SOURCE_TIMER,          // A session's deadline timer
+    SOURCE_SHARED,         // A member's eventfd, signalled when its shared game has output for it
+    SOURCE_HOST,           // A hosted shared game's eventfd, signalled when its members sent something
+    SOURCE_HOST_TIMER      // A hosted shared game's deadline timer
+} source_kind;
+
+// Data of an epoll registration: its kind and the session or shared game.
+typedef struct {
+    source_kind kind;
+    struct session *s;
+    struct shared_game *sg;
+} event_source;
+
+// A session's place in a shared game. The session's worker owns it until the
+// session leaves; then the host frees it.
+typedef struct member {
+    struct shared_game *sg;
+    int wake_fd;           // eventfd in the session's worker, -1 once the session has left
+    atomic_int player;     // Handle of the player the session registered, -1 until it has
+    char name[MAX_LEN];    // Name of that player, set by the host before player
+    size_t read;           // Offset in the game's output up to which the session has copied it
+    char *notice;          // Output for this session only, such as a refused answer
+    size_t notice_len, notice_capacity;
+    struct member *next;
+} member;
+
+// A line a member sent to its shared game, waiting for the host.
+typedef struct inbox_line {
+    member *m;
+    struct inbox_line *next;
+    char text[];
+} inbox_line;
+
+// A game shared by the sessions that entered it by id, played by the worker
+// that created it.
+typedef struct shared_game {
+    char id[SHARED_ID_LEN];
+    game g;                // Played only by the host
+    int wake_fd;           // eventfd signalled by members sending lines, buzzing or leaving
+    int timer_fd;          // Deadline timer of the game
+    event_source wake_source, timer_source;
+    FILE *out;             // Stream the game writes to, appending to the log
+    pthread_mutex_t lock;  // Guards the log, inbox, members and status
+    char *log;             // Output not yet copied by every member
+    size_t log_base;       // Offset of the start of the log in all of the game's output
+    size_t log_len, log_capacity;
+    inbox_line *inbox, **inbox_tail;
+    member *members;       // Members, including those that left but are not freed yet
+    game_status status;    // Status of the game as of the host's last publish
+    bool listed;           // Can be entered; changed under both the server's and the game's lock
+    struct shared_game *next; // In the server's shared games, under its lock
+
+    // Used by the host only
+    uint64_t armed;        // Deadline the timer is armed for, 0 if disarmed
+    size_t published;      // Offset of the end of the output at the last publish
+    bool finished;         // The results have been shown
+    bool closed;           // Retired, and freed after the current batch of events
+    struct shared_game *host_next; // In the host's hosted or retired games
+} shared_game;
+
+// A connected client and the game it plays.
+typedef struct session {
+    int fd;
+    int timer_fd;          // Deadline timer of a timed game, or -1
+    event_source socket_source, timer_source, shared_source;
+    game *g;               // From the worker's pool of games, or NULL in a shared game
+    member *member;        // Place in a shared game, or NULL
+    FILE *out;             // Stream the game writes to, appending to the output buffer
+    char *output;          // Output not yet sent to the client
+    size_t output_len, output_sent, output_capacity;
+    line_reader input;
+    uint32_t watched;      // Events the socket is registered for
+    uint64_t armed;        // Deadline the timer is armed for, 0 if disarmed
+    bool closing;          // Close the session once its output has been sent
+    bool closed;           // Closed, and freed after the current batch of events
+    struct session *prev, *next;
+} session;
+
+struct server;
+
+// A worker thread with its own event loop and the sessions it owns.
+typedef struct worker {
+    pthread_t thread;
+    int epoll_fd;
+    session *sessions;
+    session *closed;       // Sessions closed during the current batch of events
+    shared_game *hosted;   // Shared games the worker hosts
+    shared_game *retired;  // Hosted games retired during the current batch of events
+    game_pool games;       // Games of closed sessions, for the next sessions
+    bank_reader reader;    // The worker's hold on the question bank
+    struct server *srv;
+} worker;
+
+// State shared by the worker threads; read-only while they run, apart from the
+// list of shared games under games_lock.
+typedef struct server {
+    int listen_fd;
+    int stop_fd;           // eventfd signalled to stop the workers
+    game_rules rules;      // Rules every game is played by
+    pthread_mutex_t games_lock; // Taken before any shared game's lock
+    shared_game *games;    // Shared games that have not been retired
+} server;
+
+static event_source listen_source = { SOURCE_LISTEN, NULL, NULL };
+static event_source stop_source = { SOURCE_STOP, NULL, NULL };
+static event_source reload_source = { SOURCE_RELOAD, NULL, NULL };
+
+// The eventfd the signal handler signals; write is async-signal-safe.
+static int signal_fd = -1;
+
+// Signals an eventfd; write is async-signal-safe.
+static void wake(int fd) {
+    uint64_t one = 1;
+    ssize_t n = write(fd, &one, sizeof(one));
+    (void)n;
+}
+
+// Resets an eventfd or timerfd that was signalled.
+static void consume(int fd) {
+    uint64_t count;
+    ssize_t n = read(fd, &count, sizeof(count));
+    (void)n;
+}
+
+// Signal handler for SIGINT and SIGTERM: wakes every worker to stop.
+static void on_signal(int sig) {
+    (void)sig;
+    wake(signal_fd);
+}
+
+// Stream write function of a session's output: appends to the output buffer.
+static ssize_t session_write(void *cookie, const char *buf, size_t size) {
+    session *s = cookie;
+    if (s->output_len + size > s->output_capacity) {
+        s->output_capacity = (s->output_len + size) * 2;
+        s->output = xrealloc(s->output, s->output_capacity);
+    }
+    memcpy(s->output + s->output_len, buf, size);
+    s->output_len += size;
+    return size;
+}
+
+// Returns true if a session has output waiting to be sent.
+static bool output_pending(const session *s) {
+    return s->output_sent < s->output_len;
+}
+
+/**
+ * Sends as much of a session's pending output as the socket accepts.
+ *
+ * @param s The session.
+ * @return 0 if the output was sent or the socket is full, -1 if the connection failed.
+ */
+static int send_output(session *s) {
+    fflush(s->out);
+
+    while (output_pending(s)) {
+        ssize_t n = send(s->fd, s->output + s->output_sent, s->output_len - s->output_sent, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        s->output_sent += n;
+    }
+
+    s->output_len = s->output_sent = 0;
+    return 0;
+}
+
+// Reports the end of a session's game and closes the session once it is sent.
+static void session_status(session *s, game_status status) {
+    if (status == GAME_OVER && !s->closing) {
+        fprintf(s->out, "All questions have been answered. The game is over.\n");
+        show_results(s->out, &s->g->players);
+    }
+    if (status != GAME_RUNNING) {
+        s->closing = true;
+    }
+}
+
+// Registers a descriptor in a worker's event loop.
+static int watch(worker *w, int fd, uint32_t events, event_source *source) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = source;
+    return epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/**
+ * Brings a session's registrations in line with its state: the socket is
+ * watched for input, or for output while output is pending, and the timer is
+ * armed for the game's next deadline.
+ *
+ * @return 0 on success, or -1 if the socket could not be watched.
+ */
+static int update_session(worker *w, session *s) {
+    uint32_t events = output_pending(s) ? EPOLLOUT : EPOLLIN | EPOLLRDHUP;
+    if (events != s->watched) {
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = &s->socket_source;
+        if (epoll_ctl(w->epoll_fd, EPOLL_CTL_MOD, s->fd, &ev) == -1) return -1;
+        s->watched = events;
+    }
+
+    if (s->timer_fd != -1) {
+        uint64_t deadline = game_deadline(s->g);
+        if (deadline != s->armed) {
+            arm_deadline(s->timer_fd, deadline);
+            s->armed = deadline;
+        }
+    }
+    return 0;
+}
+
+// Returns what follows the first word of a line if that word is the given one, or NULL.
+static const char *command_args(const char *text, const char *word) {
+    size_t len = strlen(word);
+    if (strncmp(text, word, len) != 0 || (text[len] != '\0' && !isspace((unsigned char)text[len]))) {
+        return NULL;
+    }
+    return text + len + strspn(text + len, " \t");
+}
+
+// Stream write function of a shared game's output: appends to the log.
+static ssize_t shared_write(void *cookie, const char *buf, size_t size) {
+    shared_game *sg = cookie;
+    pthread_mutex_lock(&sg->lock);
+    if (sg->log_len + size > sg->log_capacity) {
+        sg->log_capacity = (sg->log_len + size) * 2;
+        sg->log = xrealloc(sg->log, sg->log_capacity);
+    }
+    memcpy(sg->log + sg->log_len, buf, size);
+    sg->log_len += size;
+    pthread_mutex_unlock(&sg->lock);
+    return size;
+}
+
+// Frees a list of members that have left their shared game.
+static void free_members(member *m) {
+    while (m != NULL) {
+        member *next = m->next;
+        free(m->notice);
+        free(m);
+        m = next;
+    }
+}
+
+// Frees a shared game whose descriptors are closed and whose members have all left.
+static void free_shared(shared_game *sg) {
+    fclose(sg->out); // Flushes into the log, so before the log is freed
+    free_members(sg->members);
+    while (sg->inbox != NULL) {
+        inbox_line *l = sg->inbox;
+        sg->inbox = l->next;
+        free(l);
+    }
+    game_free(&sg->g);
+    free(sg->log);
+    pthread_mutex_destroy(&sg->lock);
+    free(sg);
+}
+
+/**
+ * Takes a session out of its shared game; the host frees the member. The host
+ * is woken under the game's lock, since the game is freed once its last member
+ * has left.
+ */
+static void leave_shared(session *s) {
+    member *m = s->member;
+    shared_game *sg = m->sg;
+
+    pthread_mutex_lock(&sg->lock);
+    int fd = m->wake_fd;
+    m->wake_fd = -1;
+    wake(sg->wake_fd);
+    pthread_mutex_unlock(&sg->lock);
+
+    close(fd);
+    s->member = NULL;
+}
+
+// Closes a session's connection. The session itself is only freed once the
+// current batch of events is handled, since a later event of the batch (say,
+// its timer) may still refer to it.
+static void close_session(worker *w, session *s) {
+    close(s->fd); // Closing removes the descriptors from the event loop
+    if (s->timer_fd != -1) close(s->timer_fd);
+    if (s->member != NULL) leave_shared(s);
+    s->closed = true;
+
+    if (s->prev) s->prev->next = s->next;
+    else w->sessions = s->next;
+    if (s->next) s->next->prev = s->prev;
+
+    s->next = w->closed;
+    w->closed = s;
+}
+
+// Frees the sessions closed during the last batch of events.
+static void free_closed(worker *w) {
+    while (w->closed != NULL) {
+        session *s = w->closed;
+        w->closed = s->next;
+
+        fclose(s->out);
+        if (s->g != NULL) game_release(&w->games, s->g);
+        free(s->output);
+        free(s);
+    }
+
+    while (w->retired != NULL) {
+        shared_game *sg = w->retired;
+        w->retired = sg->host_next;
+        free_shared(sg);
+    }
+}
+
+// Finishes handling an event: closes the session on error or once a finished
+// game's output is sent, and updates its registrations otherwise.
+static void finish_event(worker *w, session *s, int status) {
+    if (status == 0 && s->closing && !output_pending(s)) {
+        status = -1;
+    }
+    if (status == -1 || update_session(w, s) == -1) {
+        close_session(w, s);
+    }
+}
+
+/**
+ * Creates a shared game hosted by a worker and lists it in the server's shared
+ * games. The caller holds the server's games_lock.
+ *
+ * @param w The worker, which becomes the host.
+ * @param id The id of the game.
+ * @return The game, or NULL if its descriptors could not be set up.
+ */
+static shared_game *host_game(worker *w, const char *id) {
+    static const cookie_io_functions_t io = { NULL, shared_write, NULL, NULL };
+    server *srv = w->srv;
+
+    shared_game *sg = xcalloc(1, sizeof(shared_game));
+    snprintf(sg->id, sizeof(sg->id), "%s", id);
+    pthread_mutex_init(&sg->lock, NULL);
+    sg->wake_source = (event_source){ SOURCE_HOST, NULL, sg };
+    sg->timer_source = (event_source){ SOURCE_HOST_TIMER, NULL, sg };
+    sg->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    sg->timer_fd = deadline_timer();
+    sg->out = fopencookie(sg, "w", io);
+    if (sg->wake_fd == -1 || sg->timer_fd == -1 || sg->out == NULL ||
+        watch(w, sg->wake_fd, EPOLLIN, &sg->wake_source) == -1 ||
+        watch(w, sg->timer_fd, EPOLLIN, &sg->timer_source) == -1) {
+        perror("shared game");
+        if (sg->out != NULL) fclose(sg->out);
+        if (sg->wake_fd != -1) close(sg->wake_fd);
+        if (sg->timer_fd != -1) close(sg->timer_fd);
+        pthread_mutex_destroy(&sg->lock);
+        free(sg);
+        return NULL;
+    }
+
+    // Members buzz from their own workers, so a buzz waits for earlier ones still on their way
+    game_rules rules = srv->rules;
+    if (rules.buzzer) rules.buzz_settle = BUZZ_SETTLE;
+    game_init(&sg->g, sg->out, true, &rules);
+    sg->inbox_tail = &sg->inbox;
+    sg->status = GAME_RUNNING;
+    sg->listed = true;
+
+    sg->next = srv->games;
+    srv->games = sg;
+    sg->host_next = w->hosted;
+    w->hosted = sg;
+    return sg;
+}
+
+/**
+ * Moves a session into the shared game with the given id, which this worker
+ * creates and hosts if no game of that id is open. The session's own game goes
+ * back to the pool.
+ *
+ * @param w The worker owning the session.
+ * @param s The session.
+ * @param id The id of the game.
+ */
+static void enter_shared(worker *w, session *s, const char *id) {
+    if (strlen(id) >= SHARED_ID_LEN) {
+        fprintf(s->out, "Game ids are at most %d characters.\n", SHARED_ID_LEN - 1);
+        return;
+    }
+
+    member *m = xcalloc(1, sizeof(member));
+    atomic_init(&m->player, -1);
+    m->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m->wake_fd == -1 || watch(w, m->wake_fd, EPOLLIN, &s->shared_source) == -1) {
+        perror("shared game");
+        if (m->wake_fd != -1) close(m->wake_fd);
+        free(m);
+        fprintf(s->out, "Could not enter game %s.\n", id);
+        return;
+    }
+
+    server *srv = w->srv;
+    pthread_mutex_lock(&srv->games_lock);
+    shared_game *sg = srv->games;
+    while (sg != NULL && !(sg->listed && strcmp(sg->id, id) == 0)) {
+        sg = sg->next;
+    }
+    if (sg == NULL) sg = host_game(w, id);
+    if (sg != NULL) {
+        pthread_mutex_lock(&sg->lock);
+        m->sg = sg;
+        m->read = sg->log_base + sg->log_len; // The member sees the output from here on
+        m->next = sg->members;
+        sg->members = m;
+        pthread_mutex_unlock(&sg->lock);
+    }
+    pthread_mutex_unlock(&srv->games_lock);
+
+    if (sg == NULL) {
+        close(m->wake_fd);
+        free(m);
+        fprintf(s->out, "Could not enter game %s.\n", id);
+        return;
+    }
+
+    game_release(&w->games, s->g);
+    s->g = NULL;
+    if (s->timer_fd != -1) {
+        close(s->timer_fd); // The host keeps the shared game's time
+        s->timer_fd = -1;
+        s->armed = 0;
+    }
+    s->member = m;
+    fprintf(s->out, "Entered game %s. Register with join [user] to play.\n", id);
+}
+
+/**
+ * Handles a line from a session in a shared game. A buzz for the session's own
+ * player is pressed straight into the game's buzz queue, stamped with when the
+ * line was received; exit leaves the game; any other line goes to the host.
+ *
+ * @param s The session.
+ * @param text The trimmed line.
+ * @param received When the line was read, from monotonic_ns.
+ */
+static void member_line(session *s, const char *text, uint64_t received) {
+    member *m = s->member;
+    shared_game *sg = m->sg;
+    size_t len = strlen(text);
+    if (len == 0) return;
+
+    if (command_args(text, "exit") != NULL) {
+        s->closing = true;
+        return;
+    }
+
+    // The player and its name are published by the host, the name first
+    int p = atomic_load(&m->player);
+    const char *buzzing = sg->g.rules.buzzer ? command_args(text, "buzz") : NULL;
+    if (buzzing != NULL && *buzzing == '\0' && p == -1) {
+        fprintf(s->out, "Register with join [user] to buzz in.\n");
+        return;
+    }
+    if (buzzing != NULL && (*buzzing == '\0' || strcmp(buzzing, m->name) == 0)) {
+        if (!game_buzz(&sg->g, p, received)) {
+            fprintf(s->out, "The buzzer is not accepting buzzes.\n");
+            return;
+        }
+        wake(sg->wake_fd);
+        return;
+    }
+
+    inbox_line *l = xmalloc(sizeof(inbox_line) + len + 1);
+    l->m = m;
+    l->next = NULL;
+    memcpy(l->text, text, len + 1);
+
+    pthread_mutex_lock(&sg->lock);
+    *sg->inbox_tail = l;
+    sg->inbox_tail = &l->next;
+    pthread_mutex_unlock(&sg->lock);
+    wake(sg->wake_fd);
+}
+
+/**
+ * Handles output of a session's shared game: copies what the session has not
+ * seen, and the notices for it alone, to the session, which closes once the
+ * game is over. Output every member has copied is dropped from the log.
+ */
+static void shared_event(worker *w, session *s) {
+    member *m = s->member;
+    shared_game *sg = m->sg;
+    consume(m->wake_fd);
+
+    pthread_mutex_lock(&sg->lock);
+    size_t end = sg->log_base + sg->log_len;
+    fwrite(sg->log + (m->read - sg->log_base), 1, end - m->read, s->out);
+    m->read = end;
+    if (m->notice_len > 0) fwrite(m->notice, 1, m->notice_len, s->out);
+    m->notice_len = 0;
+    if (sg->status != GAME_RUNNING) s->closing = true;
+
+    size_t seen = end;
+    for (member *o = sg->members; o != NULL; o = o->next) {
+        if (o->wake_fd != -1 && o->read < seen) seen = o->read;
+    }
+    memmove(sg->log, sg->log + (seen - sg->log_base), end - seen);
+    sg->log_len = end - seen;
+    sg->log_base = seen;
+    pthread_mutex_unlock(&sg->lock);
+
+    finish_event(w, s, send_output(s));
+}
+
+// Adds output for one member of a shared game only and wakes it; the caller holds the game's lock.
+static void notify(member *m, const char *text) {
+    if (m->wake_fd == -1) return;
+
+    size_t len = strlen(text);
+    if (m->notice_len + len > m->notice_capacity) {
+        m->notice_capacity = (m->notice_len + len) * 2;
+        m->notice = xrealloc(m->notice, m->notice_capacity);
+    }
+    memcpy(m->notice + m->notice_len, text, len);
+    m->notice_len += len;
+    wake(m->wake_fd);
+}
+
+/**
+ * Plays a line a member sent to a hosted shared game. While a player is
+ * answering, only that player's member is heard. A member whose line registers
+ * a player is bound to it, so that its buzzes can skip the host.
+ *
+ * @param sg The game.
+ * @param l The line.
+ */
+static void play_shared(shared_game *sg, inbox_line *l) {
+    game *g = &sg->g;
+    member *m = l->m;
+    int p = atomic_load(&m->player);
+
+    if (g->pending_player != -1 && p != g->pending_player) {
+        char text[MAX_LEN + 32];
+        snprintf(text, sizeof(text), "It is %s's turn to answer.\n", player_name(&g->players, g->pending_player));
+        pthread_mutex_lock(&sg->lock);
+        notify(m, text);
+        pthread_mutex_unlock(&sg->lock);
+        return;
+    }
+
+    int joined = g->players.num_players;
+    game_line(g, l->text);
+    if (p == -1 && g->players.num_players > joined) {
+        snprintf(m->name, sizeof(m->name), "%s", player_name(&g->players, joined));
+        atomic_store(&m->player, joined);
+    }
+}
+
+/**
+ * Delists a hosted shared game that is over or has no members, so nobody else
+ * enters it, and once its last member has left closes it; it is freed after
+ * the current batch of events.
+ */
+static void retire_shared(worker *w, shared_game *sg) {
+    server *srv = w->srv;
+    pthread_mutex_lock(&srv->games_lock);
+    pthread_mutex_lock(&sg->lock);
+
+    bool empty = true;
+    for (member *m = sg->members; m != NULL; m = m->next) {
+        if (m->wake_fd != -1) empty = false;
+    }
+    sg->listed = !empty && sg->g.status == GAME_RUNNING; // Someone may have entered meanwhile
+    if (empty) {
+        shared_game **link = &srv->games;
+        while (*link != sg) link = &(*link)->next;
+        *link = sg->next;
+    }
+
+    pthread_mutex_unlock(&sg->lock);
+    pthread_mutex_unlock(&srv->games_lock);
+    if (!empty) return;
+
+    close(sg->wake_fd);
+    close(sg->timer_fd);
+    sg->closed = true;
+
+    shared_game **link = &w->hosted;
+    while (*link != sg) link = &(*link)->host_next;
+    *link = sg->host_next;
+    sg->host_next = w->retired;
+    w->retired = sg;
+}
+
+/**
+ * Publishes a hosted shared game after the host played it: shows the results
+ * once it is over, wakes the members if there is news for them and arms the
+ * timer for the game's next deadline.
+ */
+static void publish_shared(worker *w, shared_game *sg) {
+    game *g = &sg->g;
+    if (g->status == GAME_OVER && !sg->finished) {
+        fprintf(sg->out, "All questions have been answered. The game is over.\n");
+        show_results(sg->out, &g->players);
+        sg->finished = true;
+    }
+    fflush(sg->out);
+
+    pthread_mutex_lock(&sg->lock);
+    size_t end = sg->log_base + sg->log_len;
+    bool news = end != sg->published || g->status != sg->status;
+    sg->published = end;
+    sg->status = g->status;
+    int active = 0;
+    for (member *m = sg->members; m != NULL; m = m->next) {
+        if (m->wake_fd == -1) continue;
+        active++;
+        if (news) wake(m->wake_fd);
+    }
+    pthread_mutex_unlock(&sg->lock);
+
+    if (active == 0 || (g->status != GAME_RUNNING && sg->listed)) {
+        retire_shared(w, sg);
+        if (sg->closed) return;
+    }
+
+    uint64_t deadline = g->status == GAME_RUNNING ? game_deadline(g) : 0;
+    if (deadline != sg->armed) {
+        arm_deadline(sg->timer_fd, deadline);
+        sg->armed = deadline;
+    }
+}
+
+/**
+ * Handles a hosted shared game's members sending something: plays their lines,
+ * grants the buzzes they pressed, frees the members that left and publishes
+ * the game.
+ */
+static void host_event(worker *w, shared_game *sg) {
+    consume(sg->wake_fd);
+
+    // The lines of a member that left are all in the inbox by now, so both are taken together
+    pthread_mutex_lock(&sg->lock);
+    inbox_line *lines = sg->inbox;
+    sg->inbox = NULL;
+    sg->inbox_tail = &sg->inbox;
+    member *left = NULL;
+    for (member **link = &sg->members; *link != NULL;) {
+        member *m = *link;
+        if (m->wake_fd == -1) {
+            *link = m->next;
+            m->next = left;
+            left = m;
+        } else {
+            link = &m->next;
+        }
+    }
+    pthread_mutex_unlock(&sg->lock);
+
+    while (lines != NULL) {
+        inbox_line *l = lines;
+        lines = l->next;
+        play_shared(sg, l);
+        free(l);
+    }
+    free_members(left);
+
+    game_poll(&sg->g);
+    publish_shared(w, sg);
+}
+
+// Handles expiry of a hosted shared game's timer: the game forfeits whatever ran
+// out of time and grants a buzz that has settled.
+static void host_timer_event(worker *w, shared_game *sg) {
+    consume(sg->timer_fd);
+    sg->armed = 0;
+    game_tick(&sg->g, monotonic_ns());
+    publish_shared(w, sg);
+}
+
+/**
+ * Reads the available input of a session and feeds its complete lines to the
+ * game, or to the shared game the session entered with game <id>. Reading stops
+ * early once the session has output to send. When the client hangs up, the
+ * lines it sent are still played and the session closes after their output.
+ *
+ * @param w The worker owning the session.
+ * @param s The session.
+ * @return 0 on success, or -1 if the connection failed.
+ */
+static int read_input(worker *w, session *s) {
+    while (!s->closing) {
+        int n = line_reader_fill(&s->input);
+        uint64_t received = monotonic_ns(); // Buzzes are stamped with when their line arrived
+
+        char *line;
+        while (!s->closing && (line = line_reader_next(&s->input)) != NULL) {
+            char *text = trim(line);
+            const char *id = command_args(text, "game");
+            if (s->member != NULL) {
+                member_line(s, text, received);
+            } else if (id != NULL && *id != '\0') {
+                enter_shared(w, s, id);
+            } else {
+                session_status(s, game_line(s->g, text));
+            }
+        }
+
+        if (n == -1) s->closing = true;
+        if (send_output(s) == -1) return -1;
+        if (n <= 0 || output_pending(s)) break;
+    }
+    return 0;
+}
+
+/**
+ * Starts a session for a new connection in a worker: a fresh game greeted with
+ * the command list.
+ */
+static void open_session(worker *w, int fd) {
+    static const cookie_io_functions_t io = { NULL, session_write, NULL, NULL };
+    const game_rules *rules = &w->srv->rules;
+
+    session *s = xcalloc(1, sizeof(session));
+    s->fd = fd;
+    s->timer_fd = -1;
+    s->socket_source = (event_source){ SOURCE_SOCKET, s, NULL };
+    s->timer_source = (event_source){ SOURCE_TIMER, s, NULL };
+    s->shared_source = (event_source){ SOURCE_SHARED, s, NULL };
+    s->out = fopencookie(s, "w", io);
+    if (s->out == NULL) {
+        perror("fopencookie");
+        close(fd);
+        free(s);
+        return;
+    }
+
+    line_reader_init(&s->input, fd);
+    s->g = game_acquire(&w->games, s->out, true, rules);
+    fprintf(s->out, "Welcome to Jeopardy! Register with join [user] to play, or enter a shared game with game [id].\n");
+    game_help(s->g);
+
+    s->next = w->sessions;
+    if (s->next) s->next->prev = s;
+    w->sessions = s;
+
+    s->watched = EPOLLIN | EPOLLRDHUP;
+    int status = watch(w, fd, s->watched, &s->socket_source);
+
+    if (status == 0 && (rules->turn_timeout || rules->question_timeout)) {
+        s->timer_fd = deadline_timer();
+        status = s->timer_fd == -1 ? -1 : watch(w, s->timer_fd, EPOLLIN, &s->timer_source);
+    }
+
+    finish_event(w, s, status == 0 ? send_output(s) : -1);
+}
+
+// Accepts one pending connection; the listening socket stays ready while more are
+// waiting, so a burst of connections is spread over the workers.
+static void accept_session(worker *w) {
+    int fd = accept4(w->srv->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+            perror("accept");
+        }
+        return;
+    }
+    open_session(w, fd);
+}
+
+// Handles readiness of a session's socket: sends pending output, then reads and
+// processes input once nothing is left to send.
+static void socket_event(worker *w, session *s, uint32_t events) {
+    int status = events & EPOLLERR ? -1 : send_output(s);
+
+    if (status == 0 && !output_pending(s) && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+        status = read_input(w, s);
+    }
+    finish_event(w, s, status);
+}
+
+// Handles expiry of a session's timer: the game forfeits whatever ran out of time.
+static void timer_event(worker *w, session *s) {
+    consume(s->timer_fd);
+    s->armed = 0;
+    if (!s->closing) {
+        session_status(s, game_tick(s->g, monotonic_ns()));
+    }
+    finish_event(w, s, send_output(s));
+}
+
+// Moves every game of a worker onto a newer version of the question bank, if one
+// was published since the worker last looked.
+static void follow_bank(worker *w) {
+    question_bank old;
+    if (!bank_adopt(&w->reader, &old)) return;
+
+    for (session *s = w->sessions, *next; s != NULL; s = next) {
+        next = s->next; // The session may be closed if its game has nothing left to play
+        if (!s->closing && s->g != NULL) session_status(s, game_rebase(s->g, &old));
+        finish_event(w, s, send_output(s));
+    }
+    for (shared_game *sg = w->hosted, *next; sg != NULL; sg = next) {
+        next = sg->host_next; // The game may be retired
+        game_rebase(&sg->g, &old);
+        publish_shared(w, sg);
+    }
+    bank_release(&w->reader);
+}
+
+// Worker thread: runs its event loop until the server is stopped, then closes its sessions.
+static void *run_worker(void *arg) {
+    worker *w = arg;
+    struct epoll_event events[MAX_EVENTS];
+    bool running = true;
+
+    // The worker reads its own copy of the bank, so it registers from its own thread
+    if (bank_reader_register(&w->reader) != 0) return NULL;
+    if (watch(w, w->reader.wake_fd, EPOLLIN, &reload_source) == -1) {
+        perror("epoll_ctl");
+        bank_reader_unregister(&w->reader);
+        return NULL;
+    }
+
+    while (running) {
+        int n = epoll_wait(w->epoll_fd, events, MAX_EVENTS, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        follow_bank(w);
+
+        for (int i = 0; i < n && running; i++) {
+            event_source *source = events[i].data.ptr;
+            switch (source->kind) {
+            case SOURCE_STOP:
+                running = false; // Left signalled, so every worker sees it
+                break;
+            case SOURCE_RELOAD:
+                break; // Acknowledged by follow_bank
+            case SOURCE_LISTEN:
+                accept_session(w);
+                break;
+            case SOURCE_SOCKET:
+                if (!source->s->closed) socket_event(w, source->s, events[i].events);
+                break;
+            case SOURCE_TIMER:
+                if (!source->s->closed) timer_event(w, source->s);
+                break;
+            case SOURCE_SHARED:
+                if (!source->s->closed) shared_event(w, source->s);
+                break;
+            case SOURCE_HOST:
+                if (!source->sg->closed) host_event(w, source->sg);
+                break;
+            case SOURCE_HOST_TIMER:
+                if (!source->sg->closed) host_timer_event(w, source->sg);
+                break;
+            }
+        }
+        free_closed(w);
+    }
+
+    while (w->sessions != NULL) {
+        close_session(w, w->sessions);
+    }
+    free_closed(w);
+    game_pool_free(&w->games);
+    bank_reader_unregister(&w->reader);
+    return NULL;
+}
+
+/**
+ * Creates the listening socket at path, replacing a stale socket left there by
+ * an earlier server (but no other kind of file).
+ *
+ * @param path The path of the socket.
+ * @return The listening socket, or -1 on error.
+ */
+static int listen_socket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, LISTEN_BACKLOG) == -1) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Runs the server: listens on a Unix domain socket and hosts one game per
+ * connection on the current question bank, until SIGINT or SIGTERM.
+ *
+ * @param path The path of the socket.
+ * @param workers The number of worker threads.
+ * @param rules The rules every game is played by.
+ * @return The program exit status.
+ */
+int run_server(const char *path, int workers, const game_rules *rules) {
+    server srv;
+    memset(&srv, 0, sizeof(srv));
+    srv.rules = *rules;
+    pthread_mutex_init(&srv.games_lock, NULL);
+
+    srv.listen_fd = listen_socket(path);
+    if (srv.listen_fd == -1) return EXIT_FAILURE;
+
+    srv.stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (srv.stop_fd == -1) {
+        perror("eventfd");
+        close(srv.listen_fd);
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+
+    signal_fd = srv.stop_fd;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    fprintf(stderr, "Serving games on %s with %d workers\n", path, workers);
+
+    // Every worker watches the stop event, which is never consumed, and the
+    // listening socket, exclusively so a connection wakes only one of them.
+    worker *pool = xcalloc(workers, sizeof(worker));
+    int started = 0;
+    for (; started < workers; started++) {
+        worker *w = &pool[started];
+        w->srv = &srv;
+        w->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (w->epoll_fd == -1 || watch(w, srv.stop_fd, EPOLLIN, &stop_source) == -1 ||
+            watch(w, srv.listen_fd, EPOLLIN | EPOLLEXCLUSIVE, &listen_source) == -1 ||
+            pthread_create(&w->thread, NULL, run_worker, w) != 0) {
+            perror("worker");
+            if (w->epoll_fd != -1) close(w->epoll_fd);
+            break;
+        }
+    }
+    if (started == 0) {
+        fprintf(stderr, "Could not start any worker threads\n");
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(pool[i].thread, NULL);
+        close(pool[i].epoll_fd);
+    }
+    free(pool);
+
+    // Every session has left by now, but games are only retired by their hosts' events
+    while (srv.games != NULL) {
+        shared_game *sg = srv.games;
+        srv.games = sg->next;
+        close(sg->wake_fd);
+        close(sg->timer_fd);
+        free_shared(sg);
+    }
+    pthread_mutex_destroy(&srv.games_lock);
+
+    close(srv.listen_fd);
+    close(srv.stop_fd);
+    unlink(path);
+
+    fprintf(stderr, "Server stopped\n");
+    return started == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,19 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include "jeopardy.h"
+
+#define SERVER_WORKERS 4 // Default number of worker threads
+
+// Hosts games for clients connecting to a Unix domain socket at path, one game per
+// connection or one shared by the connections entering it by id, played by the
+// given rules, until SIGINT or SIGTERM; returns the program exit status
+extern int run_server(const char *path, int workers, const game_rules *rules);
+
+#endif /* SERVER_H_ */
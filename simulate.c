@@ -0,0 +1,563 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Monte Carlo game simulator for balancing boards and scoring rules. Bot players
+ * play complete games through the same engine as people do: they type pick
+ * commands and answers into game_line, so every game goes through the real
+ * pick, answer checking and scoring paths. A bot knows the answer to a question
+ * with the accuracy of its profile, which can differ per category.
+ *
+ * Games are spread over worker threads. Each worker starts with an even share
+ * of the games and takes them a chunk at a time; a worker that runs out steals
+ * half of the games another worker has left, so all workers finish together.
+ * Every game draws from its own random stream, seeded from the simulation seed
+ * and the game's number, which makes the results independent of the number of
+ * workers and of how the games were scheduled. Each worker keeps its own
+ * statistics, merged once at the end.
+ *
+ * Final scores are counted in units of the gcd of the question values, which
+ * every score is a multiple of, in an HDR-style histogram mirrored for negative
+ * scores: exact up to 128 units, then within 1/64. Its size is fixed, whatever
+ * the values of the bank add up to.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "simulate.h"  // Include the simulation structures and prototypes.
+#include "reload.h"    // Each worker holds its own copy of the bank.
+#include "util.h"      // Allocation helpers and the monotonic clock.
+
+#define SIM_CHUNK 16       // Games a worker takes from its share at a time
+#define SIM_BLUFF 0.1      // Chance a bot buzzes in without knowing the answer
+#define SIM_REACTION 1000000 // Bots buzz within this many nanoseconds, in random order
+#define SCORE_BITS 6       // Histogram buckets per power of two of a score: 1 << SCORE_BITS
+#define SCORE_NEGATIVE HDR_BUCKETS(32, SCORE_BITS) // Buckets of negative scores, lowest first; then the rest
+#define SCORE_BUCKETS (2 * SCORE_NEGATIVE)
+
+// Statistics of the games played by one worker, merged at the end
+typedef struct {
+    long games;
+    long wins[MAX_BOTS];       // Games won outright
+    long ties[MAX_BOTS];       // Games shared with other winners
+    double sum[MAX_BOTS];      // Sum of final scores
+    double sum_sq[MAX_BOTS];   // Sum of squared final scores
+    int min[MAX_BOTS];
+    int max[MAX_BOTS];
+    long *histogram;           // Final scores per bot, SCORE_BUCKETS counters each
+} sim_stats;
+
+// What every worker reads: the simulation and what was derived from the bank
+typedef struct {
+    const simulation *sim;
+    game_rules rules;          // The simulation's rules without time limits
+    char names[MAX_BOTS][16];  // Bot player names
+    int *pickable;             // Questions a bot can pick by name
+    int num_pickable;
+    int64_t total;             // Sum of the pickable question values, which bounds every score
+    int width;                 // Unit of the score histogram, the gcd of the values
+} sim_shared;
+
+// A simulation worker thread and the games it has left
+typedef struct sim_worker {
+    pthread_t thread;
+    int index;
+    const sim_shared *shared;
+    struct sim_worker *all;    // Every worker, for stealing
+    pthread_mutex_t lock;      // Guards next and end
+    long next;                 // Games [next, end) are still to be played by this worker
+    long end;
+    uint64_t rng[4];           // Random stream of the current game
+    int *candidates;           // Questions not yet picked in the current game
+    sim_stats stats;
+} sim_worker;
+
+// Steps a splitmix64 generator, used to seed the per-game streams.
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15u);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Returns the next number of a xoshiro256** stream.
+static uint64_t next_random(uint64_t s[4]) {
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// Returns true with probability p.
+static bool chance(uint64_t s[4], double p) {
+    return (next_random(s) >> 11) * 0x1.0p-53 < p;
+}
+
+// Returns the accuracy of a bot in a category.
+static double bot_accuracy(const bot_profile *bot, int category) {
+    return bot->category_accuracy ? bot->category_accuracy[category] : bot->accuracy;
+}
+
+// Parses an accuracy between 0 and 1; returns -1 if it is not one.
+static double parse_accuracy(const char *s, char **end) {
+    double accuracy = strtod(s, end);
+    return *end == s || accuracy < 0 || accuracy > 1 ? -1 : accuracy;
+}
+
+/**
+ * Parses a bot profile: an accuracy, optionally followed by a colon and a
+ * comma-separated list of category=accuracy overrides, e.g.
+ * "0.6:databases=0.9,algorithms=0.3". Accuracies lie between 0 and 1.
+ *
+ * @param spec The profile.
+ * @param bot Receives the profile; release it with free_bot_profile.
+ * @return 0 on success, or -1 after reporting what is wrong with the profile.
+ */
+int parse_bot_profile(const char *spec, bot_profile *bot) {
+    char *end;
+    bot->category_accuracy = NULL;
+    bot->accuracy = parse_accuracy(spec, &end);
+    if (bot->accuracy < 0 || (*end != '\0' && *end != ':')) {
+        fprintf(stderr, "Invalid bot profile \"%s\": expected an accuracy between 0 and 1\n", spec);
+        return -1;
+    }
+    if (*end == '\0') return 0;
+
+    bot->category_accuracy = xmalloc(bank.num_categories * sizeof(double));
+    for (uint32_t c = 0; c < bank.num_categories; c++) {
+        bot->category_accuracy[c] = bot->accuracy;
+    }
+
+    const char *p = end + 1;
+    while (*p != '\0') {
+        const char *equals = strchr(p, '=');
+        if (equals == NULL) break;
+
+        char name[MAX_LEN];
+        size_t len = (size_t)(equals - p) < sizeof(name) - 1 ? (size_t)(equals - p) : sizeof(name) - 1;
+        memcpy(name, p, len);
+        name[len] = '\0';
+
+        int category = find_category(name);
+        double accuracy = parse_accuracy(equals + 1, &end);
+        if (category == -1 || accuracy < 0 || (*end != '\0' && *end != ',')) {
+            fprintf(stderr, "Invalid bot profile \"%s\": bad category accuracy \"%s\"\n", spec, p);
+            free_bot_profile(bot);
+            return -1;
+        }
+
+        bot->category_accuracy[category] = accuracy;
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    if (*p != '\0') {
+        fprintf(stderr, "Invalid bot profile \"%s\": expected category=accuracy\n", spec);
+        free_bot_profile(bot);
+        return -1;
+    }
+    return 0;
+}
+
+// Releases the per-category accuracies of a bot profile.
+void free_bot_profile(bot_profile *bot) {
+    free(bot->category_accuracy);
+    bot->category_accuracy = NULL;
+}
+
+// Types an answer to the open question for the player whose turn it is.
+static void bot_answer(game *g, int q, bool knows) {
+    char line[MAX_LEN * 2];
+    snprintf(line, sizeof(line), "what is %s", knows ? question_answer(q) : "-");
+    game_line(g, line);
+}
+
+/**
+ * Plays a buzzer round on the open question: the bots that know the answer (and
+ * a few that do not) buzz in after a random reaction time, each gets an answer
+ * window in buzz order, and the rest pass.
+ *
+ * @return The bot who picks next: whoever answered correctly, else the picker.
+ */
+static int play_buzzer(sim_worker *w, game *g, int q, int picker) {
+    const sim_shared *shared = w->shared;
+    int num_bots = shared->sim->num_bots;
+    int category = bank.questions[q].category;
+    bool knows[MAX_BOTS], buzzed[MAX_BOTS];
+
+    for (int b = 0; b < num_bots; b++) {
+        knows[b] = chance(w->rng, bot_accuracy(&shared->sim->bots[b], category));
+        buzzed[b] = knows[b] || chance(w->rng, SIM_BLUFF);
+        if (buzzed[b]) game_buzz(g, b, 1 + next_random(w->rng) % SIM_REACTION);
+    }
+    game_poll(g);
+
+    int next_pass = 0;
+    while (g->pending_question == q) {
+        if (g->pending_player != -1) {
+            int p = g->pending_player;
+            bot_answer(g, q, knows[p]);
+            if (knows[p]) return p;
+            continue;
+        }
+
+        // Nobody is left in line: the bots that stayed out pass.
+        while (next_pass < num_bots && buzzed[next_pass]) next_pass++;
+        if (next_pass == num_bots) break;
+
+        char line[MAX_LEN];
+        snprintf(line, sizeof(line), "pass %s", shared->names[next_pass++]);
+        game_line(g, line);
+    }
+    return picker;
+}
+
+// Returns the histogram bucket of a final score.
+static int score_bucket(const sim_shared *shared, int score) {
+    int64_t units = score / shared->width;
+    if (units >= 0) return SCORE_NEGATIVE + hdr_bucket(units, SCORE_BITS);
+    return SCORE_NEGATIVE - 1 - hdr_bucket(-units, SCORE_BITS);
+}
+
+// Returns the highest score that falls in a histogram bucket.
+static int64_t bucket_score(const sim_shared *shared, int bucket) {
+    if (bucket >= SCORE_NEGATIVE) {
+        return (int64_t)hdr_bucket_limit(bucket - SCORE_NEGATIVE, SCORE_BITS) * shared->width;
+    }
+
+    int magnitude = SCORE_NEGATIVE - 1 - bucket;
+    return -(int64_t)(hdr_bucket_limit(magnitude - 1, SCORE_BITS) + 1) * shared->width;
+}
+
+// Records the final scores of a game.
+static void record_game(sim_worker *w, const game *g) {
+    const sim_shared *shared = w->shared;
+    int num_bots = shared->sim->num_bots;
+    sim_stats *s = &w->stats;
+    int best = g->players.players[0].score, winners = 0;
+
+    for (int b = 1; b < num_bots; b++) {
+        if (g->players.players[b].score > best) best = g->players.players[b].score;
+    }
+    for (int b = 0; b < num_bots; b++) {
+        winners += g->players.players[b].score == best;
+    }
+
+    for (int b = 0; b < num_bots; b++) {
+        int score = g->players.players[b].score;
+        if (score == best) {
+            if (winners == 1) s->wins[b]++;
+            else s->ties[b]++;
+        }
+        s->sum[b] += score;
+        s->sum_sq[b] += (double)score * score;
+        if (s->games == 0 || score < s->min[b]) s->min[b] = score;
+        if (s->games == 0 || score > s->max[b]) s->max[b] = score;
+        s->histogram[b * SCORE_BUCKETS + score_bucket(shared, score)]++;
+    }
+    s->games++;
+}
+
+/**
+ * Plays one complete game. The bot in control picks a random question left on
+ * the board; without buzzers the picker answers it and keeps control only when
+ * right, with buzzers control goes to whoever answers correctly.
+ *
+ * @param w The worker.
+ * @param g The worker's game, reset for this game.
+ * @param index The number of the game, which seeds its random stream.
+ */
+static void play_game(sim_worker *w, game *g, long index) {
+    const sim_shared *shared = w->shared;
+    const simulation *sim = shared->sim;
+    char line[MAX_LEN * 2];
+
+    uint64_t seed = sim->seed ^ ((uint64_t)index * 0xd1342543de82ef95u);
+    for (int i = 0; i < 4; i++) w->rng[i] = splitmix64(&seed);
+
+    game_reset(g);
+    for (int b = 0; b < sim->num_bots; b++) {
+        game_join(g, shared->names[b]);
+    }
+
+    int left = shared->num_pickable;
+    memcpy(w->candidates, shared->pickable, left * sizeof(int));
+    int picker = next_random(w->rng) % sim->num_bots;
+
+    while (g->status == GAME_RUNNING && left > 0) {
+        int i = next_random(w->rng) % left;
+        int q = w->candidates[i];
+        w->candidates[i] = w->candidates[--left];
+
+        const question *picked = &bank.questions[q];
+        snprintf(line, sizeof(line), "pick %s %d %s", category_name(picked->category), picked->value,
+                 shared->names[picker]);
+        game_line(g, line);
+        if (g->pending_question != q) continue;
+
+        if (sim->rules.buzzer) {
+            picker = play_buzzer(w, g, q, picker);
+        } else {
+            bool knows = chance(w->rng, bot_accuracy(&sim->bots[picker], picked->category));
+            bot_answer(g, q, knows);
+            if (!knows) picker = (picker + 1) % sim->num_bots;
+        }
+    }
+
+    record_game(w, g);
+}
+
+/**
+ * Takes the next chunk of games for a worker: from its own share while it lasts,
+ * then by stealing the later half of the games another worker has left.
+ *
+ * @return true with [*first, *last) set, or false once no games are left anywhere.
+ */
+static bool take_games(sim_worker *w, long *first, long *last) {
+    int workers = w->shared->sim->workers;
+
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        if (w->next < w->end) {
+            *first = w->next;
+            *last = w->next + SIM_CHUNK < w->end ? w->next + SIM_CHUNK : w->end;
+            w->next = *last;
+            pthread_mutex_unlock(&w->lock);
+            return true;
+        }
+        pthread_mutex_unlock(&w->lock);
+
+        // Steal from the next worker with games left.
+        bool stole = false;
+        for (int k = 1; k < workers && !stole; k++) {
+            sim_worker *victim = &w->all[(w->index + k) % workers];
+            long start = 0, end = 0;
+
+            pthread_mutex_lock(&victim->lock);
+            long available = victim->end - victim->next;
+            if (available > 0) {
+                end = victim->end;
+                start = victim->end -= (available + 1) / 2;
+                stole = true;
+            }
+            pthread_mutex_unlock(&victim->lock);
+
+            if (stole) {
+                pthread_mutex_lock(&w->lock);
+                w->next = start;
+                w->end = end;
+                pthread_mutex_unlock(&w->lock);
+            }
+        }
+        if (!stole) return false;
+    }
+}
+
+// Worker thread: plays games until none are left.
+static void *sim_thread(void *arg) {
+    sim_worker *w = arg;
+    bank_reader reader;
+    long first, last;
+    game g;
+
+    // Every thread reads its own copy of the bank; simulations never reload it
+    if (bank_reader_register(&reader) != 0) return NULL;
+
+    game_init(&g, NULL, false, &w->shared->rules);
+    while (take_games(w, &first, &last)) {
+        for (long i = first; i < last; i++) {
+            play_game(w, &g, i);
+        }
+    }
+    game_free(&g);
+    bank_reader_unregister(&reader);
+    return NULL;
+}
+
+static int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Returns the score below which the given fraction of a bot's games ended, to
+// the precision of its bucket but within the bot's lowest and highest scores.
+static int percentile(const sim_shared *shared, const long *histogram, long games, double fraction, int min,
+                      int max) {
+    long target = (long)ceil(fraction * games), seen = 0;
+    int64_t score = max;
+    for (int i = 0; i < SCORE_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen >= target && seen > 0) {
+            score = bucket_score(shared, i);
+            break;
+        }
+    }
+    return score < min ? min : score > max ? max : score;
+}
+
+/**
+ * Prints the merged statistics: per bot the share of games won outright and
+ * tied, the mean and spread of its final score and the percentiles of the score
+ * distribution.
+ */
+static void print_results(FILE *out, const sim_shared *shared, const sim_stats *s, double elapsed) {
+    const simulation *sim = shared->sim;
+
+    fprintf(out, "Simulated %ld games with %d bots on %d workers in %.2f s (%.0f games/s)\n", s->games,
+            sim->num_bots, sim->workers, elapsed, elapsed > 0 ? s->games / elapsed : 0.0);
+    fprintf(out, "%-6s %9s %7s %7s %9s %9s %7s %7s %7s %7s %7s %7s %7s\n", "Bot", "Accuracy", "Wins", "Ties",
+            "Mean", "StdDev", "Min", "P10", "P25", "P50", "P75", "P90", "Max");
+
+    for (int b = 0; b < sim->num_bots; b++) {
+        double mean = s->sum[b] / s->games;
+        double variance = s->sum_sq[b] / s->games - mean * mean;
+        const long *histogram = s->histogram + b * SCORE_BUCKETS;
+        int min = s->min[b], max = s->max[b];
+
+        fprintf(out, "%-6s %8.2f%c %6.2f%% %6.2f%% %9.1f %9.1f %7d %7d %7d %7d %7d %7d %7d\n", shared->names[b],
+                sim->bots[b].accuracy, sim->bots[b].category_accuracy ? '*' : ' ',
+                100.0 * s->wins[b] / s->games, 100.0 * s->ties[b] / s->games, mean,
+                sqrt(variance > 0 ? variance : 0), min,
+                percentile(shared, histogram, s->games, 0.10, min, max),
+                percentile(shared, histogram, s->games, 0.25, min, max),
+                percentile(shared, histogram, s->games, 0.50, min, max),
+                percentile(shared, histogram, s->games, 0.75, min, max),
+                percentile(shared, histogram, s->games, 0.90, min, max), max);
+    }
+    if (shared->num_pickable < (int)bank.num_questions) {
+        fprintf(out, "%d questions with spaces in their category were left off the board.\n",
+                (int)bank.num_questions - shared->num_pickable);
+    }
+}
+
+// Adds a worker's statistics to the totals.
+static void merge_stats(sim_stats *total, const sim_stats *s, int num_bots) {
+    for (int b = 0; b < num_bots; b++) {
+        if (s->games == 0) break;
+        if (total->games == 0 || s->min[b] < total->min[b]) total->min[b] = s->min[b];
+        if (total->games == 0 || s->max[b] > total->max[b]) total->max[b] = s->max[b];
+        total->wins[b] += s->wins[b];
+        total->ties[b] += s->ties[b];
+        total->sum[b] += s->sum[b];
+        total->sum_sq[b] += s->sum_sq[b];
+    }
+    for (int i = 0; i < num_bots * SCORE_BUCKETS; i++) {
+        total->histogram[i] += s->histogram[i];
+    }
+    total->games += s->games;
+}
+
+/**
+ * Runs a simulation: plays the games on the worker threads, then merges and
+ * prints their statistics.
+ *
+ * @param sim The simulation.
+ * @param out Where the results are printed.
+ * @return 0 on success, or -1 if the games could not be played.
+ */
+int run_simulation(const simulation *sim, FILE *out) {
+    sim_shared shared;
+    memset(&shared, 0, sizeof(shared));
+    shared.sim = sim;
+    shared.rules = sim->rules;
+    shared.rules.turn_timeout = shared.rules.question_timeout = 0;
+
+    // Questions are picked by typing their category, so it must be a single word.
+    shared.pickable = xmalloc((bank.num_questions ? bank.num_questions : 1) * sizeof(int));
+    for (uint32_t q = 0; q < bank.num_questions; q++) {
+        const char *name = category_name(bank.questions[q].category);
+        bool single_word = name[0] != '\0';
+        for (const char *c = name; *c && single_word; c++) {
+            single_word = !isspace((unsigned char)*c);
+        }
+        if (!single_word || bank.questions[q].value <= 0) continue;
+
+        shared.pickable[shared.num_pickable++] = q;
+        shared.total += bank.questions[q].value;
+        shared.width = gcd(bank.questions[q].value, shared.width);
+    }
+    if (shared.num_pickable == 0) {
+        fprintf(stderr, "No question of the bank can be picked by the bots\n");
+        free(shared.pickable);
+        return -1;
+    }
+    if (shared.total > INT_MAX) {
+        fprintf(stderr, "The question values add up to more than a score can hold\n");
+        free(shared.pickable);
+        return -1;
+    }
+    for (int b = 0; b < sim->num_bots; b++) {
+        snprintf(shared.names[b], sizeof(shared.names[b]), "bot%d", b + 1);
+    }
+
+    sim_worker *workers = xcalloc(sim->workers, sizeof(sim_worker));
+    for (int i = 0; i < sim->workers; i++) {
+        sim_worker *w = &workers[i];
+        w->index = i;
+        w->shared = &shared;
+        w->all = workers;
+        w->next = sim->games * i / sim->workers;
+        w->end = sim->games * (i + 1) / sim->workers;
+        w->candidates = xmalloc(shared.num_pickable * sizeof(int));
+        w->stats.histogram = xcalloc((size_t)sim->num_bots * SCORE_BUCKETS, sizeof(long));
+        pthread_mutex_init(&w->lock, NULL);
+    }
+
+    uint64_t start = monotonic_ns();
+    int started = 0;
+    for (; started < sim->workers; started++) {
+        if (pthread_create(&workers[started].thread, NULL, sim_thread, &workers[started]) != 0) {
+            perror("pthread_create");
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    double elapsed = (monotonic_ns() - start) / 1e9;
+
+    // A worker that failed to start left its games to be stolen; none can be lost.
+    int status = started > 0 ? 0 : -1;
+    if (status == 0) {
+        sim_stats total;
+        memset(&total, 0, sizeof(total));
+        total.histogram = xcalloc((size_t)sim->num_bots * SCORE_BUCKETS, sizeof(long));
+        for (int i = 0; i < sim->workers; i++) {
+            merge_stats(&total, &workers[i].stats, sim->num_bots);
+        }
+        print_results(out, &shared, &total, elapsed);
+        free(total.histogram);
+    }
+
+    for (int i = 0; i < sim->workers; i++) {
+        pthread_mutex_destroy(&workers[i].lock);
+        free(workers[i].candidates);
+        free(workers[i].stats.histogram);
+    }
+    free(workers);
+    free(shared.pickable);
+    return status;
+}
@@ -0,0 +1,46 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef SIMULATE_H_
+#define SIMULATE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "jeopardy.h"
+
+#define MAX_BOTS 16         // Bots in a simulated game
+#define SIM_BOTS 4          // Bots playing when no profiles are given
+#define SIM_ACCURACY 0.5    // Accuracy of the default bots
+
+// How well a bot plays: the chance it knows the answer to a question
+typedef struct {
+    double accuracy;           // Chance of knowing an answer in any category
+    double *category_accuracy; // Chance per category id, overriding accuracy; NULL if none differ
+} bot_profile;
+
+// A batch of simulated games
+typedef struct {
+    long games;                // Games to play
+    int workers;               // Threads to play them on
+    uint64_t seed;             // Seed of the random choices; the same seed gives the same results
+    game_rules rules;          // Rules the games are played by; time limits are ignored
+    bot_profile bots[MAX_BOTS];
+    int num_bots;
+} simulation;
+
+// Parses a bot profile such as "0.7" or "0.6:databases=0.9,algorithms=0.3"
+// against the loaded bank; returns 0, or -1 after reporting a malformed profile
+extern int parse_bot_profile(const char *spec, bot_profile *bot);
+
+// Releases the memory held by a bot profile
+extern void free_bot_profile(bot_profile *bot);
+
+// Plays the simulated games across the workers and prints score and win-rate
+// distributions to out; returns 0, or -1 if the games could not be run
+extern int run_simulation(const simulation *sim, FILE *out);
+
+#endif /* SIMULATE_H_ */
@@ -0,0 +1,91 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Spectator display for a game published with jeopardy -p. Maps the game's
+ * shared-memory scoreboard read-only and redraws the scores and the board
+ * whenever they change, until the game ends. Polling the scoreboard is a memory
+ * read, so any number of spectators can watch without slowing the game down.
+ *
+ * Usage: spectate [-i milliseconds] [-1] <scoreboard>
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "jeopardy.h"   // The game status values.
+#include "scoreboard.h" // Reads the published scoreboard.
+
+#define POLL_INTERVAL 100 // Default milliseconds between polls
+
+// Prints the published state of a game.
+static void show(const scoreboard_data *d) {
+    printf("Scores (%u players)\n", d->total_players);
+    for (uint32_t i = 0; i < d->num_players; i++) {
+        const scoreboard_player *p = &d->players[i];
+        printf("%3d. %-*s $%d%s\n", p->rank, SCOREBOARD_NAME, p->name, p->score,
+               (int32_t)i == d->pending_player ? "  <- answering" : "");
+    }
+
+    printf("\nBoard (%u of %u questions left)\n", d->questions_remaining, d->num_questions);
+    for (uint32_t c = 0; c < d->num_categories; c++) {
+        printf("  %-*s %d left\n", SCOREBOARD_NAME, d->categories[c].name, d->categories[c].remaining);
+    }
+
+    if (d->status == GAME_OVER) {
+        printf("\nThe game is over.\n");
+    } else if (d->status == GAME_EXIT) {
+        printf("\nThe game was stopped.\n");
+    } else if (d->pending_question != -1 && (uint32_t)d->pending_category < d->num_categories) {
+        printf("\nNow playing: %s for $%d\n", d->categories[d->pending_category].name, d->pending_value);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long interval = POLL_INTERVAL;
+    bool once = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:1")) != -1) {
+        if (opt == 'i' && atol(optarg) > 0) {
+            interval = atol(optarg);
+        } else if (opt == '1') {
+            once = true;
+        } else {
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Usage: %s [-i milliseconds] [-1] <scoreboard>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const scoreboard *sb = scoreboard_attach(argv[optind]);
+    if (sb == NULL) return EXIT_FAILURE;
+
+    struct timespec pause = { interval / 1000, interval % 1000 * 1000000 };
+    scoreboard_data d;
+    uint64_t shown = UINT64_MAX;
+
+    // Redraw whenever the game publishes an update, until it ends.
+    for (;;) {
+        if (scoreboard_read(sb, &d) && d.updates != shown) {
+            if (!once) printf("\033[H\033[2J"); // Clear the screen
+            show(&d);
+            fflush(stdout);
+            shown = d.updates;
+            if (once || d.status != GAME_RUNNING) break;
+        }
+        nanosleep(&pause, NULL);
+    }
+
+    scoreboard_close(sb, NULL);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Latency instrumentation. The game times its hot paths (command dispatch,
+ * question lookup, answer checking, output and search) with the monotonic clock and
+ * records each time in a histogram, and counts answers, invalid commands and
+ * timeouts.
+ *
+ * Every thread records into its own block of histograms and counters, created
+ * the first time it records and pushed onto a lock-free list. Only the owning
+ * thread writes a block, so recording is two clock reads and a few relaxed
+ * atomic stores with no locking or contention; readers (the stats command and
+ * the dump thread) merge the blocks of all threads as they go.
+ *
+ * The histograms are HDR-style: each power of two is split into 16 buckets, so
+ * any recorded time is known within 1/16 (6.25%) from a nanosecond to minutes
+ * in a fixed 592 buckets.
+ *
+ * Building with NO_STATS defined (make STATS=0) compiles all of it out.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "stats.h" // Include the statistics prototypes.
+#include "util.h"  // Allocation helpers and the monotonic clock.
+
+#ifndef NO_STATS
+
+#define SUB_BUCKET_BITS 4                    // Buckets per power of two: 1 << SUB_BUCKET_BITS
+#define MAX_MAGNITUDE 40                     // Times are capped at 2^40 ns (about 18 minutes)
+#define BUCKETS HDR_BUCKETS(MAX_MAGNITUDE, SUB_BUCKET_BITS)
+
+// Latency histogram of one operation in one thread
+typedef struct {
+    atomic_uint_least64_t counts[BUCKETS];
+    atomic_uint_least64_t total;  // Sum of the recorded times
+    atomic_uint_least64_t max;    // Longest recorded time
+} histogram;
+
+// The histograms and counters of one thread
+typedef struct stats_block {
+    histogram timers[STAT_TIMERS];
+    atomic_uint_least64_t counters[STAT_COUNTERS];
+    struct stats_block *next;
+} stats_block;
+
+static const char *timer_names[STAT_TIMERS] = { "command", "lookup", "answer", "render", "search" };
+static const char *counter_names[STAT_COUNTERS] = { "correct", "incorrect", "invalid", "timeout" };
+
+static _Atomic(stats_block *) blocks;       // Every thread's block
+static _Thread_local stats_block *local;    // The calling thread's block
+
+// Returns the calling thread's block, creating and publishing it on first use.
+static stats_block *thread_block(void) {
+    if (local == NULL) {
+        local = xcalloc(1, sizeof(stats_block));
+        stats_block *head = atomic_load_explicit(&blocks, memory_order_relaxed);
+        do {
+            local->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&blocks, &head, local, memory_order_release,
+                                                        memory_order_relaxed));
+    }
+    return local;
+}
+
+// Adds to a value only the calling thread writes; readers may load it at any time.
+static void bump(atomic_uint_least64_t *value, uint64_t n) {
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+// Returns the bucket of a time: exact below 32 ns, then 16 buckets per power of two.
+static int bucket_of(uint64_t ns) {
+    if (ns >= (uint64_t)1 << MAX_MAGNITUDE) ns = ((uint64_t)1 << MAX_MAGNITUDE) - 1;
+    return hdr_bucket(ns, SUB_BUCKET_BITS);
+}
+
+// Returns the largest time that falls in a bucket.
+static uint64_t bucket_limit(int bucket) {
+    return hdr_bucket_limit(bucket, SUB_BUCKET_BITS);
+}
+
+/**
+ * Records how long an operation took in the calling thread's histogram.
+ *
+ * @param timer The operation.
+ * @param start When it started, from stats_now.
+ */
+void stats_record(stat_timer timer, uint64_t start) {
+    uint64_t ns = monotonic_ns() - start;
+    histogram *h = &thread_block()->timers[timer];
+
+    bump(&h->counts[bucket_of(ns)], 1);
+    bump(&h->total, ns);
+    if (ns > atomic_load_explicit(&h->max, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max, ns, memory_order_relaxed);
+    }
+}
+
+// Counts an event in the calling thread's counters.
+void stats_count(stat_counter counter) {
+    bump(&thread_block()->counters[counter], 1);
+}
+
+// Returns the time below which the given fraction of the recorded times fall,
+// to the bucket's precision but never above the longest time recorded.
+static unsigned long long percentile(const uint64_t *counts, uint64_t n, uint64_t max, double fraction) {
+    uint64_t target = (uint64_t)(fraction * n + 0.5), seen = 0;
+    if (target == 0) target = 1;
+
+    int b = 0;
+    while (b < BUCKETS - 1 && (seen += counts[b]) < target) b++;
+    return bucket_limit(b) < max ? bucket_limit(b) : max;
+}
+
+/**
+ * Prints the counters, then for each operation how often it ran and its mean,
+ * median, tail and longest time, merged over every thread's block.
+ *
+ * @param out Where to print.
+ */
+void stats_print(FILE *out) {
+    uint64_t counters[STAT_COUNTERS] = { 0 };
+    stats_block *head = atomic_load_explicit(&blocks, memory_order_acquire);
+
+    for (stats_block *b = head; b != NULL; b = b->next) {
+        for (int c = 0; c < STAT_COUNTERS; c++) {
+            counters[c] += atomic_load_explicit(&b->counters[c], memory_order_relaxed);
+        }
+    }
+    fprintf(out, "Counters:");
+    for (int c = 0; c < STAT_COUNTERS; c++) {
+        fprintf(out, " %s %llu", counter_names[c], (unsigned long long)counters[c]);
+    }
+    fprintf(out, "\n%-8s %10s %10s %10s %10s %10s %10s %10s\n", "Latency", "count", "mean ns", "p50",
+            "p90", "p99", "p99.9", "max");
+
+    for (int t = 0; t < STAT_TIMERS; t++) {
+        uint64_t counts[BUCKETS] = { 0 };
+        uint64_t n = 0, total = 0, max = 0;
+
+        for (stats_block *b = head; b != NULL; b = b->next) {
+            const histogram *h = &b->timers[t];
+            for (int i = 0; i < BUCKETS; i++) {
+                uint64_t count = atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+                counts[i] += count;
+                n += count;
+            }
+            total += atomic_load_explicit(&h->total, memory_order_relaxed);
+            uint64_t m = atomic_load_explicit(&h->max, memory_order_relaxed);
+            if (m > max) max = m;
+        }
+
+        if (n == 0) {
+            fprintf(out, "%-8s %10d\n", timer_names[t], 0);
+            continue;
+        }
+        fprintf(out, "%-8s %10llu %10.0f %10llu %10llu %10llu %10llu %10llu\n", timer_names[t],
+                (unsigned long long)n, (double)total / n, percentile(counts, n, max, 0.5),
+                percentile(counts, n, max, 0.9), percentile(counts, n, max, 0.99), percentile(counts, n, max, 0.999),
+                (unsigned long long)max);
+    }
+}
+
+// State of the dump thread
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    char *path;
+    int interval;
+    bool running;
+    bool stopping;
+} dump = { .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER };
+
+// Rewrites the dump file: written beside it, then renamed over it, so readers never see half a dump.
+static void write_dump(void) {
+    size_t len = strlen(dump.path);
+    char *tmp_path = xmalloc(len + 5);
+    memcpy(tmp_path, dump.path, len);
+    memcpy(tmp_path + len, ".tmp", 5);
+
+    FILE *fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        perror(tmp_path);
+    } else {
+        stats_print(fp);
+        if (fclose(fp) != 0 || rename(tmp_path, dump.path) != 0) perror(dump.path);
+    }
+    free(tmp_path);
+}
+
+// Dump thread: writes the statistics every interval until stopped, and once more at the end.
+static void *dump_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&dump.lock);
+    while (!dump.stopping) {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += dump.interval;
+        while (!dump.stopping && pthread_cond_timedwait(&dump.wake, &dump.lock, &until) == 0) {
+        }
+
+        pthread_mutex_unlock(&dump.lock);
+        write_dump();
+        pthread_mutex_lock(&dump.lock);
+    }
+    pthread_mutex_unlock(&dump.lock);
+    return NULL;
+}
+
+/**
+ * Starts dumping the statistics to a file periodically.
+ *
+ * @param path The file, replaced with every dump.
+ * @param interval Seconds between dumps.
+ * @return 0 on success or -1 if the dump thread could not be started.
+ */
+int stats_dump_start(const char *path, int interval) {
+    dump.path = strdup(path);
+    dump.interval = interval > 0 ? interval : STATS_DUMP_INTERVAL;
+    dump.stopping = false;
+    if (dump.path == NULL || pthread_create(&dump.thread, NULL, dump_thread, NULL) != 0) {
+        fprintf(stderr, "%s: could not start the statistics dump\n", path);
+        free(dump.path);
+        return -1;
+    }
+    dump.running = true;
+    return 0;
+}
+
+// Stops the dump thread after a final dump.
+void stats_dump_stop(void) {
+    if (!dump.running) return;
+
+    pthread_mutex_lock(&dump.lock);
+    dump.stopping = true;
+    pthread_cond_signal(&dump.wake);
+    pthread_mutex_unlock(&dump.lock);
+
+    pthread_join(dump.thread, NULL);
+    free(dump.path);
+    dump.running = false;
+}
+
+#else
+
+// Statistics are compiled out: explain instead.
+void stats_print(FILE *out) {
+    fprintf(out, "Statistics are not compiled into this build.\n");
+}
+
+int stats_dump_start(const char *path, int interval) {
+    (void)interval;
+    fprintf(stderr, "%s: statistics are not compiled into this build\n", path);
+    return -1;
+}
+
+void stats_dump_stop(void) {
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "util.h"
+
+#define STATS_DUMP_INTERVAL 10 // Default seconds between dumps of the statistics to a file
+
+// Timed operations, each with its own latency histogram
+typedef enum {
+    STAT_COMMAND,          // A line through game_line: command dispatch or an answer
+    STAT_LOOKUP,           // Resolving a picked category and value to a question
+    STAT_ANSWER,           // Checking an answer
+    STAT_RENDER,           // Printing the board, a question, scores or results
+    STAT_SEARCH,           // Answering a search query from the index
+    STAT_TIMERS
+} stat_timer;
+
+// Counted events
+typedef enum {
+    STAT_CORRECT,          // Correct answers
+    STAT_INCORRECT,        // Incorrect answers
+    STAT_INVALID,          // Lines that were not a valid command
+    STAT_TIMEOUT,          // Turns and questions forfeited on time
+    STAT_COUNTERS
+} stat_counter;
+
+#ifdef NO_STATS
+
+// Statistics are compiled out: nothing is timed or counted
+#define stats_now() ((uint64_t)0)
+#define stats_record(timer, start) ((void)(start))
+#define stats_count(counter) ((void)0)
+
+#else
+
+// Starts timing an operation; pass the result to stats_record
+#define stats_now() monotonic_ns()
+
+// Records the time since start in the calling thread's histogram of an operation
+extern void stats_record(stat_timer timer, uint64_t start);
+
+// Counts an event in the calling thread's counters
+extern void stats_count(stat_counter counter);
+
+#endif
+
+// Prints the counters and the latency percentiles of every operation, merged
+// across threads
+extern void stats_print(FILE *out);
+
+// Starts a thread that rewrites the statistics to a file every interval
+// seconds; returns 0, or -1 if it could not be started
+extern int stats_dump_start(const char *path, int interval);
+
+// Stops the dump thread, writing the file one last time
+extern void stats_dump_stop(void);
+
+#endif /* STATS_H_ */
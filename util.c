@@ -0,0 +1,73 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ *
+ * Small helpers shared by the game modules: allocation wrappers that abort the
+ * game when memory runs out, the string hash used by the lookup tables, and the
+ * monotonic clock that buzzes and deadlines are measured with.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "util.h" // Include the prototypes of the shared helpers.
+
+void *xmalloc(size_t size) {
+    void *p = malloc(size);
+    if (p == NULL) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+void *xcalloc(size_t count, size_t size) {
+    void *p = calloc(count, size);
+    if (p == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+void *xrealloc(void *p, size_t size) {
+    p = realloc(p, size);
+    if (p == NULL) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+uint32_t hash_string(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+int hdr_bucket(uint64_t value, int bits) {
+    if (value < (uint64_t)2 << bits) return value;
+
+    int shift = 63 - __builtin_clzll(value) - bits;
+    return (shift << bits) + (int)(value >> shift);
+}
+
+uint64_t hdr_bucket_limit(int bucket, int bits) {
+    if (bucket < 2 << bits) return bucket;
+
+    int shift = (bucket >> bits) - 1;
+    return ((uint64_t)(bucket - (shift << bits)) << shift) + ((uint64_t)1 << shift) - 1;
+}
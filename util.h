@@ -0,0 +1,39 @@
+/*
+ * Tutorial 4 Jeopardy Project for SOFE 3950U / CSCI 3020U: Operating Systems
+ *
+ * Copyright (C) 2024, Okiki Ojo, Justin Fisher, Inder Singh
+ * All rights reserved.
+ */
+#ifndef UTIL_H_
+#define UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocates memory, exiting the program if there is none left
+extern void *xmalloc(size_t size);
+
+// Allocates zeroed memory, exiting the program if there is none left
+extern void *xcalloc(size_t count, size_t size);
+
+// Resizes an allocation, exiting the program if there is no memory left
+extern void *xrealloc(void *p, size_t size);
+
+// FNV-1a hash of a string of the given length
+extern uint32_t hash_string(const char *s, size_t len);
+
+// Current time of the monotonic clock in nanoseconds
+extern uint64_t monotonic_ns(void);
+
+// Buckets of an HDR-style histogram with 1 << bits buckets per power of two
+// that holds every value below 2^magnitude
+#define HDR_BUCKETS(magnitude, bits) (((magnitude) - (bits) + 1) << (bits))
+
+// Returns the bucket of a value in an HDR-style histogram: exact below
+// 2 << bits, then within one part in 1 << bits
+extern int hdr_bucket(uint64_t value, int bits);
+
+// Returns the largest value that falls in a bucket of an HDR-style histogram
+extern uint64_t hdr_bucket_limit(int bucket, int bits);
+
+#endif /* UTIL_H_ */